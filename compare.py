@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+
+# Copyright (c) Facebook, Inc. and its affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+import argparse
+try:
+    import hanabi_lib
+except ImportError:
+    # built with TorchBot, hanabi_lib links libtorch, which torch loads
+    import torch
+    import hanabi_lib
+
+"""
+A/B evaluation of bot lineups on shared decks (see compareLineups in
+csrc/Comparison.h): game g of every lineup is dealt the same deck, and each
+lineup is reported as its score minus the first lineup's, game by game, with
+a confidence interval. Play stops once every interval excludes zero, e.g.
+
+    python compare.py SmartBot,SearchBot SmartBot,SearchBot --set 1:SEARCH_N=1000
+
+compares SearchBot at the SEARCH_N of the environment with SEARCH_N=1000.
+SearchBot searches only in the SEARCH_PLAYER seat (the last by default) and
+plays the other seats as BPBOT, so lineups that seat it elsewhere are refused.
+"""
+
+
+def set_param(params, assignment):
+    name, value = assignment.split('=', 1)
+    for group in (params.hanabi, params.search, params.joint, params.torch):
+        if hasattr(group, name):
+            setattr(group, name, type(getattr(group, name))(value))
+            return
+    raise ValueError(f"Unknown parameter {name}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='A/B comparison of bot lineups')
+    parser.add_argument('lineups', nargs='+',
+                        help="comma-separated bots, one per seat; the first lineup is the baseline")
+    parser.add_argument('--max_games', type=int, default=10000)
+    parser.add_argument('--batch_games', type=int, default=100, help="games between stopping checks")
+    parser.add_argument('--min_games', type=int, default=100)
+    parser.add_argument('--confidence', type=float, default=0.95)
+    parser.add_argument('--no_early_stop', action='store_true',
+                        help="play max_games even once every interval excludes zero")
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--set', action='append', default=[], metavar='LINEUP:NAME=VALUE',
+                        help="override a parameter of one lineup, e.g. 1:SEARCH_N=1000")
+    parser.add_argument('--json', default='', help="write the lineups' means and differences to this file")
+    parser.add_argument('--fiber_threads', type=int, default=-1,
+                        help="size of the thread pool the lineups run on; -1 means FIBER_THREADS")
+
+    opt = parser.parse_args()
+    lineups = [lineup.split(',') for lineup in opt.lineups]
+    params = []
+    if opt.set:
+        params = [hanabi_lib.RunParams() for _ in lineups]
+        for assignment in opt.set:
+            lineup, assignment = assignment.split(':', 1)
+            set_param(params[int(lineup)], assignment)
+    pool = hanabi_lib.ThreadPool(threads=opt.fiber_threads) if opt.fiber_threads > 0 else None
+    result = hanabi_lib.compare_lineups(
+        lineups,
+        max_games=opt.max_games,
+        batch_games=opt.batch_games,
+        min_games=opt.min_games,
+        confidence=opt.confidence,
+        early_stop=not opt.no_early_stop,
+        seed=opt.seed,
+        pool=pool,
+        params=params
+    )
+    if pool:
+        pool.close()
+    print(result.table())
+    print(f"{len(lineups)} lineups in {result.seconds:.1f} s.")
+    if opt.json:
+        with open(opt.json, 'w') as f:
+            f.write(result.to_json() + "\n")
@@ -16,19 +16,37 @@
 using namespace std::chrono;
 
 #include "Batcher.h"
+#include "InferenceStats.h"
 
 class AsyncModelWrapper {
  public:
+  /* maxDelayUs: once the first request of a batch has arrived, wait up to this
+   * long for the batch to fill before running the model (0 = run as soon as
+   * any requests are ready).
+   * intraOpThreads: torch threads used by the forward thread (0 = torch default);
+   * independent of the fiber pool that produces the requests. */
   AsyncModelWrapper(const std::string& path,
                     const std::string& device,
-                    int batchsize)
-      : model_(torch::jit::load(path, torch::Device(device)))
+                    int batchsize,
+                    int maxDelayUs = 0,
+                    int intraOpThreads = 0)
+      : path_(path)
+      , deviceName_(device)
+      , model_(torch::jit::load(path, torch::Device(device)))
       , device_(torch::Device(device))
-      , batcher_(batchsize)
+      , batcher_(batchsize, microseconds(maxDelayUs))
+      , batchSize_(batchsize)
+      , maxDelayUs_(maxDelayUs)
+      , intraOpThreads_(intraOpThreads)
+      , created_(steady_clock::now())
   {
     forwardThread_ = std::thread(&AsyncModelWrapper::batchForward, this);
   }
 
+  const std::string &path() const {
+    return path_;
+  }
+
   TensorDict forward(TensorDict input) {
     int slot = -1;
     auto reply = batcher_.send(input, &slot);
@@ -36,23 +54,32 @@ class AsyncModelWrapper {
     return output;
   }
 
+  /* Zero-copy forward: fill(inputs) writes the request directly into its slot
+   * of the batch slab (see Batcher::reserve), and the outputs are views into
+   * the batch output. */
+  template <class Fill>
+  TensorDict forward(const InputShapes& shapes, Fill&& fill) {
+    int slot = -1;
+    TensorDict inputs;
+    auto reply = batcher_.reserve(shapes, &slot, &inputs);
+    try {
+      fill(inputs);
+    } catch (...) {
+      // the slot is still part of the batch; leave it with whatever was written
+      batcher_.commit();
+      throw;
+    }
+    batcher_.commit();
+    return reply->get(slot);
+  }
+
   void batchForward() {
     torch::NoGradGuard noGrad;
-    int i = 0;
+    if (intraOpThreads_ > 0) {
+      at::set_num_threads(intraOpThreads_);
+    }
     while (true) {
-      i += 1;
-      int B = 1000;
-      int P = 1000000;
-      if (i % B == 0) {
-        if (i % P == 0) std::cerr << "avg time (over " << B << " runs): " << std::endl;
-        for (auto& kv : timer_) {
-          if (i % P == 0) std::cerr << kv.first << ", " << kv.second / B << std::endl;
-          timer_[kv.first] = 0;
-        }
-        if (i % P == 0) std::cerr << "===================" << std::endl;
-      }
-
-      auto start = high_resolution_clock::now();
+      auto start = steady_clock::now();
 
       TensorDict input;
       try {
@@ -60,38 +87,40 @@ class AsyncModelWrapper {
       } catch (ExitThread &e) {
         break;
       }
-      timer_["batch_size"] += input["s"].size(0);
+      long batchSize = input["s"].size(0);
+      auto waitDone = steady_clock::now();
 
-      auto stop = high_resolution_clock::now();
-      auto duration = duration_cast<microseconds>(stop - start).count();
-      timer_["wait_for_batch"] += duration;
-
-      start = high_resolution_clock::now();
       std::vector<torch::jit::IValue> jitInput;
       jitInput.push_back(tensorDictToTorchDict(input, device_));
-
-      stop = high_resolution_clock::now();
-      duration = duration_cast<microseconds>(stop - start).count();
-      timer_["to_device"] += duration;
-
-      start = high_resolution_clock::now();
-      auto jitOutput = model_.forward(jitInput);;
+      auto jitOutput = model_.forward(jitInput);
       auto output = iValueToTensorDict(jitOutput, torch::kCPU, true);
+      auto forwardDone = steady_clock::now();
 
-      stop = high_resolution_clock::now();
-      duration = duration_cast<microseconds>(stop - start).count();
-      timer_["forward"] += duration;
+      batcher_.set(std::move(output));
 
-      // stop = high_resolution_clock::now();
-      // duration = duration_cast<microseconds>(stop - start).count();
-      // timer_["forward"] += duration;
+      std::lock_guard<std::mutex> lk(mStats_);
+      stats_.batches++;
+      stats_.inferences += batchSize;
+      stats_.waitSecs += duration<double>(waitDone - start).count();
+      stats_.forwardSecs += duration<double>(forwardDone - waitDone).count();
+    }
+  }
 
-      start = high_resolution_clock::now();
-      batcher_.set(std::move(output));
-      stop = high_resolution_clock::now();
-      duration = duration_cast<microseconds>(stop - start).count();
-      timer_["post_process"] += duration;
+  InferenceStats stats() const {
+    std::lock_guard<std::mutex> lk(mStats_);
+    InferenceStats stats = stats_;
+    stats.device = deviceName_;
+    stats.batchSize = batchSize_;
+    stats.maxDelayUs = maxDelayUs_;
+    stats.intraOpThreads = intraOpThreads_;
+    if (stats.batches > 0) {
+      stats.meanBatchFill = double(stats.inferences) / (double(stats.batches) * batchSize_);
+    }
+    double elapsed = duration<double>(steady_clock::now() - created_).count();
+    if (elapsed > 0) {
+      stats.inferencesPerSec = stats.inferences / elapsed;
     }
+    return stats;
   }
 
   ~AsyncModelWrapper() {
@@ -105,11 +134,18 @@ class AsyncModelWrapper {
 
 
  private:
+  std::string path_;
+  std::string deviceName_;
   torch::jit::script::Module model_;
   torch::Device device_;
 
   Batcher batcher_;
+  const int batchSize_;
+  const int maxDelayUs_;
+  const int intraOpThreads_;
   std::thread forwardThread_;
 
-  std::unordered_map<std::string, float> timer_;
+  const steady_clock::time_point created_;
+  mutable std::mutex mStats_;
+  InferenceStats stats_;
 };
@@ -11,6 +11,8 @@
 
 #include <torch/script.h> // One-stop header.
 
+#include <chrono>
+
 
 // utils for convert dict[str, tensor] <-> ivalue
 using TensorDict = std::unordered_map<std::string, torch::Tensor>;
@@ -54,13 +56,13 @@ class FutureReply {
     cvReady_.wait(lk, [this] { return ready_; });
     lk.unlock();
 
+    // views into the batch output, no copy
     TensorDict e;
     for (const auto& kv : data_) {
       assert(slot >= 0 && slot < kv.second.size(0));
-      e[kv.first] = kv.second[slot];
+      e[kv.first] = kv.second.select(0, slot);
     }
     return e;
-    // return data_[slot];
   }
 
   void set(TensorDict&& t) {
@@ -85,30 +87,40 @@ class FutureReply {
 
 class ExitThread: public std::exception {};
 
+/* Shapes of the per-request inputs (without the batch dimension), by key. */
+using InputShapes = std::vector<std::pair<std::string, std::vector<int64_t>>>;
+
+/* Requests are written in place into a preallocated input slab of
+ * batchsize rows per key. There are two slabs: while the model runs on one,
+ * callers fill the other, so get() can hand out the filled rows as a view
+ * instead of copying them. */
 class Batcher {
  public:
-  Batcher(int batchsize)
+  Batcher(int batchsize, std::chrono::microseconds maxDelay = std::chrono::microseconds(0))
    : batchsize_(batchsize)
+   , maxDelay_(maxDelay)
    , nextSlot_(0)
    , numActiveWrite_(0)
-   // , buffer_(torch::zeros({batchsize, dim}))
    , currentReply_(nullptr)
    , nextReply_(std::make_shared<FutureReply>()){
   }
 
-  // send data into batcher
-  std::shared_ptr<FutureReply> send(const TensorDict& t, int* slot) {
+  /* Reserve a slot in the current input slab. *inputs receives (float32)
+   * views of the slot, which the caller must fill and then release with
+   * commit(). The first call allocates the slabs, so all calls must pass the
+   * same shapes. */
+  std::shared_ptr<FutureReply> reserve(const InputShapes& shapes, int* slot, TensorDict* inputs) {
     std::unique_lock<std::mutex> lk(mNextSlot_);
 
-    // init buffer
-    if (buffer_.empty()) {
-      for (const auto& kv : t) {
-        auto t = kv.second.sizes();
-        std::vector<int64_t> sizes;
-        sizes.push_back(batchsize_);
-        sizes.insert(sizes.end(), t.begin(), t.end());
-
-        buffer_[kv.first] = torch::zeros(sizes, kv.second.dtype());
+    // init buffers
+    if (buffers_[0].empty()) {
+      for (auto& buffer : buffers_) {
+        for (const auto& kv : shapes) {
+          std::vector<int64_t> sizes;
+          sizes.push_back(batchsize_);
+          sizes.insert(sizes.end(), kv.second.begin(), kv.second.end());
+          buffer[kv.first] = torch::zeros(sizes);
+        }
       }
     }
 
@@ -119,38 +131,65 @@ class Batcher {
     *slot = nextSlot_;
     ++nextSlot_;
     ++numActiveWrite_;
-    lk.unlock();
-
-    // this will copy
-    for (const auto& kv : t) {
-      buffer_[kv.first][*slot] = kv.second;
+    inputs->clear();
+    for (const auto& kv : buffers_[active_]) {
+      (*inputs)[kv.first] = kv.second.select(0, *slot);
     }
 
     // batch has not been extracted yet
-    assert(numActiveWrite_ > 0);
     assert(nextReply_ != nullptr);
-    auto reply = nextReply_;
-    lk.lock();
+    return nextReply_;
+  }
+
+  /* Mark a slot returned by reserve() as filled. */
+  void commit() {
+    std::unique_lock<std::mutex> lk(mNextSlot_);
+    assert(numActiveWrite_ > 0);
     --numActiveWrite_;
+    bool notify = numActiveWrite_ == 0;
     lk.unlock();
-    if (numActiveWrite_ == 0) {
+    if (notify) {
       cvGetBatch_.notify_one();
     }
+  }
+
+  // send data into batcher
+  std::shared_ptr<FutureReply> send(const TensorDict& t, int* slot) {
+    InputShapes shapes;
+    for (const auto& kv : t) {
+      shapes.emplace_back(kv.first, kv.second.sizes().vec());
+    }
+    TensorDict inputs;
+    auto reply = reserve(shapes, slot, &inputs);
+    for (const auto& kv : t) {
+      inputs[kv.first].copy_(kv.second);
+    }
+    commit();
     return reply;
   }
 
-  // get batch input from batcher
+  /* Get batch input from batcher: views of the filled rows of the current
+   * slab, valid until the next call to get(). */
   TensorDict get() {
     std::unique_lock<std::mutex> lk(mNextSlot_);
     cvGetBatch_.wait(lk, [this] { return nextSlot_ > 0 && numActiveWrite_ == 0 || exit_; });
+    if (maxDelay_.count() > 0) {
+      // give the batch a chance to fill up, then wait for in-flight writes
+      auto deadline = std::chrono::steady_clock::now() + maxDelay_;
+      cvGetBatch_.wait_until(lk, deadline, [this] {
+        return nextSlot_ == batchsize_ && numActiveWrite_ == 0 || exit_;
+      });
+      cvGetBatch_.wait(lk, [this] { return numActiveWrite_ == 0 || exit_; });
+    }
     if (exit_) {
       throw ExitThread();
     }
     TensorDict batch;
-    for (const auto& kv : buffer_) {
-      batch[kv.first] = kv.second.narrow_copy(0, 0, nextSlot_).contiguous();
+    for (const auto& kv : buffers_[active_]) {
+      batch[kv.first] = kv.second.narrow(0, 0, nextSlot_);
     }
-    // auto batch = buffer_.narrow_copy(0, 0, nextSlot_);
+    // the other slab was consumed by the previous batch, which is done
+    active_ = 1 - active_;
 
     // assert currentReply has been handled
     assert(currentReply_ == nullptr);
@@ -181,12 +220,14 @@ class Batcher {
 
  private:
   const int batchsize_;
+  const std::chrono::microseconds maxDelay_;
 
   int nextSlot_;
   int numActiveWrite_;
   boost::fibers::condition_variable_any cvNextSlot_;
 
-  TensorDict buffer_;
+  TensorDict buffers_[2];
+  int active_ = 0;
 
   std::shared_ptr<FutureReply> currentReply_;
   std::shared_ptr<FutureReply> nextReply_;
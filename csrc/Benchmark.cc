@@ -0,0 +1,370 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "Benchmark.h"
+#include "SearchBot.h"
+#ifdef TORCHBOT
+#include "Batcher.h"
+#endif
+
+using namespace Hanabi;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+BenchResult makeResult(const std::string &name, const std::string &unit) {
+  BenchResult result;
+  result.name = name;
+  result.unit = unit;
+  return result;
+}
+
+/* Plays a seeded game of botname with copies of itself up to turn. The
+ * caller deletes the bots. */
+std::vector<Bot*> playToTurn(Server &server, const std::string &botname, int players, int turn, int seed) {
+  auto botFactory = getBotFactory(botname);
+  server.setLog(nullptr);
+  server.sqa(0);
+  server.srand(seed);
+  std::vector<Bot*> bots;
+  for (int i = 0; i < players; ++i) {
+    bots.push_back(botFactory->create(i, players, server.handSize(players)));
+  }
+  server.startGame(bots, std::vector<Card>());
+  server.runToTurn(turn);
+  return bots;
+}
+
+/* A SearchBot that, at its first move from benchTurn on, benchmarks its
+ * search and belief filters on its range as it stands, then makes the
+ * blueprint move. */
+class SearchBench final : public SearchBot {
+public:
+  SearchBench(int index, int numPlayers, int handSize, int benchTurn, int reps)
+    : SearchBot(index, numPlayers, handSize), benchTurn_(benchTurn), reps_(reps) {}
+
+  void pleaseMakeMove(Server &server) override {
+    if (!results_.empty() || server.turn() < benchTurn_) {
+      return SearchBot::pleaseMakeMove(server);
+    }
+    simulserver_.sync(server);
+    Move bp_move = simulserver_.simulatePlayerMove(me_, players_[me_].get());
+    applyDelayedObservations(hand_distribution_, copyKeys(hand_distribution_), params_);
+    this->benchRollouts_(server, bp_move);
+    this->benchHintFilter_(server);
+    this->benchActionFilter_(server);
+    for (auto &result : results_) {
+      result.info["range"] = hand_distribution_.size();
+      result.info["turn"] = server.turn();
+    }
+    execute_(me_, bp_move, server);
+  }
+
+  const std::vector<BenchResult> &results() const { return results_; }
+
+private:
+  void benchRollouts_(const Server &server, Move bp_move) {
+    BenchResult result = makeResult("search/rollouts", "rollouts");
+    HandDistCDF cdf = populateHandDistCDF(hand_distribution_);
+    SearchStats stats;
+    const int before = total_iters_;
+    auto start = Clock::now();
+    doSearch_(me_, bp_move, Move(), players_[me_].get(), hand_distribution_, cdf, stats, gen_, server, false);
+    result.seconds = secondsSince(start);
+    result.count = total_iters_ - before;
+    result.info["search_n"] = params_.search.SEARCH_N;
+    results_.push_back(result);
+  }
+
+  void benchHintFilter_(const Server &server) {
+    /* a color hint on my first card, so that my true hand stays in range */
+    BenchResult result = makeResult("search/hint_filter", "hands");
+    const Hand trueHand = server.cheatGetHand(me_);
+    const Move hint(HINT_COLOR, trueHand[0].color, me_);
+    CardIndices indices;
+    for (int i = 0; i < trueHand.size(); ++i) {
+      if (trueHand[i].color == trueHand[0].color) indices.add(i);
+    }
+    const int from = (me_ + 1) % server.numPlayers();
+    for (int r = 0; r < reps_; ++r) {
+      HandDist handDist = hand_distribution_;
+      auto start = Clock::now();
+      filterBeliefsConsistentWithHint_(from, hint, indices, server, handDist);
+      result.seconds += secondsSince(start);
+      result.count += hand_distribution_.size();
+    }
+    results_.push_back(result);
+  }
+
+  void benchActionFilter_(const Server &server) {
+    /* what the next player would do knowing my true hand, so that my true
+     * hand stays in range */
+    BenchResult result = makeResult("search/action_filter", "hands");
+    const int from = (me_ + 1) % server.numPlayers();
+    const Hand trueHand = server.cheatGetHand(me_);
+    SimulServer cheatServer(simulserver_);
+    cheatServer.setHand(me_, trueHand);
+    const Move move = cheatServer.simulatePlayerMove(from, hand_distribution_[trueHand].getPartner(from).get());
+    const HandDist range = hand_distribution_;
+    for (int r = 0; r < reps_; ++r) {
+      auto start = Clock::now();
+      filterBeliefsConsistentWithAction_(move, from, server);
+      result.seconds += secondsSince(start);
+      result.count += range.size();
+      hand_distribution_ = range;
+    }
+    results_.push_back(result);
+  }
+
+  int benchTurn_;
+  int reps_;
+  std::vector<BenchResult> results_;
+};
+
+void appendJsonString(std::ostringstream &out, const std::string &s) {
+  out << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if ((unsigned char)c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof buf, "\\u%04x", c);
+      out << buf;
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+}  // namespace
+
+BenchResult benchmarkGames(const std::string &botname, int games, int players, int seed) {
+  BenchResult result = makeResult("selfplay/" + botname, "games");
+  Server server;
+  server.setLog(nullptr);
+  server.sqa(0);
+  server.srand(seed);
+  auto botFactory = getBotFactory(botname);
+  long totalScore = 0;
+  auto start = Clock::now();
+  for (int g = 0; g < games; ++g) {
+    totalScore += server.runGame(*botFactory, players);
+  }
+  result.seconds = secondsSince(start);
+  result.count = games;
+  result.info["mean_score"] = double(totalScore) / games;
+  result.info["players"] = players;
+  return result;
+}
+
+BenchResult benchmarkClone(const std::string &botname, int clones, int games, int players, int seed, bool keep) {
+  BenchResult result = makeResult(std::string(keep ? "clone_keep/" : "clone/") + botname, "clones");
+  Server server;
+  server.setLog(nullptr);
+  server.sqa(0);
+  server.srand(seed);
+  auto botFactory = getBotFactory(botname);
+  for (int g = 0; g < games && result.skipped.empty(); ++g) {
+    std::vector<Bot*> bots;
+    for (int i = 0; i < players; ++i) {
+      bots.push_back(botFactory->create(i, players, server.handSize(players)));
+    }
+    server.runGame(bots, std::vector<Card>());
+
+    std::vector<Bot*> copies(clones);
+    try {
+      auto start = Clock::now();
+      for (int i = 0; i < clones; ++i) {
+        copies[i] = bots[i % players]->clone();
+        if (!keep) {
+          delete copies[i];
+          copies[i] = nullptr;
+        }
+      }
+      result.seconds += secondsSince(start);
+      result.count += clones;
+    } catch (const std::runtime_error &e) {
+      result.skipped = std::string("clone(): ") + e.what();
+    }
+
+    for (auto bot : copies) {
+      delete bot;
+    }
+    for (auto bot : bots) {
+      botFactory->destroy(bot);
+    }
+  }
+  result.info["players"] = players;
+  return result;
+}
+
+BenchResult benchmarkSync(const std::string &botname, int syncs, int players, int turn, int seed) {
+  BenchResult result = makeResult("simulserver_sync/" + botname, "syncs");
+  Server server;
+  std::vector<Bot*> bots = playToTurn(server, botname, players, turn, seed);
+  SimulServer simulserver(players);
+  auto start = Clock::now();
+  for (int i = 0; i < syncs; ++i) {
+    simulserver.sync(server);
+  }
+  result.seconds = secondsSince(start);
+  result.count = syncs;
+  result.info["turn"] = server.turn();
+  auto botFactory = getBotFactory(botname);
+  for (auto bot : bots) {
+    botFactory->destroy(bot);
+  }
+  return result;
+}
+
+std::vector<BenchResult> benchmarkSearch(int players, int turn, int reps, int seed) {
+  RunParams params = RunParams::current();
+  /* the search splits SEARCH_N over up to NUM_THREADS rollout fibers,
+   * rounding down, so it would run no rollout at all below that */
+  if (params.search.SEARCH_N < params.hanabi.NUM_THREADS) {
+    std::cerr << "search/rollouts: SEARCH_N " << params.search.SEARCH_N << " is below NUM_THREADS "
+              << params.hanabi.NUM_THREADS << ", raised to it" << std::endl;
+    params.search.SEARCH_N = params.hanabi.NUM_THREADS;
+  }
+  RunParamsScope scope(&params);
+  Server server;
+  server.setLog(nullptr);
+  server.sqa(0);
+  server.srand(seed);
+  const int handSize = server.handSize(players);
+  const int searchPlayer = players - 1;
+  auto bpFactory = getBotFactory(params.search.BPBOT);
+  std::vector<std::shared_ptr<Bot> > owned;
+  std::vector<Bot*> bots;
+  SearchBench *bench = nullptr;
+  for (int i = 0; i < players; ++i) {
+    if (i == searchPlayer) {
+      bench = new SearchBench(i, players, handSize, turn, reps);
+      owned.emplace_back(bench);
+    } else {
+      owned.emplace_back(bpFactory->create(i, players, handSize), [bpFactory](Bot *bot) { bpFactory->destroy(bot); });
+      owned.back()->setPermissive(true);
+    }
+    bots.push_back(owned.back().get());
+  }
+  server.startGame(bots, std::vector<Card>());
+  while (bench->results().empty() && !server.gameOver()) {
+    server.runToTurn(server.turn() + 1);
+  }
+  if (bench->results().empty()) {
+    BenchResult result = makeResult("search", "");
+    result.skipped = "the game ended before turn " + std::to_string(turn);
+    return {result};
+  }
+  std::vector<BenchResult> results = bench->results();
+  for (auto &result : results) {
+    result.info["hand_size"] = handSize;
+    result.info["players"] = players;
+  }
+  return results;
+}
+
+BenchResult benchmarkBatcher(int requests, int producers, int batchSize) {
+  BenchResult result = makeResult("batcher", "requests");
+#ifdef TORCHBOT
+  /* a TorchBot request: one HleSerializedMove-sized input, one output */
+  const InputShapes shapes = {{"s", {838}}};
+  Batcher batcher(batchSize);
+  long batches = 0;
+  std::thread model([&]() {
+    while (true) {
+      TensorDict input;
+      try {
+        input = batcher.get();
+      } catch (ExitThread &e) {
+        break;
+      }
+      TensorDict output;
+      output["a"] = input["s"].sum(1);
+      batcher.set(std::move(output));
+      ++batches;
+    }
+  });
+
+  auto start = Clock::now();
+  std::vector<boost::fibers::future<void>> futures;
+  for (int p = 0; p < producers; ++p) {
+    futures.push_back(getThreadPool().enqueue([&]() {
+      for (int i = 0; i < requests; ++i) {
+        int slot;
+        TensorDict inputs;
+        auto reply = batcher.reserve(shapes, &slot, &inputs);
+        inputs["s"].fill_(1);
+        batcher.commit();
+        reply->get(slot);
+      }
+    }));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+  result.seconds = secondsSince(start);
+  result.count = long(requests) * producers;
+
+  {
+    std::unique_lock<std::mutex> lock(batcher.mNextSlot_);
+    batcher.exit_ = true;
+  }
+  batcher.cvGetBatch_.notify_all();
+  model.join();
+  result.info["batch_size"] = batchSize;
+  result.info["producers"] = producers;
+  result.info["mean_batch_fill"] = batches ? double(result.count) / (double(batches) * batchSize) : 0;
+#else
+  result.skipped = "built without TORCHBOT";
+#endif
+  return result;
+}
+
+std::string benchResultsToJson(const std::vector<BenchResult> &results) {
+  std::ostringstream out;
+  out.precision(10);
+  out << "{\"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchResult &result = results[i];
+    out << (i ? ",\n  " : "\n  ") << "{\"name\": ";
+    appendJsonString(out, result.name);
+    out << ", \"unit\": ";
+    appendJsonString(out, result.unit);
+    if (!result.skipped.empty()) {
+      out << ", \"skipped\": ";
+      appendJsonString(out, result.skipped);
+    } else {
+      out << ", \"count\": " << result.count
+          << ", \"seconds\": " << result.seconds
+          << ", \"rate\": " << result.rate();
+    }
+    out << ", \"info\": {";
+    const char *sep = "";
+    for (const auto &kv : result.info) {
+      out << sep;
+      appendJsonString(out, kv.first);
+      out << ": " << kv.second;
+      sep = ", ";
+    }
+    out << "}}";
+  }
+  out << "\n]}\n";
+  return out.str();
+}
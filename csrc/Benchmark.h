@@ -0,0 +1,57 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+/* One measurement of the benchmark suite: count items (games, clones,
+ * rollouts, ...) handled in seconds, timing only the code under test. */
+struct BenchResult {
+  std::string name;      // e.g. "selfplay/SmartBot"
+  std::string unit;      // what count counts, e.g. "games"
+  long count = 0;
+  double seconds = 0;
+  /* context for the numbers, e.g. the mean score or the size of the range */
+  std::map<std::string, double> info;
+  /* if not empty, why the benchmark did not run */
+  std::string skipped;
+
+  double rate() const { return seconds > 0 ? count / seconds : 0; }
+};
+
+/* Self-play games per second of botname with copies of itself, without
+ * logging; info["mean_score"] makes sure a speedup did not change play. */
+BenchResult benchmarkGames(const std::string &botname, int games, int players, int seed);
+
+/* Bot::clone() calls per second on the bots at the end of each of games
+ * games. Search clones its blueprint for every rollout (each clone is
+ * short-lived) and for every hand in the range (keep=true: all clones stay
+ * alive). Skipped for bots that do not implement clone(). */
+BenchResult benchmarkClone(const std::string &botname, int clones, int games, int players, int seed, bool keep);
+
+/* SimulServer::sync() calls per second from a game of botname stopped at
+ * the given turn; search syncs before every observation. */
+BenchResult benchmarkSync(const std::string &botname, int syncs, int players, int turn, int seed);
+
+/* SearchBot, with the parameters of RunParams::current() (SEARCH_N raised
+ * to NUM_THREADS if below it), playing with its blueprint: at its first
+ * move from the given turn on, measures over its range (the same range for
+ * a given seed) rollouts per second of one search, and hands per second of
+ * reps hint filters and reps action filters. */
+std::vector<BenchResult> benchmarkSearch(int players, int turn, int reps, int seed);
+
+/* Batcher requests per second with `producers` fibers each making
+ * `requests` TorchBot-sized requests, answered by a trivial model. Skipped
+ * unless built with TORCHBOT. */
+BenchResult benchmarkBatcher(int requests, int producers, int batchSize);
+
+/* {"benchmarks": [{"name": ..., "unit": ..., "count": ..., "seconds": ...,
+ * "rate": ..., "info": {...}}, ...]}, with "skipped" instead of the numbers
+ * for benchmarks that did not run. */
+std::string benchResultsToJson(const std::vector<BenchResult> &results);
@@ -4,6 +4,7 @@
 #include "Hanabi.h"
 #include "BotFactory.h"
 #include "BlindBot.h"
+#include "CardMask.h"
 
 using namespace Hanabi;
 
@@ -36,3 +37,13 @@ std::map<std::string, std::string> BlindBot::handKnowledgeToMap() {
 void BlindBot::printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) {
 
 }
+
+void BlindBot::writeHandKnowledge(const Server &server, const HandKnowledgeTensor &out) const {
+    /* BlindBot keeps no knowledge: every card could be anything. */
+    const BoardMasks board = BoardMasks::compute(server);
+    for (int p = 0; p < server.numPlayers(); ++p) {
+        for (int i = 0; i < server.sizeOfHandOfPlayer(p); ++i) {
+            writeCardKnowledge(out, p, i, CardMask::all(), board);
+        }
+    }
+}
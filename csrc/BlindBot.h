@@ -12,4 +12,5 @@ struct BlindBot final : public Hanabi::Bot {
     void pleaseObserveAfterMove(const Hanabi::Server &) override;
     std::map<std::string, std::string> handKnowledgeToMap() override;
     void printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) override;
+    void writeHandKnowledge(const Hanabi::Server &server, const Hanabi::HandKnowledgeTensor &out) const override;
 };
@@ -0,0 +1,101 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "Hanabi.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Hanabi {
+
+/* Bot::saveState() appends through a StateWriter and Bot::restoreState()
+ * reads back through a StateReader. Values are stored as raw host bytes:
+ * the format is meant for checkpoints read back by the same build, not for
+ * exchange between machines. */
+class StateWriter {
+public:
+    explicit StateWriter(std::string &buf) : buf_(buf) {}
+
+    /* Names the class that wrote the state, so that restoring it into a
+     * different kind of bot fails loudly rather than misbehaving. */
+    void tag(const char *name) {
+        const uint8_t len = std::strlen(name);
+        pod(len);
+        buf_.append(name, len);
+    }
+
+    template<class T>
+    void pod(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data can be saved");
+        buf_.append(reinterpret_cast<const char *>(&value), sizeof value);
+    }
+
+    template<class T>
+    void vec(const std::vector<T> &values) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data can be saved");
+        pod(uint32_t(values.size()));
+        buf_.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    }
+
+private:
+    std::string &buf_;
+};
+
+class StateReader {
+public:
+    StateReader(const char *data, size_t size) : begin_(data), cur_(data), end_(data + size) {}
+
+    void tag(const char *name) {
+        uint8_t len;
+        pod(len);
+        need(len);
+        if (len != std::strlen(name) || std::memcmp(cur_, name, len) != 0) {
+            throw std::runtime_error("Cannot restore the state of a " + std::string(cur_, len) +
+                                     " into a " + name);
+        }
+        cur_ += len;
+    }
+
+    template<class T>
+    void pod(T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data can be restored");
+        need(sizeof value);
+        std::memcpy(&value, cur_, sizeof value);
+        cur_ += sizeof value;
+    }
+
+    template<class T>
+    void vec(std::vector<T> &values) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data can be restored");
+        uint32_t size;
+        pod(size);
+        need(size_t(size) * sizeof(T));
+        values.resize(size);
+        std::memcpy(values.data(), cur_, size * sizeof(T));
+        cur_ += size * sizeof(T);
+    }
+
+    /* How many bytes have been read so far. */
+    size_t consumed() const { return cur_ - begin_; }
+
+private:
+    void need(size_t bytes) const {
+        if (size_t(end_ - cur_) < bytes) {
+            throw std::runtime_error("Truncated bot state.");
+        }
+    }
+
+    const char *begin_;
+    const char *cur_;
+    const char *end_;
+};
+
+}  /* namespace Hanabi */
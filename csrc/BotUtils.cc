@@ -12,6 +12,8 @@
 #include <set>
 #include <algorithm>
 #include <atomic>
+#include <mutex>
+#include <cmath>
 #include <cstring>
 #include "Hanabi.h"
 #include <chrono>
@@ -24,7 +26,6 @@
 #include "BotUtils.h"
 
 using namespace Hanabi;
-using namespace HanabiParams;
 
 
 
@@ -216,17 +217,38 @@ Card indexToCard(int index) {
   return Card((Color) (index / 5), index % 5 + ONE);
 }
 
+namespace {
+
+// the color and links of a std::map node, before its value
+constexpr size_t MAP_NODE_OVERHEAD = 4 * sizeof(void *);
+
+std::atomic<long> interned_hands(0);
+std::atomic<size_t> interned_hand_bytes(0);
+
+}  // namespace
+
 BoxedHand::BoxedHand(const Hand &hand) {
+  // games on the thread pool box hands concurrently; the lock is never held
+  // across a fiber switch
+  static std::mutex mtx;
   static std::map<Hand, std::unique_ptr<Hand>> box;
+  std::lock_guard<std::mutex> lock(mtx);
   auto iter = box.find(hand);
   if (iter == box.end()) {
     pHand = new Hand(hand);
     box.emplace(hand, pHand); // owned by box!
+    interned_hands++;
+    // the map node (with a copy of the hand as key) and the boxed hand
+    interned_hand_bytes += MAP_NODE_OVERHEAD + sizeof(Hand) + sizeof(std::unique_ptr<Hand>)
+                           + sizeof(Hand) + 2 * hand.size() * sizeof(Card);
   } else {
     pHand = iter->second.get();
   }
 }
 
+long BoxedHand::internedCount() { return interned_hands; }
+size_t BoxedHand::internedBytes() { return interned_hand_bytes; }
+
 
 ////////////////////////////////////////////////////////////////////////////////
 //////////////////////   FactorizedBeliefs   ///////////////////////////////////
@@ -396,6 +418,7 @@ void FactorizedBeliefs::log() {
      : Server()
      , mock_(false)
      , last_move_()
+     , searchLog_(RunParams::current().search.SEARCH_LOG)
  {
    numPlayers_ = numPlayers;
  }
@@ -404,6 +427,7 @@ void FactorizedBeliefs::log() {
       : Server()
       , mock_(false)
       , last_move_()
+      , searchLog_(RunParams::current().search.SEARCH_LOG)
   {
     numPlayers_ = server.numPlayers();
     sync(server);
@@ -430,6 +454,16 @@ void FactorizedBeliefs::log() {
    deck_ = deck;
  }
 
+ size_t SimulServer::memoryBytes() const {
+   size_t bytes = sizeof(*this);
+   bytes += (discards_.capacity() + deck_.capacity()) * sizeof(Card);
+   bytes += hints_.capacity() * sizeof(ServerHint);
+   for (const auto &hand : hands_) {
+     bytes += sizeof(hand) + hand.capacity() * sizeof(Card);
+   }
+   return bytes;
+ }
+
  void SimulServer::setObservingPlayer(int observingPlayer) {
    observingPlayer_ = observingPlayer;
  }
@@ -446,6 +480,7 @@ void FactorizedBeliefs::log() {
      activeCardIsObservable_ = false;
    }
    finalCountdown_ = s.finalCountdown();
+   params_ = s.params();
 
    for (int i = 0; i < NUMCOLORS; i++) {
      piles_[i] = s.pileOf((Color) i);
@@ -516,14 +551,15 @@ void FactorizedBeliefs::log() {
    if (update_me) {
      f(players_[me], *this);
    }
-   std::cerr << now() << "applyToAll begin : " << hand_distribution.size() << " hands." << std::endl;
+   if (searchLog_) std::cerr << now() << "applyToAll begin : " << hand_distribution.size() << " hands." << std::endl;
    auto hand_dist_keys = copyKeys(hand_distribution);
    std::vector<boost::fibers::future<void>> futures;
-   for (int t = 0; t < NUM_THREADS; t++) {
+   const int num_threads = params_.NUM_THREADS;
+   for (int t = 0; t < num_threads; t++) {
      futures.push_back(getThreadPool().enqueue([&, t]() {
        auto simulserver = std::make_shared<SimulServer>(*this);
        auto fp = std::make_shared<ObservationFunc>(f);
-       for (int i = t; i < hand_dist_keys.size(); i += NUM_THREADS) {
+       for (int i = t; i < hand_dist_keys.size(); i += num_threads) {
          auto &hand = hand_dist_keys[i];
          hand_distribution.at(hand).delayed_observations.emplace_back(
            simulserver, fp, me, hand
@@ -540,7 +576,7 @@ void FactorizedBeliefs::log() {
    for (auto &f: futures) {
      f.get();
    }
-   std::cerr << now() << "applyToAll end" << std::endl;
+   if (searchLog_) std::cerr << now() << "applyToAll end" << std::endl;
  }
 
 void HandDistVal::applyObservations() {
@@ -564,6 +600,188 @@ std::shared_ptr<Bot> HandDistVal::getPartner(int who) const {
   return bot;
 }
 
+MemoryReport measureRangeMemory(const HandDist &handDist) {
+  MemoryReport report;
+  report.handDistEntries = handDist.size();
+  report.handDistBytes = handDist.size() * (MAP_NODE_OVERHEAD + sizeof(HandDist::value_type));
+
+  // Partner bots and observation servers start out shared by every entry,
+  // and are copied as entries diverge: each holder counts 1/use_count of
+  // the object, so that their sum counts each object once.
+  const Bot *sample = nullptr;
+  double bots = 0, servers = 0, serverBytes = 0;
+  size_t botVecBytes = 0, thunkBytes = 0;
+  long thunks = 0;
+  for (const auto &kv : handDist) {
+    const HandDistVal &val = kv.second;
+    botVecBytes += val.partners.capacity() * sizeof(BotVec::value_type);
+    for (const auto &partner : val.partners) {
+      if (!partner) continue;
+      bots += 1. / partner.use_count();
+      if (!sample) sample = partner.get();
+    }
+    thunks += val.delayed_observations.size();
+    thunkBytes += val.delayed_observations.capacity() * sizeof(ObservationThunk);
+    for (const auto &obs : val.delayed_observations) {
+      const double share = 1. / obs.server.use_count();
+      servers += share;
+      serverBytes += share * obs.server->memoryBytes();
+    }
+  }
+  report.partnerBots = std::lround(bots);
+  report.partnerBotBytes = std::lround(bots * (sample ? sample->memoryBytes() : 0)) + botVecBytes;
+  report.delayedObservations = thunks;
+  report.delayedObsBytes = thunkBytes + std::lround(serverBytes + servers * sizeof(ObservationFunc));
+
+  report.internedHands = BoxedHand::internedCount();
+  report.internedHandBytes = BoxedHand::internedBytes();
+  report.rssBytes = currentRssBytes();
+  report.peakRssBytes = peakRssBytes();
+  return report;
+}
+
+std::vector<int> forkGames(const ServerSnapshot &snapshot, int branches,
+                           bool reshuffle, int seed, std::vector<std::string> *logs) {
+  std::vector<int> scores(branches);
+  if (logs) {
+    logs->assign(branches, std::string());
+  }
+  std::vector<boost::fibers::future<void>> futures;
+  for (int b = 0; b < branches; b++) {
+    futures.push_back(getThreadPool().enqueue([&, b]() {
+      std::ostringstream log;
+      Server server;
+      server.setLog(&log);
+      server.restore(snapshot);
+      if (reshuffle) {
+        server.srand(seed + b);
+        server.shuffleDeck();
+      }
+      scores[b] = server.runToCompletion();
+      if (logs) {
+        (*logs)[b] = log.str();
+      }
+    }));
+  }
+  for (auto &f: futures) {
+    f.get();
+  }
+  return scores;
+}
+
+namespace {
+
+/* Forwards to a bot that countDivergentCopies() swaps between turns. */
+class RelayBot final : public Bot {
+public:
+  explicit RelayBot(Bot *inner) : inner(inner) {}
+  void pleaseObserveBeforeMove(const Server &server) override { inner->pleaseObserveBeforeMove(server); }
+  void pleaseMakeMove(Server &server) override { inner->pleaseMakeMove(server); }
+  void pleaseObserveBeforeDiscard(const Server &server, int from, int card_index) override {
+    inner->pleaseObserveBeforeDiscard(server, from, card_index);
+  }
+  void pleaseObserveBeforePlay(const Server &server, int from, int card_index) override {
+    inner->pleaseObserveBeforePlay(server, from, card_index);
+  }
+  void pleaseObserveColorHint(const Server &server, int from, int to, Color color, CardIndices card_indices) override {
+    inner->pleaseObserveColorHint(server, from, to, color, card_indices);
+  }
+  void pleaseObserveValueHint(const Server &server, int from, int to, Value value, CardIndices card_indices) override {
+    inner->pleaseObserveValueHint(server, from, to, value, card_indices);
+  }
+  void pleaseObserveAfterMove(const Server &server) override { inner->pleaseObserveAfterMove(server); }
+
+  std::unique_ptr<Bot> inner;
+};
+
+}  // namespace
+
+int countDivergentCopies(const std::string &botName, int games, int players, int seed, bool restore) {
+  auto botFactory = getBotFactory(botName);
+  int divergent = 0;
+  for (int g = 0; g < games; g++) {
+    std::string logs[2];
+    for (int copying = 0; copying < 2; copying++) {
+      std::ostringstream log;
+      Server server;
+      server.setLog(&log);
+      server.srand(seed + g);
+      const int handSize = server.handSize(players);
+      std::vector<std::unique_ptr<RelayBot>> relays;
+      std::vector<Bot*> bots;
+      for (int i = 0; i < players; i++) {
+        relays.emplace_back(new RelayBot(botFactory->create(i, players, handSize)));
+        bots.push_back(relays.back().get());
+      }
+      server.startGame(bots, std::vector<Card>());
+      while (!server.gameOver()) {
+        for (int i = 0; copying && i < players; i++) {
+          Bot *copy;
+          if (restore) {
+            std::string state;
+            relays[i]->inner->saveState(state);
+            copy = botFactory->create(i, players, handSize);
+            if (copy->restoreState(state.data(), state.size()) != state.size()) {
+              throw std::runtime_error(botName + " did not restore all of its saved state");
+            }
+          } else {
+            copy = relays[i]->inner->clone();
+          }
+          relays[i]->inner.reset(copy);
+        }
+        server.runToTurn(server.turn() + 1);
+      }
+      logs[copying] = log.str();
+    }
+    divergent += (logs[0] != logs[1]);
+  }
+  return divergent;
+}
+
+std::string lineupName(const std::vector<std::string> &lineup) {
+  std::string name;
+  for (const auto &bot : lineup) {
+    name += (name.empty() ? "" : "+") + bot;
+  }
+  return name;
+}
+
+BotVec createBots(const std::vector<std::shared_ptr<Hanabi::BotFactory>> &factories, int handSize) {
+  const int players = factories.size();
+  BotVec bots;
+  for (int i = 0; i < players; i++) {
+    auto factory = factories[i];
+    bots.emplace_back(factory->create(i, players, handSize), [factory](Bot *bot) { factory->destroy(bot); });
+  }
+  return bots;
+}
+
+void playLineupGames(const std::vector<std::string> &lineup, const RunParams &params, int seed,
+                     int begin, int end,
+                     const std::function<void(int, int, const Server &)> &onGame) {
+  /* the server and the bot factories read their params from the scope */
+  RunParamsScope scope(&params);
+  std::vector<std::shared_ptr<Hanabi::BotFactory>> factories;
+  for (const auto &bot : lineup) {
+    factories.push_back(getBotFactory(bot));
+  }
+  Server server;
+  server.setParams(params.hanabi);
+  server.setLog(nullptr);
+  server.sqa(0);
+  const int handSize = server.handSize(lineup.size());
+  for (int g = begin; g < end; g++) {
+    BotVec owned = createBots(factories, handSize);
+    std::vector<Bot*> bots;
+    for (auto &bot : owned) {
+      bots.push_back(bot.get());
+    }
+    server.srand(seed + g);
+    const int score = server.runGame(bots, Server::shuffledDeck(seed + g));
+    onGame(g, score, server);
+  }
+}
+
  // handDistCDF
 
  HandDistCDF populateHandDistPDF(const HandDist &handDist) {
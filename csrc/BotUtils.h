@@ -8,6 +8,8 @@
 
 #include "Hanabi.h"
 #include "BotFactory.h"
+#include "MemoryStats.h"
+#include "RunParams.h"
 
 #include <memory>
 #include <map>
@@ -173,6 +175,10 @@ public:
   bool operator!= (const BoxedHand &r) const { return this->pHand != r.pHand; }
   bool operator< (const BoxedHand &r) const { return this->pHand < r.pHand; }
 
+  /* Hands interned so far (they are never freed), and their approximate bytes. */
+  static long internedCount();
+  static size_t internedBytes();
+
 private:
   Hand *pHand;
 };
@@ -208,10 +214,17 @@ struct HandDistVal {
 
 private:
   BotVec partners; // these are lazily updated so should only be accessed through getPartner()!
+  friend MemoryReport measureRangeMemory(const std::map<BoxedHand, HandDistVal> &handDist);
 };
 
 typedef std::map<BoxedHand, HandDistVal> HandDist;
 
+/* Walks a range and estimates the memory it holds, by category: map nodes,
+ * partner bots (via Bot::memoryBytes() of one of them) and delayed
+ * observations. Also fills in the process-wide categories: interned hands
+ * and RSS. */
+MemoryReport measureRangeMemory(const HandDist &handDist);
+
 
 class SimulServer : public Hanabi::Server {
 public:
@@ -230,6 +243,8 @@ public:
   virtual void sync(const Hanabi::Server &s);
   void setHand(int index, Hand my_hand);
   void setDeck(const std::vector<Hanabi::Card> &deck);
+  /* Approximate bytes of this server and its cards. */
+  size_t memoryBytes() const;
 
   /* Simulate the bot making a move, and return what the move was. */
   Move simulatePlayerMove(int index, Hanabi::Bot *bot);
@@ -249,8 +264,43 @@ public:
   void pleaseGiveValueHint(int player, Hanabi::Value value) override;
   bool mock_;  // if true, mock out all the pleaseXXX methods, and just record the move
   Move last_move_;
+
+private:
+  bool searchLog_;  // SEARCH_LOG of the RunParams current at construction
 };
 
+/* Plays `branches` continuations of a snapshotted game in parallel on the
+ * thread pool, each on its own server with its own clones of the bots, and
+ * returns their final scores. With reshuffle, branch i first shuffles the
+ * undrawn cards with seed+i, so that the continuations differ; otherwise
+ * they differ only where the bots (or the question rounds) are random.
+ * If logs is given, it receives each branch's log. */
+std::vector<int> forkGames(const Hanabi::ServerSnapshot &snapshot, int branches,
+                           bool reshuffle, int seed, std::vector<std::string> *logs=nullptr);
+
+/* Plays `games` seeded games of botName with copies of itself twice: once
+ * as is, and once with every bot replaced by a copy of itself before every
+ * turn, i.e. by its clone(), or with restore by a new bot restoreState()d
+ * from its saveState(). Returns how many of the copied games played out
+ * differently, which is 0 if copies behave exactly like the original. */
+int countDivergentCopies(const std::string &botName, int games, int players, int seed, bool restore);
+
+/* A lineup's bots, one per seat, joined with '+', e.g. "SmartBot+SearchBot". */
+std::string lineupName(const std::vector<std::string> &lineup);
+
+/* A bot per factory, seated in order, each freed by its factory's destroy()
+ * once released, so that a game that throws does not leak them. */
+BotVec createBots(const std::vector<std::shared_ptr<Hanabi::BotFactory>> &factories, int handSize);
+
+/* Plays games [begin, end) of lineup (a bot per seat) with params, without
+ * a log or questions, on a server of its own. Game g reseeds the server
+ * with seed + g and is dealt Server::shuffledDeck(seed + g), so every
+ * driver plays the same decks for the same seed. onGame(g, score, server)
+ * runs after each game. */
+void playLineupGames(const std::vector<std::string> &lineup, const RunParams &params, int seed,
+                     int begin, int end,
+                     const std::function<void(int, int, const Hanabi::Server &)> &onGame);
+
 
 template<typename K, typename V>
 std::vector<K> copyKeys(const std::map<K, V>& map) {
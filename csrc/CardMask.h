@@ -0,0 +1,151 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "Hanabi.h"
+#include <cstdint>
+
+namespace Hanabi {
+
+/* A set of card identities, one bit per (color, value): bit color*5 + value-1.
+ * What a bot knows about a hidden card is the set of identities it could still
+ * be, and questions like "how likely is it to be playable" become an AND with
+ * one of the BoardMasks below and a popcount. */
+class CardMask {
+public:
+    static constexpr int NUMBITS = NUMCOLORS * VALUE_MAX;
+    static constexpr uint32_t ALL = (1u << NUMBITS) - 1;
+
+    constexpr CardMask() : bits_(0) {}
+    constexpr explicit CardMask(uint32_t bits) : bits_(bits) {}
+
+    static constexpr CardMask all() { return CardMask(ALL); }
+    static constexpr CardMask of(int color, int value) { return CardMask(1u << (color * VALUE_MAX + value - 1)); }
+    static CardMask of(Card card) { return of(card.color, card.value); }
+    static constexpr CardMask ofColor(int color) { return CardMask(0x1Fu << (color * VALUE_MAX)); }
+    static constexpr CardMask ofValue(int value) { return CardMask(0x108421u << (value - 1)); }
+
+    constexpr uint32_t bits() const { return bits_; }
+    constexpr bool empty() const { return bits_ == 0; }
+    int count() const { return __builtin_popcount(bits_); }
+
+    constexpr bool contains(int color, int value) const { return (bits_ & of(color, value).bits_) != 0; }
+    bool contains(Card card) const { return contains(card.color, card.value); }
+    constexpr bool containsColor(int color) const { return (bits_ & ofColor(color).bits_) != 0; }
+    constexpr bool containsValue(int value) const { return (bits_ & ofValue(value).bits_) != 0; }
+
+    /* Bit k-1 is set if some identity of value k is in the set. */
+    constexpr uint32_t values() const {
+        return (bits_ | bits_ >> 5 | bits_ >> 10 | bits_ >> 15 | bits_ >> 20) & 0x1Fu;
+    }
+    /* Bit k is set if some identity of color k is in the set. */
+    uint32_t colors() const {
+        uint32_t result = 0;
+        for (int k = 0; k < NUMCOLORS; ++k) {
+            if (containsColor(k)) result |= 1u << k;
+        }
+        return result;
+    }
+    /* The color (value) shared by every identity in the set;
+     * -1 if they differ, -2 if the set is empty. */
+    int color() const { return single(colors()); }
+    int value() const { const int v = single(values()); return v >= 0 ? v + 1 : v; }
+
+    void add(int color, int value) { bits_ |= of(color, value).bits_; }
+    void remove(int color, int value) { bits_ &= ~of(color, value).bits_; }
+
+    constexpr CardMask operator& (CardMask rhs) const { return CardMask(bits_ & rhs.bits_); }
+    constexpr CardMask operator| (CardMask rhs) const { return CardMask(bits_ | rhs.bits_); }
+    constexpr CardMask operator~ () const { return CardMask(~bits_ & ALL); }
+    CardMask &operator&= (CardMask rhs) { bits_ &= rhs.bits_; return *this; }
+    CardMask &operator|= (CardMask rhs) { bits_ |= rhs.bits_; return *this; }
+    constexpr bool operator== (CardMask rhs) const { return bits_ == rhs.bits_; }
+    constexpr bool operator!= (CardMask rhs) const { return bits_ != rhs.bits_; }
+
+private:
+    static int single(uint32_t set) {
+        if (set == 0) return -2;
+        if (set & (set - 1)) return -1;
+        return __builtin_ctz(set);
+    }
+
+    uint32_t bits_;
+};
+
+/* Which identities are playable, valuable, ... given the board. Computed
+ * once per change of the board, so that per-card queries are mask operations. */
+struct BoardMasks {
+    CardMask played;     /* on the piles */
+    CardMask playable;   /* the next card of its pile */
+    CardMask lastCopy;   /* exactly one copy not yet played or discarded */
+    CardMask valuable;   /* the last copy of a card that can still be played */
+    CardMask worthless;  /* already played, or blocked by a lower card that is all gone */
+
+    /* pileSizes[k] is the height of pile k; gone[k][v] is how many copies of
+     * (k,v) have been played or discarded (bombs included). */
+    template<class Count>
+    static BoardMasks compute(const int pileSizes[NUMCOLORS], const Count gone[NUMCOLORS][VALUE_MAX+1]) {
+        BoardMasks result;
+        for (int k = 0; k < NUMCOLORS; ++k) {
+            bool blocked = false;
+            for (int v = 1; v <= VALUE_MAX; ++v) {
+                const CardMask m = CardMask::of(k, v);
+                const int total = (v == 1 ? 3 : (v == 5 ? 1 : 2));
+                if (gone[k][v] == total - 1) result.lastCopy |= m;
+                if (v <= pileSizes[k]) {
+                    result.played |= m;
+                    result.worthless |= m;
+                    continue;
+                }
+                if (v == pileSizes[k] + 1) result.playable |= m;
+                if (blocked) {
+                    result.worthless |= m;
+                } else if (gone[k][v] == total - 1) {
+                    result.valuable |= m;
+                }
+                if (gone[k][v] == total) blocked = true;
+            }
+        }
+        return result;
+    }
+
+    /* The same, read off the server's piles and discard pile. */
+    static BoardMasks compute(const Server &server) {
+        int pileSizes[NUMCOLORS];
+        int gone[NUMCOLORS][VALUE_MAX+1] = {};
+        for (Color k = RED; k <= BLUE; ++k) {
+            pileSizes[k] = server.pileOf(k).size();
+            for (int v = 1; v <= pileSizes[k]; ++v) gone[k][v] += 1;
+        }
+        for (const Card &card : server.discards()) {
+            gone[card.color][card.value] += 1;
+        }
+        return compute(pileSizes, gone);
+    }
+};
+
+/* Writes one slot of out for a card that could be any identity in possible.
+ * A feature is YES if it holds for every possible identity and NO if it holds
+ * for none. */
+inline void writeCardKnowledge(const HandKnowledgeTensor &out, int player, int slot,
+                               CardMask possible, const BoardMasks &board) {
+    auto tri = [possible](CardMask yes) -> int8_t {
+        if ((possible & yes).empty()) return KNOWLEDGE_NO;
+        return (possible & ~yes).empty() ? KNOWLEDGE_YES : KNOWLEDGE_MAYBE;
+    };
+    for (int k = 0; k < NUMCOLORS; ++k) {
+        out.at(player, slot, KNOWLEDGE_COLOR + k) = tri(CardMask::ofColor(k));
+    }
+    for (int v = 1; v <= VALUE_MAX; ++v) {
+        out.at(player, slot, KNOWLEDGE_VALUE + v - 1) = tri(CardMask::ofValue(v));
+    }
+    out.at(player, slot, KNOWLEDGE_PLAYABLE) = tri(board.playable);
+    out.at(player, slot, KNOWLEDGE_VALUABLE) = tri(board.valuable);
+    out.at(player, slot, KNOWLEDGE_WORTHLESS) = tri(board.worthless);
+}
+
+}  /* namespace Hanabi */
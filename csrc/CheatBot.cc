@@ -3,9 +3,11 @@
 #include "Hanabi.h"
 #include "BotFactory.h"
 #include "CheatBot.h"
+#include "BotState.h"
 
 
 using namespace Hanabi;
+using namespace CheatBotInternal;
 
 static void _registerBots() {
   registerBotFactory("CheatBot", std::shared_ptr<Hanabi::BotFactory>(new ::BotFactory<CheatBot>()));
@@ -14,17 +16,6 @@ static void _registerBots() {
 static int dummy =  (_registerBots(), 0);
 
 
-static int numPlayers;
-static std::vector<std::vector<Card> > hands;
-static std::vector<Card> discards;
-
-/* Apple's llvm-gcc 4.2.1 does not support this #pragma,
- * and GCC in general does not support it with non-POD
- * types such as std::vector (Bugzilla bug 27557).
- * The appropriate workaround in both cases is to build
- * run_CheatBot without OpenMP enabled. */
-#pragma omp threadprivate(numPlayers,hands,discards)
-
 template<typename T>
 static int vector_count(const std::vector<T> &vec, T value)
 {
@@ -35,7 +26,20 @@ static int vector_count(const std::vector<T> &vec, T value)
     return result;
 }
 
-static int visibleCopiesOf(Card card)
+void GameView::sync(const Server &server, int me)
+{
+    hands.resize(server.numPlayers());
+    for (int p=0; p < hands.size(); ++p) {
+        hands[p] = (p == me) ? server.cheatGetHand(p) : server.handOfPlayer(p);
+    }
+    discards = server.discards();
+    ownHandHidden = false;
+    for (const Card &card : hands[me]) {
+        ownHandHidden |= (card.color == INVALID_COLOR);
+    }
+}
+
+int GameView::visibleCopiesOf(Card card) const
 {
     int result = 0;
     for (int p=0; p < hands.size(); ++p) {
@@ -49,23 +53,38 @@ static int visibleCopiesOf(Card card)
 CheatBot::CheatBot(int index, int n, int /*handSize*/)
 {
     me_ = index;
-    numPlayers = n;
-    hands.resize(n);
-    discards.clear();
+    view_.hands.resize(n);
 }
 
-void CheatBot::pleaseObserveBeforeMove(const Server &server)
+CheatBot *CheatBot::clone() const
 {
-    if (me_ == 0) {
-        discards = server.discards();
-        for (int p=1; p < hands.size(); ++p) {
-            hands[p] = server.handOfPlayer(p);
-        }
-    } else if (me_ == 1) {
-        hands[0] = server.handOfPlayer(0);
-    }
+    return new CheatBot(*this);
+}
+
+void CheatBot::saveState(std::string &buf) const
+{
+    /* view_ is re-read from the server before every move */
+    StateWriter out(buf);
+    out.tag("CheatBot");
+    out.pod(permissive_);
+    out.pod(me_);
+    out.pod(view_.numPlayers());
+}
+
+size_t CheatBot::restoreState(const char *data, size_t size)
+{
+    StateReader in(data, size);
+    in.tag("CheatBot");
+    in.pod(permissive_);
+    in.pod(me_);
+    int numPlayers;
+    in.pod(numPlayers);
+    view_.hands.resize(numPlayers);
+    return in.consumed();
 }
 
+void CheatBot::pleaseObserveBeforeMove(const Server &) { }
+
 void CheatBot::pleaseObserveBeforeDiscard(const Server &, int, int) { }
 void CheatBot::pleaseObserveBeforePlay(const Server &, int, int) { }
 void CheatBot::pleaseObserveColorHint(const Server &, int, int, Color, CardIndices) { }
@@ -74,20 +93,20 @@ void CheatBot::pleaseObserveAfterMove(const Server &) { }
 
 bool CheatBot::maybeEnablePlay(Server &server, int plus)
 {
-    const int partner = (me_ + plus) % numPlayers;
+    const int partner = (me_ + plus) % view_.numPlayers();
     assert(partner != me_);
 
     int lowest_value = 5;
     int best_index = -1;
 
-    for (int i=0; i < hands[me_].size(); ++i) {
-        Card card = hands[me_][i];
+    for (int i=0; i < view_.hands[me_].size(); ++i) {
+        Card card = view_.hands[me_][i];
         if (card.value >= lowest_value) continue;
         if (!server.pileOf(card.color).nextValueIs(card.value)) continue;
 
         Card nextCard(card.color, card.value+1);
         assert(nextCard.count() != 0);
-        if (vector_count(hands[partner], nextCard) != 0) {
+        if (vector_count(view_.hands[partner], nextCard) != 0) {
             lowest_value = card.value;
             best_index = i;
         }
@@ -102,14 +121,14 @@ bool CheatBot::maybeEnablePlay(Server &server, int plus)
 
 bool CheatBot::maybePlayLowestPlayableCard(Server &server)
 {
-    for (int plus = 1; plus < numPlayers; ++plus) {
+    for (int plus = 1; plus < view_.numPlayers(); ++plus) {
         if (maybeEnablePlay(server, plus)) return true;
     }
 
     int lowest_value = 10;
     int best_index = -1;
-    for (int i=0; i < hands[me_].size(); ++i) {
-        Card card = hands[me_][i];
+    for (int i=0; i < view_.hands[me_].size(); ++i) {
+        Card card = view_.hands[me_][i];
         if (server.pileOf(card.color).nextValueIs(card.value)) {
             if (card.value < lowest_value) {
                 best_index = i;
@@ -126,7 +145,7 @@ bool CheatBot::maybePlayLowestPlayableCard(Server &server)
     return false;
 }
 
-static bool noPlayableCardsVisible(const Server &server)
+bool GameView::noPlayableCardsVisible(const Server &server) const
 {
     for (int p=0; p < hands.size(); ++p) {
         for (int i=0; i < hands[p].size(); ++i) {
@@ -139,7 +158,7 @@ static bool noPlayableCardsVisible(const Server &server)
     return true;
 }
 
-static bool noWorthlessOrDuplicateCardsVisible(const Server& server)
+bool GameView::noWorthlessOrDuplicateCardsVisible(const Server& server) const
 {
     for (int p=0; p < hands.size(); ++p) {
         for (int i=0; i < hands[p].size(); ++i) {
@@ -178,13 +197,13 @@ bool CheatBot::tryHardToDisposeOf(Server& server, int card_index)
 
 bool CheatBot::maybeDiscardWorthlessCard(Server &server)
 {
-    for (int i=0; i < hands[me_].size(); ++i) {
-        Card card = hands[me_][i];
+    for (int i=0; i < view_.hands[me_].size(); ++i) {
+        Card card = view_.hands[me_][i];
         Pile pile = server.pileOf(card.color);
         if (pile.contains(card.value)) {
             /* This card won't ever be needed again. */
             return tryHardToDisposeOf(server, i);
-        } else if (vector_count(hands[me_], card) >= 2) {
+        } else if (vector_count(view_.hands[me_], card) >= 2) {
             /* I've got two copies of this card already; it's definitely safe
              * to discard one of them. */
             return tryHardToDisposeOf(server, i);
@@ -192,7 +211,7 @@ bool CheatBot::maybeDiscardWorthlessCard(Server &server)
             assert(card.value > pile.size());
             for (int v = pile.size()+1; v < card.value; ++v) {
                 Card earlier_card(card.color, v);
-                if (vector_count(discards, earlier_card) == earlier_card.count()) {
+                if (vector_count(view_.discards, earlier_card) == earlier_card.count()) {
                     /* earlier_card is gone for good, so this later card
                      * is also unplayable. */
                     return tryHardToDisposeOf(server, i);
@@ -207,9 +226,9 @@ bool CheatBot::maybeDiscardDuplicateCard(Server &server)
 {
     if (!server.discardingIsAllowed()) return false;
 
-    for (int i=0; i < hands[me_].size(); ++i) {
-        Card card = hands[me_][i];
-        if (visibleCopiesOf(card) > 1) {
+    for (int i=0; i < view_.hands[me_].size(); ++i) {
+        Card card = view_.hands[me_][i];
+        if (view_.visibleCopiesOf(card) > 1) {
             /* We have a duplicate of this card somewhere visible. */
             server.pleaseDiscard(i);
             return true;
@@ -225,8 +244,8 @@ bool CheatBot::maybePlayProbabilities(Server &server)
     int bestGap = 0;
     int bestIndex = -1;
 
-    for (int i=0; i < hands[me_].size(); ++i) {
-        Card card = hands[me_][i];
+    for (int i=0; i < view_.hands[me_].size(); ++i) {
+        Card card = view_.hands[me_][i];
         if (card.value == 5) continue;
         /* This codepath should be reached only after discarding
          * any worthless card; so none of my cards should be
@@ -237,7 +256,7 @@ bool CheatBot::maybePlayProbabilities(Server &server)
         int gap = (card.value - pile.size());
         assert(gap >= 1);
         if (gap > bestGap) {
-            if (vector_count(discards, card) == card.count()-1) {
+            if (vector_count(view_.discards, card) == card.count()-1) {
                 /* This is really the last copy: don't discard it! */
             } else {
                 /* There's another copy coming up later. */
@@ -259,17 +278,17 @@ bool CheatBot::maybeTemporize(Server &server)
 {
     if (server.hintStonesRemaining() == 0) return false;
 
-    const int nextPlayer = (me_ + 1) % hands.size();
-    server.pleaseGiveValueHint(nextPlayer, hands[nextPlayer][0].value);
+    const int nextPlayer = (me_ + 1) % view_.hands.size();
+    server.pleaseGiveValueHint(nextPlayer, view_.hands[nextPlayer][0].value);
     return true;
 }
 
 void CheatBot::discardHighestCard(Server &server)
 {
     int bestIndex = 0;
-    for (int i=1; i < hands[me_].size(); ++i) {
-        Card card = hands[me_][i];
-        if (card.value > hands[me_][bestIndex].value) {
+    for (int i=1; i < view_.hands[me_].size(); ++i) {
+        Card card = view_.hands[me_][i];
+        if (card.value > view_.hands[me_][bestIndex].value) {
             bestIndex = i;
         }
     }
@@ -281,6 +300,16 @@ void CheatBot::pleaseMakeMove(Server &server)
     assert(server.whoAmI() == me_);
     assert(server.activePlayer() == me_);
 
+    view_.sync(server, me_);
+
+    if (view_.ownHandHidden) {
+        /* There's nothing to cheat with; do something legal that doesn't
+         * depend on my own cards. */
+        if (maybeTemporize(server)) return;
+        server.pleaseDiscard(0);
+        return;
+    }
+
     const int stillToGo = (25 - server.currentScore());
     const bool endgameNoMoreDiscarding = (stillToGo >= server.cardsRemainingInDeck()+1);
 
@@ -298,10 +327,10 @@ void CheatBot::pleaseMakeMove(Server &server)
     /* If there are no playable cards visible, then temporizing won't solve anything.
      * Someone must discard a card to get things moving again --- the sooner the better.
      */
-    if (noPlayableCardsVisible(server)) {
+    if (view_.noPlayableCardsVisible(server)) {
         if (maybeDiscardWorthlessCard(server)) return;
         if (maybeDiscardDuplicateCard(server)) return;
-        if (noWorthlessOrDuplicateCardsVisible(server)) {
+        if (view_.noWorthlessOrDuplicateCardsVisible(server)) {
             if (maybePlayProbabilities(server)) return;
         }
     }
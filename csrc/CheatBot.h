@@ -1,9 +1,31 @@
 
 #include "Hanabi.h"
 
+namespace CheatBotInternal {
+
+/* Everything CheatBot peeks at, taken from the server it is playing on when
+ * it is about to move. Each bot owns its own copy, so concurrent games (and
+ * search rollouts on simulated servers) don't share anything. */
+struct GameView {
+    std::vector<std::vector<Hanabi::Card> > hands;
+    std::vector<Hanabi::Card> discards;
+    /* True when the server hides my own cards from me too, as SearchBot's
+     * simulated server does before it samples a hand for me. */
+    bool ownHandHidden = false;
+
+    void sync(const Hanabi::Server &server, int me);
+    int numPlayers() const { return hands.size(); }
+    int visibleCopiesOf(Hanabi::Card card) const;
+    bool noPlayableCardsVisible(const Hanabi::Server &server) const;
+    bool noWorthlessOrDuplicateCardsVisible(const Hanabi::Server &server) const;
+};
+
+} // namespace CheatBotInternal
+
 class CheatBot final : public Hanabi::Bot {
 
     int me_;
+    CheatBotInternal::GameView view_;
 
     bool maybeEnablePlay(Hanabi::Server &, int plus);
     bool maybePlayLowestPlayableCard(Hanabi::Server &);
@@ -25,4 +47,7 @@ class CheatBot final : public Hanabi::Bot {
     void pleaseObserveAfterMove(const Hanabi::Server &) override;
     std::map<std::string, std::string> handKnowledgeToMap() override;
     void printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) override;
+    CheatBot *clone() const override;
+    void saveState(std::string &buf) const override;
+    size_t restoreState(const char *data, size_t size) override;
 };
@@ -0,0 +1,174 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include "Comparison.h"
+#include "BotUtils.h"
+#include "Hanabi.h"
+#include "SearchBot.h"
+#include "Tournament.h"
+
+using namespace Hanabi;
+
+namespace {
+
+/* x such that a standard normal exceeds it with probability p */
+double normalQuantile(double p) {
+  double lo = 0, hi = 40;
+  for (int i = 0; i < 200; ++i) {
+    const double mid = (lo + hi) / 2;
+    (0.5 * std::erfc(mid / std::sqrt(2.)) > p ? lo : hi) = mid;
+  }
+  return (lo + hi) / 2;
+}
+
+}  // namespace
+
+double ComparisonResult::mean(int lineup) const {
+  const auto &s = scores.at(lineup);
+  return meanAndStandardError(std::vector<double>(s.begin(), s.begin() + games)).first;
+}
+
+std::pair<double, double> ComparisonResult::difference(int lineup) const {
+  const auto &x = scores.at(lineup);
+  const auto &y = scores.at(0);
+  std::vector<double> diffs(games);
+  for (int g = 0; g < games; ++g) {
+    diffs[g] = x[g] - y[g];
+  }
+  return meanAndStandardError(diffs);
+}
+
+std::pair<double, double> ComparisonResult::interval(int lineup) const {
+  const auto d = difference(lineup);
+  return std::make_pair(d.first - z * d.second, d.first + z * d.second);
+}
+
+std::string ComparisonResult::table() const {
+  size_t width = 10;
+  for (const auto &lineup : lineups) width = std::max(width, lineupName(lineup).size() + 2);
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  for (int l = 0; l < lineups.size(); ++l) {
+    out << std::setw(width) << lineupName(lineups[l]) << "  mean " << mean(l);
+    if (l == 0) {
+      out << "  (baseline)\n";
+      continue;
+    }
+    const auto d = difference(l);
+    const auto ci = interval(l);
+    out << "  diff " << std::showpos << d.first << std::noshowpos << " +- " << d.second
+        << "  [" << ci.first << ", " << ci.second << "]"
+        << (ci.first > 0 || ci.second < 0 ? "" : "  unresolved") << "\n";
+  }
+  out << "over " << games << " shared decks" << (stoppedEarly ? ", stopped early" : "") << "\n";
+  return out.str();
+}
+
+std::string ComparisonResult::toJson() const {
+  std::ostringstream out;
+  out << "{\"games\": " << games << ", \"stopped_early\": " << (stoppedEarly ? "true" : "false")
+      << ", \"z\": " << z << ", \"seconds\": " << seconds << ", \"lineups\": [";
+  for (int l = 0; l < lineups.size(); ++l) {
+    out << (l ? ", " : "") << "{\"bots\": [";
+    for (int i = 0; i < lineups[l].size(); ++i) {
+      out << (i ? ", " : "") << "\"" << lineups[l][i] << "\"";
+    }
+    out << "], \"mean\": " << mean(l);
+    if (l > 0) {
+      const auto d = difference(l);
+      const auto ci = interval(l);
+      out << ", \"diff\": " << d.first << ", \"stderr\": " << d.second
+          << ", \"low\": " << ci.first << ", \"high\": " << ci.second;
+    }
+    out << "}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+ComparisonResult compareLineups(const ComparisonSpec &spec) {
+  const auto start = std::chrono::steady_clock::now();
+  const int n = spec.lineups.size();
+  if (n < 2) {
+    throw std::runtime_error("A comparison needs a baseline and at least one candidate");
+  }
+  if (!spec.params.empty() && spec.params.size() != n) {
+    throw std::runtime_error("A comparison needs params for every lineup or for none");
+  }
+  if (spec.maxGames <= 0 || spec.batchGames <= 0 || spec.confidence <= 0 || spec.confidence >= 1) {
+    throw std::runtime_error("A comparison needs games, batches and a confidence in (0, 1)");
+  }
+  std::vector<RunParams> params = spec.params;
+  if (params.empty()) {
+    params.assign(n, RunParams::current());
+  }
+  for (int l = 0; l < n; ++l) {
+    const auto &lineup = spec.lineups[l];
+    if (lineup.size() < 2) {
+      throw std::runtime_error("Lineup " + lineupName(lineup) + " needs at least 2 players");
+    }
+    for (int i = 0; i < lineup.size(); ++i) {
+      getBotFactory(lineup[i]);  /* unknown bots fail here, not on the pool */
+      /* it would silently play as BPBOT, and the lineup be mislabeled */
+      if (lineup[i] == "SearchBot" && !isSearchSeat(i, lineup.size(), params[l].search)) {
+        throw std::runtime_error("Lineup " + lineupName(lineup) + " seats SearchBot in seat " +
+                                 std::to_string(i) + ", which plays as " + params[l].search.BPBOT +
+                                 " (see SEARCH_PLAYER)");
+      }
+    }
+  }
+  ComparisonResult result;
+  result.lineups = spec.lineups;
+  result.scores.assign(n, std::vector<int>(spec.maxGames, 0));
+  const int checks = spec.earlyStop ? (spec.maxGames + spec.batchGames - 1) / spec.batchGames : 1;
+  result.z = normalQuantile((1 - spec.confidence) / 2 / checks);
+
+  const int threads = getThreadPool().config().threads;
+  while (result.games < spec.maxGames) {
+    const int batchBegin = result.games;
+    const int batchEnd = std::min(spec.maxGames, batchBegin + spec.batchGames);
+    /* enough chunks to keep every pool thread busy, each on its own server */
+    const int chunks = std::max(1, std::min(batchEnd - batchBegin, (threads + n - 1) / n));
+    std::vector<boost::fibers::future<void>> futures;
+    for (int l = 0; l < n; ++l) {
+      for (int c = 0; c < chunks; ++c) {
+        const int begin = batchBegin + c * (batchEnd - batchBegin) / chunks;
+        const int end = batchBegin + (c + 1) * (batchEnd - batchBegin) / chunks;
+        futures.push_back(getThreadPool().enqueue([&, l, begin, end]() {
+          auto &scores = result.scores[l];
+          playLineupGames(spec.lineups[l], params[l], spec.seed, begin, end,
+                          [&scores](int g, int score, const Server &) { scores[g] = score; });
+        }));
+      }
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+    result.games = batchEnd;
+
+    if (spec.earlyStop && result.games >= spec.minGames && result.games < spec.maxGames) {
+      bool resolved = true;
+      for (int l = 1; l < n && resolved; ++l) {
+        const auto ci = result.interval(l);
+        resolved = ci.first > 0 || ci.second < 0;
+      }
+      if (resolved) {
+        result.stoppedEarly = true;
+        break;
+      }
+    }
+  }
+  for (auto &scores : result.scores) {
+    scores.resize(result.games);
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
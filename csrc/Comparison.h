@@ -0,0 +1,63 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "RunParams.h"
+
+/* An A/B evaluation of bot lineups: game g of every lineup is dealt the same
+ * stacked deck (Server::shuffledDeck(seed + g), as in a tournament with the
+ * same seed; see playLineupGames()), so each candidate is judged
+ * by its score minus the baseline's (lineup 0) game by game. The deck's
+ * share of the variance cancels, and a difference of a tenth of a point
+ * resolves in far fewer games than with independent seeds. */
+struct ComparisonSpec {
+  /* a bot per seat; [0] is the baseline. SearchBot must sit in a seat that
+   * searches (see isSearchSeat()), since it plays the others as BPBOT. */
+  std::vector<std::vector<std::string>> lineups;
+  /* the params of each lineup, e.g. two SEARCH_N for the same bots; empty:
+   * the caller's for every lineup */
+  std::vector<RunParams> params;
+  int maxGames = 10000;
+  /* games dealt between stopping checks */
+  int batchGames = 100;
+  int minGames = 100;
+  double confidence = 0.95;
+  /* stop once every candidate's interval excludes zero */
+  bool earlyStop = true;
+  int seed = 1;
+};
+
+struct ComparisonResult {
+  std::vector<std::vector<std::string>> lineups;
+  std::vector<std::vector<int>> scores;   // [lineup][game g, dealt seed + g]
+  int games = 0;
+  /* whether every interval excluded zero before maxGames */
+  bool stoppedEarly = false;
+  /* the intervals' half-width in standard errors: the confidence is split
+   * over every stopping check, so that stopping on the first interval that
+   * excludes zero keeps the overall error rate */
+  double z = 0;
+  double seconds = 0;
+
+  double mean(int lineup) const;
+  /* Mean and standard error of the lineup's score minus the baseline's,
+   * game by game. */
+  std::pair<double, double> difference(int lineup) const;
+  /* difference() -+ z standard errors */
+  std::pair<double, double> interval(int lineup) const;
+  /* One line per lineup: its mean and its difference from the baseline. */
+  std::string table() const;
+  std::string toJson() const;
+};
+
+/* Plays spec's lineups in batches over the fiber thread pool (see
+ * getThreadPool()), each with its params or else the caller's RunParams,
+ * until maxGames or, with earlyStop, until every interval excludes zero. */
+ComparisonResult compareLineups(const ComparisonSpec &spec);
@@ -0,0 +1,317 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include "Dataset.h"
+#include "BotUtils.h"
+#include "ServerObserver.h"
+#include "TranscriptWriter.h"
+
+using namespace Hanabi;
+
+namespace {
+
+/* Games of one bot pair, with one question kind, asking their question at
+ * roundLo to roundHi cards remaining. */
+struct Plan {
+  int pair;
+  int qa;
+  int roundLo;
+  int roundHi;
+
+  bool operator==(const Plan &other) const {
+    return pair == other.pair && qa == other.qa && roundLo == other.roundLo && roundHi == other.roundHi;
+  }
+};
+
+struct Cell {
+  long target = 0;
+  long count = 0;
+  long games = 0;         // steered to this cell
+  bool givenUp = false;
+  std::vector<Plan> plans;
+
+  bool open() const { return !givenUp && count < target; }
+};
+
+/* The question types of a qa kind, with the answers each can have when
+ * asked at up to maxCards cards remaining. */
+std::vector<std::pair<std::string, std::vector<std::string>>> questionTypes(int qa, int maxCards) {
+  auto range = [](int lo, int hi) {
+    std::vector<std::string> answers;
+    for (int a = lo; a <= hi; ++a) answers.push_back(std::to_string(a));
+    return answers;
+  };
+  switch (qa) {
+    case 1: return {{"state", {"-"}}};
+    case 2: return {{"partner_color", {"Yes", "No"}}, {"partner_value", {"Yes", "No"}}};
+    case 3: return {{"pile", range(0, 5)}};
+    case 4: return {{"discard", range(0, 3)}};
+    case 5: return {{"deck", range(0, maxCards)}};
+    default: throw std::runtime_error("Unknown qa kind " + std::to_string(qa) + " (1 to 5)");
+  }
+}
+
+std::string questionType(const QuestionEvent &q) {
+  switch (q.qa) {
+    case 1: return "state";
+    case 2: return q.isColor ? "partner_color" : "partner_value";
+    case 3: return "pile";
+    case 4: return "discard";
+    default: return "deck";
+  }
+}
+
+std::string answerOf(const QuestionEvent &q) {
+  switch (q.qa) {
+    case 1: return "-";
+    case 2: return q.answer ? "Yes" : "No";
+    default: return std::to_string(q.answer);
+  }
+}
+
+/* The text transcript of the current game, and its question if one was
+ * asked. */
+class SampleLog : public TextTranscriptObserver {
+public:
+  SampleLog() : TextTranscriptObserver(&text_, &text_) {}
+
+  void onDeal(const Server &server) override {
+    text_.str("");
+    asked_ = false;
+    TextTranscriptObserver::onDeal(server);
+  }
+  void onQuestion(const Server &server, const QuestionEvent &question) override {
+    TextTranscriptObserver::onQuestion(server, question);
+    question_ = question;
+    asked_ = true;
+  }
+
+  bool asked() const { return asked_; }
+  const QuestionEvent &question() const { return question_; }
+  std::string text() const { return text_.str(); }
+
+private:
+  std::ostringstream text_;
+  bool asked_ = false;
+  QuestionEvent question_;
+};
+
+class CellTable {
+public:
+  explicit CellTable(const DatasetSpec &spec) : spec_(spec) {
+    for (const auto &dim : spec.stratify) {
+      if (dim == "bots") bots_ = true;
+      else if (dim == "question") question_ = true;
+      else if (dim == "answer") answer_ = true;
+      else if (dim == "cards_remaining") cardsRemaining_ = true;
+      else throw std::runtime_error("Unknown dimension '" + dim + "' (bots, question, answer or cards_remaining)");
+    }
+    if (cardsRemaining_ && spec.cardsRemainingEdges.empty()) {
+      throw std::runtime_error("Stratifying by cards_remaining needs cardsRemainingEdges");
+    }
+  }
+
+  std::string key(const std::string &bots, const std::string &question, const std::string &answer, int round) const {
+    std::string key;
+    auto add = [&](const std::string &field) { key += (key.empty() ? "" : ",") + field; };
+    if (bots_) add("bots=" + bots);
+    if (question_) add("question=" + question);
+    if (answer_) add("answer=" + answer);
+    if (cardsRemaining_) add("cards_remaining=" + bucket_(round));
+    return key;
+  }
+
+  /* The rounds of the bucket of round, within [lo, hi]. */
+  std::pair<int, int> bucketRounds(int round, int lo, int hi) const {
+    if (!cardsRemaining_) return std::make_pair(lo, hi);
+    const auto &edges = spec_.cardsRemainingEdges;
+    int i = std::upper_bound(edges.begin(), edges.end(), round) - edges.begin() - 1;
+    int bucketLo = i < 0 ? lo : edges[i];
+    int bucketHi = i + 1 < edges.size() ? edges[i + 1] - 1 : hi;
+    return std::make_pair(std::max(lo, bucketLo), std::min(hi, bucketHi));
+  }
+
+private:
+  std::string bucket_(int round) const {
+    const auto &edges = spec_.cardsRemainingEdges;
+    int i = std::upper_bound(edges.begin(), edges.end(), round) - edges.begin() - 1;
+    if (i < 0) return "<" + std::to_string(edges[0]);
+    if (i + 1 == edges.size()) return std::to_string(edges[i]) + "+";
+    return std::to_string(edges[i]) + "-" + std::to_string(edges[i + 1] - 1);
+  }
+
+  const DatasetSpec &spec_;
+  bool bots_ = false;
+  bool question_ = false;
+  bool answer_ = false;
+  bool cardsRemaining_ = false;
+};
+
+/* Where the samples of one bot pair go. */
+struct PairOutput {
+  std::ofstream text;
+  std::unique_ptr<GzipTranscriptWriter> gzip;
+
+  void write(const std::string &sample, int score) {
+    if (gzip) {
+      gzip->write(sample, score);
+    } else {
+      text << sample;
+    }
+  }
+};
+
+}  // namespace
+
+std::string DatasetResult::toJson() const {
+  std::ostringstream out;
+  out << "{\"games\": " << games << ", \"accepted\": " << accepted << ", \"cells\": {";
+  bool first = true;
+  for (const auto &kv : targets) {
+    out << (first ? "" : ", ") << "\"" << kv.first << "\": {\"count\": " << counts.at(kv.first)
+        << ", \"target\": " << kv.second << "}";
+    first = false;
+  }
+  out << "}, \"given_up\": [";
+  for (int i = 0; i < givenUp.size(); ++i) {
+    out << (i ? ", " : "") << "\"" << givenUp[i] << "\"";
+  }
+  out << "]}";
+  return out.str();
+}
+
+DatasetResult generateDataset(const DatasetSpec &spec) {
+  const auto start = std::chrono::steady_clock::now();
+  if (spec.botPairs.empty() || spec.qaKinds.empty()) {
+    throw std::runtime_error("generateDataset needs bot pairs and qa kinds");
+  }
+  CellTable table(spec);
+  Server server;
+  server.setLog(nullptr);
+
+  /* every cell, and the games that can fill it */
+  std::vector<std::vector<std::shared_ptr<Hanabi::BotFactory>>> botFactories;
+  std::map<std::string, Cell> cells;
+  for (int p = 0; p < spec.botPairs.size(); ++p) {
+    const auto &bots = spec.botPairs[p];
+    botFactories.emplace_back();
+    for (const auto &botname : bots) {
+      botFactories.back().push_back(getBotFactory(botname));
+    }
+    const int players = bots.size();
+    const auto rounds = server.questionRounds(players);
+    for (int qa : spec.qaKinds) {
+      for (const auto &type : questionTypes(qa, rounds.second)) {
+        for (const auto &answer : type.second) {
+          for (int round = rounds.first; round <= rounds.second; ) {
+            const auto bucket = table.bucketRounds(round, rounds.first, rounds.second);
+            round = bucket.second + 1;
+            /* the deck is asked about when round or fewer cards remain */
+            if (qa == 5 && (std::stoi(answer) > bucket.second || std::stoi(answer) < bucket.first - players)) {
+              continue;
+            }
+            const std::string key = table.key(lineupName(bots), type.first, answer, bucket.first);
+            const auto quota = spec.cellQuotas.find(key);
+            const long target = quota != spec.cellQuotas.end() ? quota->second : spec.perCell;
+            if (target <= 0) continue;
+            Cell &cell = cells[key];
+            cell.target = target;
+            const Plan plan = {p, qa, bucket.first, bucket.second};
+            if (std::find(cell.plans.begin(), cell.plans.end(), plan) == cell.plans.end()) {
+              cell.plans.push_back(plan);
+            }
+          }
+        }
+      }
+    }
+  }
+  for (const auto &quota : spec.cellQuotas) {
+    if (quota.second > 0 && !cells.count(quota.first)) {
+      throw std::runtime_error("No game can fill cell '" + quota.first + "'");
+    }
+  }
+
+  ::mkdir(spec.outDir.c_str(), 0777);
+  std::vector<PairOutput> outputs(spec.botPairs.size());
+  for (int p = 0; p < spec.botPairs.size(); ++p) {
+    const std::string path = spec.outDir + "/" + lineupName(spec.botPairs[p]);
+    if (spec.gzip) {
+      outputs[p].gzip.reset(new GzipTranscriptWriter(path, spec.gamesPerShard));
+    } else {
+      outputs[p].text.open(path + ".txt");
+      if (!outputs[p].text) {
+        throw std::runtime_error("Could not open " + path + ".txt");
+      }
+    }
+  }
+
+  auto log = std::make_shared<SampleLog>();
+  server.addObserver(log);
+  server.srand(spec.seed);
+  std::mt19937 rng(spec.seed);
+  DatasetResult result;
+  std::vector<std::map<std::string, Cell>::iterator> open;
+  std::vector<double> deficits;
+  while (true) {
+    /* steer the game to an open cell, the more so the further it is from its target */
+    open.clear();
+    deficits.clear();
+    for (auto it = cells.begin(); it != cells.end(); ++it) {
+      if (it->second.open()) {
+        open.push_back(it);
+        deficits.push_back(it->second.target - it->second.count);
+      }
+    }
+    if (open.empty()) break;
+    Cell &cell = open[std::discrete_distribution<int>(deficits.begin(), deficits.end())(rng)]->second;
+    if (cell.games >= spec.maxGamesPerSample * cell.target) {
+      cell.givenUp = true;
+      continue;
+    }
+    cell.games += 1;
+    const Plan &plan = cell.plans[std::uniform_int_distribution<int>(0, cell.plans.size() - 1)(rng)];
+    server.sqa(plan.qa);
+    server.setQuestionRound(std::uniform_int_distribution<int>(plan.roundLo, plan.roundHi)(rng));
+
+    const auto &factories = botFactories[plan.pair];
+    BotVec owned = createBots(factories, server.handSize(factories.size()));
+    std::vector<Bot*> bots;
+    for (auto &bot : owned) {
+      bots.push_back(bot.get());
+    }
+    const int score = server.runGame(bots, std::vector<Card>());
+    result.games += 1;
+
+    /* keep the sample only if its own cell needs it */
+    if (!log->asked()) continue;
+    const QuestionEvent &q = log->question();
+    auto it = cells.find(table.key(lineupName(spec.botPairs[plan.pair]), questionType(q), answerOf(q), q.questionRound));
+    if (it == cells.end() || !it->second.open()) continue;
+    it->second.count += 1;
+    result.accepted += 1;
+    outputs[plan.pair].write(log->text(), score);
+  }
+  for (auto &output : outputs) {
+    if (output.gzip) output.gzip->close();
+  }
+
+  for (const auto &kv : cells) {
+    result.counts[kv.first] = kv.second.count;
+    result.targets[kv.first] = kv.second.target;
+    if (kv.second.givenUp) result.givenUp.push_back(kv.first);
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::ofstream(spec.outDir + "/quotas.json") << result.toJson() << std::endl;
+  return result;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+/* What generateDataset() should produce: question games (see Server::sqa())
+ * of the given bot pairs, with quotas on the cells of the dimensions it
+ * stratifies by:
+ *   "bots"             the bots of the game, e.g. "SmartBot+HolmesBot";
+ *   "question"         state (qa 1), partner_color and partner_value (qa 2),
+ *                      pile (qa 3), discard (qa 4), deck (qa 5);
+ *   "answer"           as logged: Yes/No, a count, or "-" for qa 1;
+ *   "cards_remaining"  the cards_remaining of the question, bucketed by
+ *                      cardsRemainingEdges.
+ * A cell is named by its values in that order, e.g.
+ * "bots=SmartBot+HolmesBot,answer=Yes" when stratifying by bots and answer. */
+struct DatasetSpec {
+  std::vector<std::vector<std::string>> botPairs;
+  std::vector<int> qaKinds = {2};
+  std::vector<std::string> stratify = {"bots", "answer"};
+  long perCell = 1000;
+  /* targets of particular cells, overriding perCell (0 leaves a cell out) */
+  std::map<std::string, long> cellQuotas;
+  /* bucket i is [edges[i], edges[i+1]), the last one unbounded */
+  std::vector<int> cardsRemainingEdges = {0, 10, 20, 30};
+  /* a cell that could not be filled after this many games steered to it
+   * per sample wanted is given up, e.g. an answer that is rare that early */
+  int maxGamesPerSample = 50;
+  /* of the decks, the steering and the questions: with deterministic bots,
+   * the same seed writes the same dataset */
+  int seed = 1;
+  /* The samples of each bot pair go to outDir/<bots>.txt, as eval_bot logs
+   * them, or with gzip to outDir/<bots>-NNNNN.txt.gz shards (see
+   * GzipTranscriptWriter); outDir/quotas.json gets the DatasetResult. */
+  std::string outDir;
+  bool gzip = false;
+  int gamesPerShard = 100000;
+};
+
+struct DatasetResult {
+  long games = 0;       // games played
+  long accepted = 0;    // of which samples were kept
+  std::map<std::string, long> counts;   // by cell
+  std::map<std::string, long> targets;
+  std::vector<std::string> givenUp;     // cells that could not be filled
+  double seconds = 0;
+
+  bool filled() const { return givenUp.empty(); }
+  /* all but seconds, so that quotas.json is reproducible */
+  std::string toJson() const;
+};
+
+/* Plays question games until every cell of spec is filled (or given up),
+ * choosing the bots, the question and the question round of each game to
+ * fill the cells furthest from their targets, and keeping only the
+ * samples whose cell still needs them. */
+DatasetResult generateDataset(const DatasetSpec &spec);
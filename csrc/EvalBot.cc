@@ -0,0 +1,172 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include "EvalBot.h"
+#include "Hanabi.h"
+#include "InferenceStats.h"
+#include "LatencyStats.h"
+#include "MemoryStats.h"
+#include "ServerObserver.h"
+#include "TranscriptWriter.h"
+
+using namespace Hanabi;
+
+namespace {
+
+struct Statistics {
+    int games;
+    int totalScore;
+    int scoreDistribution[26];
+    int mulligansUsed[4];
+};
+
+void dump_stats(const std::vector<std::string>& botnames, Statistics stats)
+{
+    const double dgames = stats.games;
+    const int perfectGames = stats.scoreDistribution[25];
+
+    std::cout << "Over " << stats.games << " games, bots (";
+    for (size_t i = 0; i < botnames.size(); ++i) {
+        if (i > 0) std::cout << ", ";
+        std::cout << botnames[i];
+    }
+    std::cout << ") scored an average of "
+              << (stats.totalScore / dgames) << " points per game.\n";
+    if (perfectGames != 0) {
+        const double winRate = 100*(perfectGames / dgames);
+        std::cout << "  " << winRate << " percent were perfect games.\n";
+    }
+    if (stats.mulligansUsed[0] != stats.games) {
+        std::cout << "  Mulligans used: 0 (" << 100*(stats.mulligansUsed[0] / dgames)
+                  << "%); 1 (" << 100*(stats.mulligansUsed[1] / dgames)
+                  << "%); 2 (" << 100*(stats.mulligansUsed[2] / dgames)
+                  << "%); 3 (" << 100*(stats.mulligansUsed[3] / dgames) << "%).\n";
+    }
+}
+
+}  // namespace
+
+double evalBot(const EvalOptions &options)
+{
+    const std::vector<std::string> &botnames = options.botnames;
+    const std::string &transcript = options.transcript;
+    int seed = options.seed;
+    // special case slurm runs
+    if (seed < 0 && std::getenv("SLURM_PROCID")) {
+      // CAREFUL! make sure this doesn't wrap around and become negative
+      seed = (std::stol(std::getenv("SLURM_JOBID")) + std::stol(std::getenv("SLURM_PROCID")) * 102797) % 1000000000;
+      printf("Set seed from slurm to %d\n", seed);
+    }
+    if (seed <= 0) {
+        std::srand(std::time(NULL));
+        seed = std::rand();
+    }
+    printf("--seed %d\n", seed);
+
+    Statistics stats = {};
+
+    Hanabi::Server server;
+    std::shared_ptr<GzipTranscriptWriter> gzipTranscript;
+    if (transcript == "text") {
+      server.setLog(&std::cerr);
+    } else if (transcript == "gzip") {
+      if (options.transcriptPath.empty()) {
+        throw std::runtime_error("transcript 'gzip' needs a transcript path prefix");
+      }
+      gzipTranscript = std::make_shared<GzipTranscriptWriter>(options.transcriptPath, options.gamesPerShard);
+      server.addObserver(gzipTranscript);
+    } else if (transcript != "none") {
+      throw std::runtime_error("Unknown transcript '" + transcript + "' (text, gzip or none)");
+    }
+    auto moveStats = std::make_shared<StatsObserver>();
+    server.addObserver(moveStats);
+    std::ofstream traceFile;
+    if (!options.tracePath.empty()) {
+      traceFile.open(options.tracePath, std::ios::binary);
+      if (!traceFile) {
+        throw std::runtime_error("Could not open " + options.tracePath);
+      }
+      server.addObserver(std::make_shared<BinaryTraceObserver>(&traceFile));
+    }
+    LatencyStats latency;
+    server.setLatencyStats(&latency);
+    std::vector<std::shared_ptr<Hanabi::BotFactory>> botFactories;
+    for (const auto& botname : botnames) {
+        botFactories.push_back(getBotFactory(botname));
+    }
+    int players = botnames.size();
+
+    server.srand(seed);
+    server.sqa(options.qa);
+
+    for (int i=0; i < options.games; ++i) {
+        std::vector<Hanabi::Bot*> bots;
+        for (int i = 0; i < players; ++i) {
+            bots.push_back(botFactories[i]->create(i, players, server.handSize(players)));
+        }
+        int score = server.runGame(bots, std::vector<Hanabi::Card>());
+        for (auto bot : bots) {
+            delete bot;
+        }
+        //std::cout << "botname: " << botname << std::endl;
+        std::cout << "Final score " << i << " : " << score << " bomb: "
+                  << (server.mulligansRemaining() == 0 ? 1 : 0) << std::endl;
+        assert(score == server.currentScore());
+        assert(0 <= server.mulligansUsed() && server.mulligansUsed() <= 3);
+        stats.games++;
+        stats.totalScore += score;
+        stats.scoreDistribution[score] += 1;
+        stats.mulligansUsed[server.mulligansUsed()] += 1;
+
+        if (i % options.logEvery == 0) {
+          dump_stats(botnames, stats);
+          std::cout << moveStats->summary();
+          std::cout << latency.summary(botnames);
+        }
+    }
+    dump_stats(botnames, stats);
+    std::cout << moveStats->summary();
+    std::cout << latency.summary(botnames);
+    std::cout << "  Peak RSS: " << peakRssBytes() / (1024. * 1024.) << " MB.\n";
+    if (gzipTranscript) {
+      gzipTranscript->close();
+      std::cout << "  Transcripts: " << gzipTranscript->games() << " games in "
+                << gzipTranscript->shards().size() << " shards, "
+                << gzipTranscript->compressedBytes() / (1024. * 1024.) << " MB ("
+                << gzipTranscript->textBytes() / (1024. * 1024.) << " MB of text).\n";
+    }
+    if (!options.latencyJson.empty()) {
+      std::ofstream out(options.latencyJson);
+      out << latency.toJson(botnames) << std::endl;
+    }
+#ifdef TORCHBOT
+    InferenceStats inference;
+    if (getInferenceStats(Hanabi::getThreadPool(), &inference)) {
+      std::cout << "  Inference on " << inference.device << ": "
+                << inference.inferences << " inferences in " << inference.batches
+                << " batches (" << 100 * inference.meanBatchFill << "% mean fill), "
+                << inference.inferencesPerSec << " inferences/sec.\n";
+    }
+    HiddenStateStats hidden;
+    if (getHiddenStateStats(RunParams::current().torch.TORCHBOT_HIDDEN_DTYPE, &hidden)) {
+      std::cout << "  Hidden states (" << hidden.dtype << "): peak " << hidden.peakLive
+                << " live, " << hidden.peakBytes / (1024. * 1024.) << " MB; arena "
+                << hidden.bytes / (1024. * 1024.) << " MB.\n";
+    }
+#endif
+
+    return stats.games ? stats.totalScore / double(stats.games) : 0;
+}
+
+
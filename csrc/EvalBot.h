@@ -0,0 +1,34 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/* What eval_bot (the Python binding and hanabi_eval) runs. */
+struct EvalOptions {
+  std::vector<std::string> botnames;   // one per seat
+  int games = 1000;
+  int logEvery = 100;
+  int seed = -1;                       // <= 0: from SLURM, or else random
+  int qa = 0;                          // see Server::sqa()
+  /* if set, the latency histograms go to this file as JSON */
+  std::string latencyJson;
+  /* "text" (to stderr), "gzip" (to transcriptPath shards, see
+   * GzipTranscriptWriter) or "none" */
+  std::string transcript = "text";
+  std::string transcriptPath;
+  int gamesPerShard = 100000;
+  /* if set, a BinaryTraceObserver writes to this file */
+  std::string tracePath;
+};
+
+/* Plays options.games games of options.botnames on one server, printing the
+ * final score of each game and, every logEvery games and at the end, the
+ * score, move, latency and memory statistics to stdout. Search runs on
+ * getThreadPool() with RunParams::current(). Returns the mean score. */
+double evalBot(const EvalOptions &options);
@@ -13,67 +13,75 @@
 #include <random>
 #include <vector>
 #include <tuple>
+#include <chrono>
 #include "ThreadPool.h"
+#include "RunParams.h"
 #include <future>
 #include <variant>
 
-
-namespace Params {
-  std::string getParameterString(
-    const std::string &name,
-    std::string default_val,
-    const std::string help=""
-  );
-  int getParameterInt(
-    const std::string &name,
-    int default_val,
-    const std::string help=""
-  );
-  float getParameterFloat(
-    const std::string &name,
-    float default_val,
-    const std::string help=""
-  );
-}
-
-namespace HanabiParams {
-  // read in parameters from environment variables
-
-  // return a score of 0 when bombing out
-  const int BOMB0 = Params::getParameterInt("BOMB0", 0,
-    "If 1, then the score is 0 if agents bomb out (official rules).");
-  const int BOMBD = Params::getParameterInt("BOMBD", 1,
-    "Subtract this number of points from the score when bombing out.");
-  const int FIBER_THREADS = Params::getParameterInt("FIBER_THREADS", 10,
-    "Number of threads in the thread pool that executes fibers (i.e. # cores to use).");
-  const int NUM_THREADS = Params::getParameterInt("NUM_THREADS", 1000,
-    "Number of user-space threads (i.e. fibers) to use for search (i.e. max parallelism). "
-    "These fibers are run on the fiber thread pool defined by FIBER_THREADS");
-  const int HAND_SIZE_OVERRIDE = Params::getParameterInt("HAND_SIZE_OVERRIDE", -1,
-    "If >0, this overrides the hand size. Must be >= 3.");
-} // namespace HanabiParams
-
+struct LatencyStats;
 
 namespace Hanabi {
     class Card;
     class Pile;
     class Server;
+    class ServerSnapshot;
     class Bot;
     class BotFactory;
     class Question;
     class ServerHint;
+    class ServerObserver;
     enum class AnswerType;
     class Answer;
 }  /* namespace Hanabi */
 
 namespace Hanabi {
 
-inline ThreadPool &getThreadPool() {
+/* The default pool is created lazily from the current default config, and
+ * rebuilt if someone calls close(). configureThreadPool() replaces the config
+ * (closing the running default pool) at runtime. */
+inline ThreadPoolConfig &defaultThreadPoolConfig_() {
+  static ThreadPoolConfig config(RunParams::defaults().hanabi.FIBER_THREADS);
+  return config;
+}
+
+inline std::shared_ptr<ThreadPool> &defaultThreadPool_() {
   static std::shared_ptr<ThreadPool> pool;
+  return pool;
+}
+
+inline std::mutex &defaultThreadPoolMutex_() {
+  static std::mutex mtx;
+  return mtx;
+}
+
+inline std::shared_ptr<ThreadPool> getDefaultThreadPool() {
+  std::lock_guard<std::mutex> lock(defaultThreadPoolMutex_());
+  auto &pool = defaultThreadPool_();
   if (!pool || pool->stop) {
-    pool.reset(new ThreadPool(HanabiParams::FIBER_THREADS));
+    pool.reset(new ThreadPool(defaultThreadPoolConfig_()));
+  }
+  return pool;
+}
+
+inline void configureThreadPool(const ThreadPoolConfig &config) {
+  std::shared_ptr<ThreadPool> old;
+  {
+    std::lock_guard<std::mutex> lock(defaultThreadPoolMutex_());
+    defaultThreadPoolConfig_() = config;
+    old.swap(defaultThreadPool_());
+  }
+  if (old && !old->stop) {
+    old->close();
+  }
+}
+
+/* The pool bound to this thread (see ThreadPoolScope), or the default pool. */
+inline ThreadPool &getThreadPool() {
+  if (ThreadPool::current()) {
+    return *ThreadPool::current();
   }
-  return *pool;
+  return *getDefaultThreadPool();
 }
 
 class ServerError : public std::runtime_error {
@@ -171,15 +179,40 @@ public:
     Server();
     virtual ~Server() { }
 
-    /* Set up logging, for debuggability and amusement. */
+    /* Set up logging, for debuggability and amusement: a text transcript
+     * of the games (see TextTranscriptObserver), or none if null. */
     void setLog(std::ostream *logStream);
 
+    /* Observers receive the events of every game this server runs (see
+     * ServerObserver.h), in the order they were added, after the text log.
+     * Snapshots do not keep them; restore() keeps this server's. */
+    void addObserver(std::shared_ptr<ServerObserver> observer);
+    void removeObserver(const std::shared_ptr<ServerObserver> &observer);
+
     /* Seed the random number generator. */
     void srand(unsigned int seed);
 
     /* Set the qa flag value. */
     void sqa(unsigned int qa);
 
+    /* The cards remaining in the deck at which the games started next ask
+     * their question, within questionRounds(); -1 picks it at random (see
+     * selectQuestionRound()). startGame() fixes it for the game. */
+    void setQuestionRound(int round) { questionRound_ = round; }
+    /* The fewest and the most cards remaining at which games of numPlayers
+     * players ask their question. */
+    std::pair<int, int> questionRounds(int numPlayers) const;
+
+    /* If stats is not null, the game loop times every move, observation
+     * callback and game into it (see LatencyStats.h). The caller keeps
+     * ownership; snapshots do not share it. */
+    void setLatencyStats(LatencyStats *stats) { latency_ = stats; }
+
+    /* Scoring and hand-size rules for this server. Defaults to the
+     * current RunParams when the server is constructed. */
+    void setParams(const HanabiParams::Config &params);
+    const HanabiParams::Config &params() const { return params_; }
+
     /* Set up a new game, using numPlayers player-bots as created
      * by repeated calls to botFactory.create(i,numPlayers). Then
      * run the game to its conclusion, and return the final score. */
@@ -192,14 +225,45 @@ public:
      * the game. */
     int runGame(const BotFactory &botFactory, int numPlayers, const std::vector<Card>& stackedDeck);
 
+    /* The deck that srand(seed) followed by runGame() would deal, as a
+     * stacked deck: games given it play out alike on any server. */
+    static std::vector<Card> shuffledDeck(unsigned int seed);
+
     /* Runs a game with an existing vector of bots. Caller is responsible
        for creating and deleting them.
     */
     int runGame(std::vector<Bot*>, const std::vector<Card>& stackedDeck);
 
+    /* Sets up a game as runGame() does, without playing any of it.
+     * Bots created from botFactory are owned by the server (so botFactory
+     * must outlive the game); otherwise they belong to the caller. */
+    void startGame(const BotFactory &botFactory, int numPlayers);
+    void startGame(std::vector<Bot*> players, const std::vector<Card>& stackedDeck);
+
     /* Runs an already set-up game to completion, and returns the score */
     int runToCompletion();
 
+    /* Runs an already set-up game until turn() reaches the given turn or
+     * the game ends, and returns the current score. */
+    int runToTurn(int turn);
+
+    /* The number of moves made so far in this game. */
+    int turn() const { return turn_; }
+
+    /* Saves the game as it stands between two turns: piles, hands, deck,
+     * stones, hints, the shuffling RNG and a clone() of every bot. The
+     * snapshot can be restored any number of times. */
+    ServerSnapshot snapshot() const;
+
+    /* Replaces the game on this server with a copy of the snapshot's, played
+     * by fresh clones of its bots, which this server owns. The log stream
+     * is kept. */
+    void restore(const ServerSnapshot &snapshot);
+
+    /* Shuffles the cards not yet drawn, e.g. so that continuations of the
+     * same snapshot play out differently. */
+    void shuffleDeck();
+
     void endGameByBombingOut();
 
     /* Returns the number of players in the game. */
@@ -207,6 +271,8 @@ public:
 
     /* Returns the starting hand size for this game. */
     int handSize() const;
+    /* ...or for a game of numPlayers. */
+    int handSize(int numPlayers) const;
 
     /* Returns the index of the player who is currently
      * querying the server. */
@@ -373,15 +439,41 @@ public:
     }
 
     int seed_;
-    int qa_;
+    int qa_ = 0;
+    int questionRound_ = -1;
+    /* of the current game, see setQuestionRound() */
+    int gameQuestionRound_ = -1;
+    bool questionAsked_ = false;
+    /* whether observers got onRunStart() for the current game */
+    bool runStarted_ = false;
     std::string moveExplanation;
 
     /*================= PRIVATE MEMBERS ======================*/
 protected:
     /* Administrivia */
     std::ostream *log_;
+    /* Latency accounting, see setLatencyStats() */
+    struct ObserveTimer;
+    LatencyStats *latency_ = nullptr;
+    double observeSecsInMove_ = 0;
+    std::chrono::steady_clock::time_point gameStart_;
+    bool gameEnded_ = false;
+    /* Event sinks, see addObserver(); the text log comes first */
+    std::shared_ptr<ServerObserver> logObserver_;
+    std::vector<std::shared_ptr<ServerObserver> > observers_;
+    template<class F> void notify_(const F &f) {
+        if (logObserver_) f(*logObserver_);
+        for (auto &observer : observers_) f(*observer);
+    }
+    HanabiParams::Config params_;
     std::mt19937 rand_;
+    /* draws the questions of qa games, see srand() */
+    std::mt19937 questionRand_;
     std::vector<Bot *> players_;
+    /* Bots created by startGame(botFactory) or restore(); otherwise
+     * players_ belong to the caller. */
+    std::vector<std::shared_ptr<Bot> > ownedPlayers_;
+    int turn_ = 0;
     int observingPlayer_;
     int activePlayer_;
     int movesFromActivePlayer_;
@@ -400,12 +492,10 @@ protected:
     std::vector<ServerHint> hints_;
 
     /* Private methods */
+    int run_(int stopAtTurn);
     Card draw_(void);
     void regainHintStoneIfPossible_(void);
     void loseMulligan_(void);
-    void logHands_(void) const;
-    void logAllHands_(void) const;
-    void logPiles_(void) const;
 };
 
 }  /* namespace Hanabi */
@@ -415,6 +505,32 @@ protected:
 
 namespace Hanabi {
 
+/* What a bot believes each player knows about his own hand, one trivalue per
+ * (player, slot, feature) in a caller-owned buffer laid out
+ * [numPlayers][handSize][NUM_KNOWLEDGE_FEATURES]. The features are "the card
+ * is this color" (5), "... this value" (5), then playable, valuable and
+ * worthless, in the order of the old handKnowledgeToMap() strings. */
+enum KnowledgeFeature {
+    KNOWLEDGE_COLOR = 0,                            /* + color */
+    KNOWLEDGE_VALUE = KNOWLEDGE_COLOR + NUMCOLORS,  /* + value - 1 */
+    KNOWLEDGE_PLAYABLE = KNOWLEDGE_VALUE + VALUE_MAX,
+    KNOWLEDGE_VALUABLE,
+    KNOWLEDGE_WORTHLESS,
+    NUM_KNOWLEDGE_FEATURES
+};
+enum : int8_t { KNOWLEDGE_NO, KNOWLEDGE_MAYBE, KNOWLEDGE_YES };
+
+struct HandKnowledgeTensor {
+    int8_t *data;
+    int numPlayers;
+    int handSize;
+
+    int8_t &at(int player, int slot, int feature) const {
+        assert(0 <= player && player < numPlayers && 0 <= slot && slot < handSize);
+        return data[(player * handSize + slot) * NUM_KNOWLEDGE_FEATURES + feature];
+    }
+};
+
 class Bot {
 public:
     virtual ~Bot();  /* virtual destructor */
@@ -428,10 +544,34 @@ public:
     virtual std::map<std::string, std::string> handKnowledgeToMap() {return std::map<std::string, std::string>(); };
     virtual void printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) {};
 
+    /* Write this bot's view of every player's hand knowledge into out, as of
+     * its last observation of server. Only the slots of cards currently in
+     * hand are written; the rest of out is left as it was. */
+    virtual void writeHandKnowledge(const Server &server, const HandKnowledgeTensor &out) const {
+      throw std::runtime_error("Not implemented.");
+    }
+
     /* Return a copy of this bot with identical state.
      * The clone object is unmanaged, and must be deleted by the caller. */
     virtual Bot *clone() const { throw std::runtime_error("Not implemented."); }
 
+    /* Append this bot's state to buf as plain bytes (see BotState.h).
+     * restoreState() on a bot of the same class then makes it behave exactly
+     * like this one (see countDivergentCopies()), so states can be
+     * checkpointed to disk instead of held as clones. restoreState()
+     * returns the number of bytes it read. The server a bot is attached to
+     * is not part of its state: it is picked up again on the next
+     * observation. */
+    virtual void saveState(std::string &buf) const { throw std::runtime_error("Not implemented."); }
+    virtual size_t restoreState(const char *data, size_t size) {
+      throw std::runtime_error("Not implemented.");
+    }
+
+    /* Approximate bytes held by this bot, for memory accounting (see
+     * measureRangeMemory). The default is the size of its saved state,
+     * or 0 if it cannot save it. */
+    virtual size_t memoryBytes() const;
+
     /* By default, Bots assume that they are playing with another copy of the
      * same Bot class, and may throw exceptions if that assumption is violated.
      * if permissive=true, then the Bot should degrade gracefully when 'confused'
@@ -457,9 +597,25 @@ public:
     virtual ~BotFactory() = default;
 };
 
+/* See Server::snapshot(). */
+class ServerSnapshot {
+public:
+    int turn() const { return server_->turn(); }
+    int numPlayers() const { return server_->numPlayers(); }
+    int currentScore() const { return server_->currentScore(); }
+
+private:
+    friend class Server;
+    /* a copy of the server, minus its players */
+    std::shared_ptr<const Server> server_;
+    std::vector<std::shared_ptr<const Bot> > bots_;
+};
+
 // simple registration of BotFactory's by string key
 void registerBotFactory(std::string name, std::shared_ptr<Hanabi::BotFactory> factory);
 std::shared_ptr<Hanabi::BotFactory> getBotFactory(const std::string &botName);
+/* The names of all registered bots, in sorted order. */
+std::vector<std::string> getBotNames();
 
 }  /* namespace Hanabi */
 
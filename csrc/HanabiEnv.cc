@@ -0,0 +1,270 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <algorithm>
+#include <stdexcept>
+#include "HanabiEnv.h"
+#include "HleUtils.h"
+
+using namespace Hanabi;
+
+
+/* The public information that HleSerializedMove encodes besides the board:
+ * the last move and the per-player card beliefs, kept as TorchBot does. */
+class HanabiEnv::Tracker {
+public:
+  explicit Tracker(const Server &server) {
+    for (int p = 0; p < server.numPlayers(); ++p) {
+      beliefs.emplace_back(server, p);
+    }
+  }
+
+  void beforeDiscardOrPlay(const Server &server, Move move, int from) {
+    lastMove = move;
+    lastActiveCard = (from == server.whoAmI()) ? server.activeCard() : server.handOfPlayer(from)[move.value];
+    playerAboutToDraw = from;
+  }
+  void hint(const Server &server, Move move, CardIndices card_indices) {
+    lastMove = move;
+    lastMoveIndices = card_indices;
+    beliefs[move.to].updateFromHint(move, card_indices, server);
+  }
+  void afterMove(const Server &server) {
+    if (playerAboutToDraw == -1) return;
+    DeckComposition deck = getCurrentDeckComposition(server, -1);
+    for (auto &belief : beliefs) {
+      belief.updateFromRevealedCard(lastActiveCard, deck, server);
+    }
+    beliefs[playerAboutToDraw].updateFromDraw(deck, lastMove.value, server);
+    playerAboutToDraw = -1;
+  }
+
+  HleSerializedMove frame(const Server &server) const {
+    return HleSerializedMove(server, lastMove, lastActiveCard, lastMoveIndices,
+                             prevScore, prevNumHint, beliefs);
+  }
+
+  std::vector<FactorizedBeliefs> beliefs;
+  Move lastMove = Move(INVALID_MOVE, 0);
+  Card lastActiveCard = Card(RED, 5);
+  CardIndices lastMoveIndices;
+  int prevScore = 0;
+  int prevNumHint = 0;
+  int playerAboutToDraw = -1;
+};
+
+/* A seat at the table: makes the agent's pending move, or lets its bot
+ * play. Seat 0 also keeps the tracker up to date. */
+class HanabiEnv::Seat final : public Bot {
+public:
+  explicit Seat(Bot *bot) : bot_(bot) {}
+
+  void pleaseObserveBeforeMove(const Server &server) override {
+    if (bot_) bot_->pleaseObserveBeforeMove(server);
+  }
+  void pleaseMakeMove(Server &server) override {
+    if (bot_) return bot_->pleaseMakeMove(server);
+    execute_(server.whoAmI(), pending, server);
+  }
+  void pleaseObserveBeforeDiscard(const Server &server, int from, int card_index) override {
+    if (bot_) bot_->pleaseObserveBeforeDiscard(server, from, card_index);
+    if (tracker) tracker->beforeDiscardOrPlay(server, Move(DISCARD_CARD, card_index), from);
+  }
+  void pleaseObserveBeforePlay(const Server &server, int from, int card_index) override {
+    if (bot_) bot_->pleaseObserveBeforePlay(server, from, card_index);
+    if (tracker) {
+      tracker->prevScore = server.currentScore();
+      tracker->prevNumHint = server.hintStonesRemaining();
+      tracker->beforeDiscardOrPlay(server, Move(PLAY_CARD, card_index), from);
+    }
+  }
+  void pleaseObserveColorHint(const Server &server, int from, int to, Color color, CardIndices card_indices) override {
+    if (bot_) bot_->pleaseObserveColorHint(server, from, to, color, card_indices);
+    if (tracker) tracker->hint(server, Move(HINT_COLOR, color, to), card_indices);
+  }
+  void pleaseObserveValueHint(const Server &server, int from, int to, Value value, CardIndices card_indices) override {
+    if (bot_) bot_->pleaseObserveValueHint(server, from, to, value, card_indices);
+    if (tracker) tracker->hint(server, Move(HINT_VALUE, value, to), card_indices);
+  }
+  void pleaseObserveAfterMove(const Server &server) override {
+    if (bot_) bot_->pleaseObserveAfterMove(server);
+    if (tracker) tracker->afterMove(server);
+  }
+
+  bool isAgent() const { return bot_ == nullptr; }
+
+  Move pending;
+  Tracker *tracker = nullptr;
+
+private:
+  Bot *bot_;
+};
+
+
+HanabiEnv::HanabiEnv(const std::vector<std::string> &seats, int seed, const RunParams &params)
+  : params_(params), server_(new EnvServer), seats_(seats)
+{
+  if (seats.size() < 2 || seats.size() > 5) {
+    throw std::runtime_error("HanabiEnv needs 2 to 5 seats.");
+  }
+  server_->setParams(params_.hanabi);
+  server_->setLog(nullptr);
+  server_->srand(seed);
+  this->reset();
+}
+
+HanabiEnv::~HanabiEnv() = default;
+
+void HanabiEnv::reset(int seed)
+{
+  if (seed >= 0) server_->srand(seed);
+  const int numPlayers = seats_.size();
+  const int handSize = server_->handSize(numPlayers);
+  players_.clear();
+  bots_.clear();
+  std::vector<Bot*> players;
+  /* bot factories read their params from the scope */
+  RunParamsScope scope(&params_);
+  for (int p = 0; p < numPlayers; ++p) {
+    Bot *bot = nullptr;
+    if (seats_[p] != "") {
+      auto botFactory = getBotFactory(seats_[p]);
+      bot = botFactory->create(p, numPlayers, handSize);
+      bot->setPermissive(true);
+      bots_.emplace_back(bot, [botFactory](Bot *b) { botFactory->destroy(b); });
+    }
+    players_.emplace_back(new Seat(bot));
+    players.push_back(players_.back().get());
+  }
+  server_->startGame(players, std::vector<Card>());
+  tracker_.reset(new Tracker(*server_));
+  players_[0]->tracker = tracker_.get();
+  this->advance_();
+  observationSize_ = tracker_->frame(*server_).size();
+}
+
+void HanabiEnv::advance_()
+{
+  while (!server_->gameOver() && !players_[server_->activePlayer()]->isAgent()) {
+    server_->runToTurn(server_->turn() + 1);
+  }
+  server_->observeAsActivePlayer();
+}
+
+int HanabiEnv::step(const Move &move)
+{
+  if (this->done()) {
+    throw std::runtime_error("The game is over: call reset().");
+  }
+  const std::vector<Move> legal = this->legalMoves();
+  if (std::find(legal.begin(), legal.end(), move) == legal.end()) {
+    throw std::runtime_error("Illegal move: " + move.toString());
+  }
+  const int before = server_->currentScore();
+  players_[server_->activePlayer()]->pending = move;
+  server_->runToTurn(server_->turn() + 1);
+  this->advance_();
+  return server_->currentScore() - before;
+}
+
+int HanabiEnv::step(int moveIndex)
+{
+  for (const Move &move : this->legalMoves()) {
+    if (moveToIndex(move, *server_) == moveIndex) return this->step(move);
+  }
+  throw std::runtime_error("Illegal move index: " + std::to_string(moveIndex));
+}
+
+std::vector<Move> HanabiEnv::legalMoves() const
+{
+  if (this->done()) return {};
+  return enumerateLegalMoves(*server_);
+}
+
+int HanabiEnv::numMoves() const
+{
+  /* as HleSerializedMove::numMoves(): discards, plays, hints, and a no-op */
+  return 2 * server_->handSize() + (this->numPlayers() - 1) * (NUMCOLORS + VALUE_MAX) + 1;
+}
+
+void HanabiEnv::writeLegalMask(float *out) const
+{
+  std::fill(out, out + this->numMoves(), 0.0f);
+  for (const Move &move : this->legalMoves()) {
+    out[moveToIndex(move, *server_)] = 1.0f;
+  }
+}
+
+void HanabiEnv::writeObservation(float *out) const
+{
+  tracker_->frame(*server_).writeTo(out);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////    HanabiVecEnv    //////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+HanabiVecEnv::HanabiVecEnv(int numEnvs, const std::vector<std::string> &seats, int seed, bool parallel,
+                           const RunParams &params)
+  : parallel_(parallel)
+{
+  if (numEnvs < 1) {
+    throw std::runtime_error("HanabiVecEnv needs at least one game.");
+  }
+  if (std::find(seats.begin(), seats.end(), "") == seats.end()) {
+    throw std::runtime_error("HanabiVecEnv needs at least one agent seat.");
+  }
+  for (int i = 0; i < numEnvs; ++i) {
+    envs_.emplace_back(new HanabiEnv(seats, seed + i, params));
+  }
+}
+
+template<class F>
+void HanabiVecEnv::forEach_(F f)
+{
+  const int n = envs_.size();
+  const int chunks = parallel_ ? std::min<int>(n, getThreadPool().config().threads) : 1;
+  if (chunks <= 1) {
+    for (int i = 0; i < n; ++i) f(i);
+    return;
+  }
+  std::vector<boost::fibers::future<void>> futures;
+  for (int c = 0; c < chunks; ++c) {
+    futures.push_back(getThreadPool().enqueue([&, c]() {
+      for (int i = c * n / chunks; i < (c + 1) * n / chunks; ++i) f(i);
+    }));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+}
+
+void HanabiVecEnv::observe_(int i, float *obs, float *masks) const
+{
+  envs_[i]->writeObservation(obs + i * observationSize());
+  envs_[i]->writeLegalMask(masks + i * numMoves());
+}
+
+void HanabiVecEnv::reset(float *obs, float *masks)
+{
+  this->forEach_([&](int i) {
+    envs_[i]->reset();
+    this->observe_(i, obs, masks);
+  });
+}
+
+void HanabiVecEnv::step(const int *moves, float *obs, float *masks, int *rewards, bool *dones, int *scores)
+{
+  this->forEach_([&](int i) {
+    HanabiEnv &env = *envs_[i];
+    rewards[i] = env.step(moves[i]);
+    dones[i] = env.done();
+    scores[i] = dones[i] ? env.score() : -1;
+    if (dones[i]) env.reset();
+    this->observe_(i, obs, masks);
+  });
+}
@@ -0,0 +1,106 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "Hanabi.h"
+#include "BotUtils.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/* A synchronous Hanabi environment for RL agents. reset() deals a game and
+ * step(move) makes the move for the agent seat whose turn it is, then lets
+ * the bot seats play until it is an agent seat's turn again or the game is
+ * over. The game runs on the caller's thread, one Server::runToTurn() at a
+ * time: no threads and no handoffs, unlike PyBot.
+ *
+ * Between steps the server is observed from the active player's seat, and
+ * observations use the same encoding as TorchBot (HleSerializedMove), with
+ * moves indexed as by moveToIndex(). */
+class HanabiEnv {
+  /* Lets the env observe the game from the seat about to move. */
+  class EnvServer : public Hanabi::Server {
+  public:
+    void observeAsActivePlayer() { observingPlayer_ = activePlayer_; }
+  };
+
+public:
+  /* One entry per seat: "" for a seat played by the caller, otherwise the
+   * name of the (permissive) bot that plays it. The server and the bots of
+   * every game use params. */
+  explicit HanabiEnv(const std::vector<std::string> &seats, int seed=1,
+                     const RunParams &params=RunParams::current());
+  ~HanabiEnv();
+
+  /* Deals the next game (reseeding first if seed >= 0). */
+  void reset(int seed=-1);
+  /* Makes a legal move for the active agent seat; returns the reward, i.e.
+   * the change of score until the next agent turn. */
+  int step(const Move &move);
+  /* The same, with the move given by its index (see numMoves()). */
+  int step(int moveIndex);
+
+  bool done() const { return server_->gameOver(); }
+  int activePlayer() const { return server_->activePlayer(); }
+  int score() const { return server_->currentScore(); }
+  int numPlayers() const { return seats_.size(); }
+  const Hanabi::Server &server() const { return *server_; }
+
+  std::vector<Move> legalMoves() const;
+  /* Number of move indices, and 1.0 at the index of each legal move. */
+  int numMoves() const;
+  void writeLegalMask(float *out) const;
+  /* Number of features of an observation, and the observation itself. */
+  size_t observationSize() const { return observationSize_; }
+  void writeObservation(float *out) const;
+
+private:
+  class Seat;
+  class Tracker;
+
+  void advance_();
+
+  RunParams params_;
+  std::unique_ptr<EnvServer> server_;
+  std::vector<std::string> seats_;
+  std::vector<std::shared_ptr<Hanabi::Bot> > bots_;
+  std::vector<std::unique_ptr<Seat> > players_;
+  std::unique_ptr<Tracker> tracker_;
+  size_t observationSize_ = 0;
+};
+
+/* numEnvs HanabiEnvs stepped together, for collecting RL data. Game i is
+ * seeded seed + i, and a game that ends is dealt again at once, so every
+ * game always has an agent seat to move. Outputs are stacked into caller
+ * buffers: observations [numEnvs][observationSize()] and legal masks
+ * [numEnvs][numMoves()]. If parallel, the games are stepped in chunks on the
+ * thread pool (see getThreadPool()). */
+class HanabiVecEnv {
+public:
+  HanabiVecEnv(int numEnvs, const std::vector<std::string> &seats, int seed=1, bool parallel=true,
+               const RunParams &params=RunParams::current());
+
+  int size() const { return envs_.size(); }
+  int numMoves() const { return envs_[0]->numMoves(); }
+  size_t observationSize() const { return envs_[0]->observationSize(); }
+  HanabiEnv &env(int i) { return *envs_.at(i); }
+
+  /* Deals every game again. */
+  void reset(float *obs, float *masks);
+  /* Makes move index moves[i] in game i. rewards[i] is its reward, and
+   * dones[i] is set if its game ended, in which case scores[i] is the final
+   * score and obs/masks describe the next game; otherwise scores[i] is -1. */
+  void step(const int *moves, float *obs, float *masks, int *rewards, bool *dones, int *scores);
+
+private:
+  template<class F> void forEach_(F f);
+  void observe_(int i, float *obs, float *masks) const;
+
+  bool parallel_;
+  std::vector<std::unique_ptr<HanabiEnv> > envs_;
+};
@@ -14,6 +14,8 @@
 #include <string>
 #include <vector>
 #include "Hanabi.h"
+#include "LatencyStats.h"
+#include "ServerObserver.h"
 
 #ifdef HANABI_SERVER_NDEBUG
 #define HANABI_SERVER_ASSERT(x, msg) (void)0
@@ -51,47 +53,6 @@ float getParameterFloat(const std::string &name, float default_val, const std::s
 }
 
 
-using namespace HanabiParams;
-
-static std::string nth(int n, int total)
-{
-    if (total == 5) {
-        switch (n) {
-            case 0: return "O";
-            case 1: return "SO";
-            case 2: return "M";
-            case 3: return "SN";
-            default: assert(n == 4); return "N";
-        }
-    } else if (total == 4) {
-        switch (n) {
-            case 0: return "O";
-            case 1: return "SO";
-            case 2: return "SN";
-            default: assert(n == 3); return "N";
-        }
-    } else {
-        switch (n) {
-            case 0: return "O";
-            case 1: return "M";
-            default: assert(n == 2); return "N";
-        }
-    }
-}
-
-static std::string nth(const Hanabi::CardIndices& ns, int total)
-{
-    std::string result;
-    assert(!ns.empty());
-    switch (ns.size()) {
-        case 1: return nth(ns[0], total);
-        case 2: return nth(ns[0], total) + ", " + nth(ns[1], total);
-        case 3: return nth(ns[0], total) + ", " + nth(ns[1], total) + ", " + nth(ns[2], total);
-        default:
-            assert(ns.size() == 4);
-            return nth(ns[0], total) + ", " + nth(ns[1], total) + ", " + nth(ns[2], total) + ", " + nth(ns[3], total);
-    }
-}
 
 static std::string colorname(Hanabi::Color color)
 {
@@ -147,8 +108,18 @@ void Pile::increment_()
 /* virtual destructor */
 Bot::~Bot() { }
 
+size_t Bot::memoryBytes() const {
+    std::string buf;
+    try {
+        saveState(buf);
+    } catch (const std::runtime_error &) {
+        return 0;
+    }
+    return buf.size();
+}
+
 /* Hanabi::Card has no default constructor */
-Server::Server(): log_(nullptr), activeCard_(RED,1) { }
+Server::Server(): log_(nullptr), params_(RunParams::current().hanabi), activeCard_(RED,1) { }
 
 bool Server::gameOver() const
 {
@@ -164,7 +135,7 @@ bool Server::gameOver() const
 
 int Server::currentScore() const
 {
-    if(mulligansRemaining_ == 0 && BOMB0) {
+    if(mulligansRemaining_ == 0 && params_.BOMB0) {
       return 0;
     }
 
@@ -177,7 +148,7 @@ int Server::currentScore() const
     }
     // add a little penalty to discouurage mulligans based on equivalent choices
     if (mulligansRemaining_ == 0) {
-      sum = std::max(sum - BOMBD, 0);
+      sum = std::max(sum - params_.BOMBD, 0);
     }
     return sum;
 }
@@ -185,12 +156,30 @@ int Server::currentScore() const
 void Server::setLog(std::ostream *logStream)
 {
     this->log_ = logStream;
+    if (logStream) {
+        logObserver_ = std::make_shared<TextTranscriptObserver>(logStream);
+    } else {
+        logObserver_.reset();
+    }
+}
+
+void Server::addObserver(std::shared_ptr<ServerObserver> observer)
+{
+    observers_.push_back(std::move(observer));
+}
+
+void Server::removeObserver(const std::shared_ptr<ServerObserver> &observer)
+{
+    observers_.erase(std::remove(observers_.begin(), observers_.end(), observer), observers_.end());
 }
 
 void Server::srand(unsigned int seed)
 {
     this->seed_ = seed;
     this->rand_.seed(seed);
+    /* a stream of its own, so that asking questions leaves the decks be */
+    std::seed_seq questionSeed{seed, 1u};
+    this->questionRand_.seed(questionSeed);
 }
 
 void Server::sqa(unsigned int qa) 
@@ -198,6 +187,11 @@ void Server::sqa(unsigned int qa)
     this->qa_ = qa;
 }
 
+void Server::setParams(const HanabiParams::Config &params)
+{
+    this->params_ = params;
+}
+
 template<class It, class Gen>
 static void portable_shuffle(It first, It last, Gen& g)
 {
@@ -211,6 +205,29 @@ static void portable_shuffle(It first, It last, Gen& g)
     }
 }
 
+/* Every card of the game, unshuffled. */
+static std::vector<Card> fullDeck()
+{
+    std::vector<Card> deck;
+    for (Color color = RED; color <= BLUE; ++color) {
+        for (int value = 1; value <= 5; ++value) {
+            const Card card(color, value);
+            const int n = card.count();
+            for (int k=0; k < n; ++k) deck.push_back(card);
+        }
+    }
+    return deck;
+}
+
+std::vector<Card> Server::shuffledDeck(unsigned int seed)
+{
+    std::mt19937 rand(seed);
+    std::vector<Card> deck = fullDeck();
+    portable_shuffle(deck.begin(), deck.end(), rand);
+    std::reverse(deck.begin(), deck.end());  /* top card first, as runGame() takes it */
+    return deck;
+}
+
 int Server::runGame(const BotFactory &botFactory, int numPlayers)
 {
     return this->runGame(botFactory, numPlayers, std::vector<Card>());
@@ -232,9 +249,30 @@ int Server::runGame(const BotFactory &botFactory, int numPlayers, const std::vec
 
 int Server::runGame(std::vector<Bot*> players, const std::vector<Card>& stackedDeck)
 {
-    std::cerr << "Start game" << std::endl;
+    this->startGame(players, stackedDeck);
+    return this->runToCompletion();
+}
+
+void Server::startGame(const BotFactory &botFactory, int numPlayers)
+{
+    numPlayers_ = numPlayers;
+    std::vector<Bot*> players(numPlayers);
+    std::vector<std::shared_ptr<Bot> > owned(numPlayers);
+    for (int i=0; i < numPlayers; ++i) {
+        players[i] = botFactory.create(i, numPlayers, handSize());
+        owned[i].reset(players[i], [&botFactory](Bot *bot) { botFactory.destroy(bot); });
+    }
+    this->startGame(players, std::vector<Card>());
+    ownedPlayers_ = owned;
+}
+
+void Server::startGame(std::vector<Bot*> players, const std::vector<Card>& stackedDeck)
+{
+    gameStart_ = std::chrono::steady_clock::now();
+    gameEnded_ = false;
     /* Create and initialize the bots. */
     players_ = players;
+    ownedPlayers_.clear();
     numPlayers_ = players.size();
     const int initialHandSize = this->handSize();
 
@@ -252,14 +290,7 @@ int Server::runGame(std::vector<Bot*> players, const std::vector<Card>& stackedD
         deck_ = stackedDeck;
         std::reverse(deck_.begin(), deck_.end());  /* because we pull cards from the "top" (back) of the vector */
     } else {
-        deck_.clear();
-        for (Color color = RED; color <= BLUE; ++color) {
-            for (int value = 1; value <= 5; ++value) {
-                const Card card(color, value);
-                const int n = card.count();
-                for (int k=0; k < n; ++k) deck_.push_back(card);
-            }
-        }
+        deck_ = fullDeck();
         portable_shuffle(deck_.begin(), deck_.end(), rand_);
     }
 #ifdef CARD_ID
@@ -269,6 +300,7 @@ int Server::runGame(std::vector<Bot*> players, const std::vector<Card>& stackedD
     }
 #endif
     discards_.clear();
+    hints_.clear();
 
     /* Secretly draw the starting hands. */
     hands_.resize(numPlayers_);
@@ -279,30 +311,105 @@ int Server::runGame(std::vector<Bot*> players, const std::vector<Card>& stackedD
         }
     }
 
-    /* Run the game. */
     activeCardIsObservable_ = false;
     activePlayer_ = 0;
     movesFromActivePlayer_ = -1;
-    int score = this->runToCompletion();
+    turn_ = 0;
+    /* once per game, so that runToTurn() prefixes and their continuations
+     * (or forks) agree on where the question is */
+    gameQuestionRound_ = qa_ ? (questionRound_ >= 0 ? questionRound_ : selectQuestionRound()) : -1;
+    questionAsked_ = false;
+    runStarted_ = false;
+    notify_([&](ServerObserver &o) { o.onDeal(*this); });
+}
+
+namespace {
 
-    return score;
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
+}  // namespace
+
+/* Times one observation callback of player into latency_, if any. */
+struct Server::ObserveTimer {
+    ObserveTimer(Server &server, int player) : server_(server), player_(player) {
+        if (server_.latency_) start_ = std::chrono::steady_clock::now();
+    }
+    ~ObserveTimer() {
+        if (!server_.latency_) return;
+        const double secs = secondsSince(start_);
+        server_.latency_->observeOf(player_).add(secs);
+        server_.observeSecsInMove_ += secs;
+    }
+    Server &server_;
+    int player_;
+    std::chrono::steady_clock::time_point start_;
+};
+
 int Server::runToCompletion() {
+  return this->run_(-1);
+}
 
-  std::string prevHands = "";
-  int questionRound = selectQuestionRound(); // Select the round to generate the question
-  if (log_) {
-    *log_ << this->cardsRemainingInDeck() << " cards remaining" << std::endl;
-  }
+int Server::runToTurn(int turn) {
+  return this->run_(turn);
+}
 
-  while (!this->gameOver()) {
-    if (activePlayer_ == 0 && prevHands != this->handsAsStringWithoutPlayer0()) {
-        this->logHands_();
-        prevHands = this->handsAsStringWithoutPlayer0();
+ServerSnapshot Server::snapshot() const
+{
+    HANABI_SERVER_ASSERT(movesFromActivePlayer_ == -1, "can only snapshot between turns");
+    ServerSnapshot result;
+    auto copy = std::make_shared<Server>(*this);
+    copy->log_ = nullptr;
+    copy->logObserver_.reset();
+    copy->observers_.clear();
+    copy->latency_ = nullptr;
+    copy->players_.clear();
+    copy->ownedPlayers_.clear();
+    result.server_ = copy;
+    for (Bot *bot : players_) {
+        result.bots_.push_back(std::shared_ptr<const Bot>(bot->clone()));
     }
+    return result;
+}
+
+void Server::restore(const ServerSnapshot &snapshot)
+{
+    std::ostream *log = log_;
+    auto logObserver = logObserver_;
+    auto observers = observers_;
+    LatencyStats *latency = latency_;
+    *this = *snapshot.server_;
+    log_ = log;
+    logObserver_ = logObserver;
+    observers_ = observers;
+    latency_ = latency;
+    for (auto &bot : snapshot.bots_) {
+        ownedPlayers_.push_back(std::shared_ptr<Bot>(bot->clone()));
+        players_.push_back(ownedPlayers_.back().get());
+    }
+}
+
+void Server::shuffleDeck()
+{
+    portable_shuffle(deck_.begin(), deck_.end(), rand_);
+}
+
+int Server::run_(int stopAtTurn) {
+
+  const int questionRound = gameQuestionRound_;
+  if (!runStarted_) {
+    runStarted_ = true;
+    notify_([&](ServerObserver &o) { o.onRunStart(*this); });
+  }
+
+  /* the question ends the game, short of gameOver() */
+  while (!this->gameOver() && !questionAsked_) {
+    if (stopAtTurn >= 0 && turn_ >= stopAtTurn) break;
+    notify_([&](ServerObserver &o) { o.onTurnStart(*this); });
     for (int i=0; i < numPlayers_; ++i) {
         observingPlayer_ = i;
+        ObserveTimer timer(*this, i);
         players_[i]->pleaseObserveBeforeMove(*this);
     }
     observingPlayer_ = activePlayer_;
@@ -311,114 +418,56 @@ int Server::runToCompletion() {
     //Update value of hints for consistency
     this->pleaseUpdateValuableHints();
 
-    //In-game Q&A logic for the agent's own cards (answers based on common knowledge that can be inferred from the game state -i.e. not every bot should know the correct answer)
-    if (this->qa_ == 1) {
-        if (this->cardsRemainingInDeck() <= questionRound && activePlayer_ == 0) {
-            // Question question = this->generateRandomQuestion();
-            // Answer answer = processQuestion(question);
-            //std::map<std::string, std::string> handKnowledgeMain = players_[activePlayer_]->handKnowledgeToMap();
-            //std::map<std::string, std::string> handKnowledgePartner = players_[activePlayer_+1]->handKnowledgeToMap();
-            // if (question.getType() == Question::Type::COLOR) {
-            //     (*log_) << "Is your " 
-            //             << nth(question.getCardPosition(), sizeOfHandOfPlayer(activePlayer_)) << " card "
-            //             << colorname(question.getColor()) << "?\n";
-            // } else {
-            //     (*log_) << "Is your " 
-            //             << nth(question.getCardPosition(), sizeOfHandOfPlayer(activePlayer_)) << " card a "
-            //             << question.getNumber() << "?\n";
-            // }
-            // (*log_) << "answer: " << answer.answerAsString() << "\n";
-            //Log different variables for data analysis later on
-            // (*log_) << "hand_knowledge P" << activePlayer_ << ": \n";  
-            // players_[activePlayer_]->printHandKnowledge(handKnowledgeMain);
-            // (*log_) << "hand_knowledge P" << activePlayer_+1 << ": \n";
-            // players_[activePlayer_+1]->printHandKnowledge(handKnowledgePartner);
-            this->logAllHands_();
-            this->logPiles_();
-            (*log_) << "discards: " << this->discardsAsString()<< "\n"; 
-            (*log_) << "cards_remaining: " << this->cardsRemainingInDeck() << "\n";
-            // (*log_) << "question_position: " << nth(question.getCardPosition(), sizeOfHandOfPlayer(activePlayer_)) << "\n";
-            // if (question.getType() == Question::Type::COLOR) {
-            //     (*log_) << "question_value: " << colorname(question.getColor()) << "\n";
-            // } else {
-            //     (*log_) << "question_value: " << question.getNumber() << "\n";
-            // }
-            // End the game after generating the question and logging the answer
-            break;
-        } 
-    //In-game Q&A logic for the partner's cards
-    } else if (this->qa_ == 2) {
-        if (this->cardsRemainingInDeck() <= questionRound && activePlayer_ == 0) {
+    //In-game Q&A: once questionRound or fewer cards remain, ask a question in place of player 0's move, and end the game there
+    if (this->qa_ >= 1 && this->qa_ <= 5 && this->cardsRemainingInDeck() <= questionRound && activePlayer_ == 0) {
+        QuestionEvent event;
+        event.qa = this->qa_;
+        event.questionRound = questionRound;
+        if (this->qa_ == 2) {
+            //In-game Q&A logic for the partner's cards
             Question question = this->generateRandomQuestion();
             //Look at relevant card in P1's hand
             Card answer_card = cheatGetHand(1)[question.getCardPosition()];
-            if (question.getType() == Question::Type::COLOR) {
-                (*log_) << "Is the " 
-                        << nth(question.getCardPosition(), sizeOfHandOfPlayer(activePlayer_)) << " card of P1 "
-                        << colorname(question.getColor()) << "?\n";
-                (*log_) << "answer: " << ((answer_card.color == question.getColor()) ? "Yes" : "No") << "\n";
-            } else {
-                (*log_) << "Is the " 
-                        << nth(question.getCardPosition(), sizeOfHandOfPlayer(activePlayer_)) << " card of P1 a "
-                        << question.getNumber() << "?\n";
-                (*log_) << "answer: " << ((int(answer_card.value) == question.getNumber()) ? "Yes" : "No") << "\n";
-
-            }
-            //Log different variables for dataset analysis later on
-            (*log_) << "cards_remaining: " << questionRound << "\n";
-            (*log_) << "question_position: " << nth(question.getCardPosition(), sizeOfHandOfPlayer(activePlayer_)) << "\n";
-            if (question.getType() == Question::Type::COLOR) {
-                (*log_) << "question_value: " << colorname(question.getColor()) << "\n";
+            event.cardPosition = question.getCardPosition();
+            event.isColor = (question.getType() == Question::Type::COLOR);
+            if (event.isColor) {
+                event.color = question.getColor();
+                event.answer = (answer_card.color == question.getColor());
             } else {
-                (*log_) << "question_value: " << question.getNumber() << "\n";
+                event.value = question.getNumber();
+                event.answer = (int(answer_card.value) == question.getNumber());
             }
-            // End the game after generating the question and logging the answer
-            break;
-        }
-    //In-game Q&A logic for piles
-    } else if (this->qa_ == 3) {
-        if (this->cardsRemainingInDeck() <= questionRound && activePlayer_ == 0) {
-            Color pile_color = this->generatePileQuestion();
-            //Look at the current size of the pile
-            int pile_score = pileOf(pile_color).size_;
-            (*log_) << "What is the current score of the " 
-                    << colorname(pile_color) << " pile?" << "\n";
-            (*log_) << "answer: " << pile_score << "\n";
-            //Log different variables for dataset analysis later on
-            (*log_) << "cards_remaining: " << questionRound << "\n";
-            (*log_) << "question_pile: " << colorname(pile_color) << "\n";
-
-            // End the game after generating the question and logging the answer
-            break;
-        }
-    //In-game Q&A logic for discards
-    } else if (this->qa_ == 4) {
-        if (this->cardsRemainingInDeck() <= questionRound && activePlayer_ == 0) {
+        } else if (this->qa_ == 3) {
+            //In-game Q&A logic for piles: the current size of the pile
+            event.color = this->generatePileQuestion();
+            event.answer = pileOf(event.color).size_;
+        } else if (this->qa_ == 4) {
+            //In-game Q&A logic for discards: how many copies of the card were discarded
             Card discard_card = this->generateDiscardQuestion();
-            //Look at the discards of the card
-            int num_discards = std::count(discards_.begin(), discards_.end(), discard_card);
-            (*log_) << "How many " 
-                    << int(discard_card.value) << colorname(discard_card.color)
-                    << " cards have been discarded?" << "\n";
-            (*log_) << "answer: " << num_discards << "\n";
-            //Log different variables for dataset analysis later on
-            (*log_) << "cards_remaining: " << questionRound << "\n";
-
-            // End the game after generating the question and logging the answer
-            break;
-        }
-    //In-game Q&A logic for cards remaining in deck
-    } else if (this->qa_ == 5) {
-        if (this->cardsRemainingInDeck() <= questionRound && activePlayer_ == 0) {
-            (*log_) << "How many cards are currently remaining in the deck?" << "\n";
-            (*log_) << "answer: " << this->cardsRemainingInDeck() << "\n";
-
-            // End the game after generating the question and logging the answer
-            break;
+            event.color = discard_card.color;
+            event.value = discard_card.value;
+            event.answer = std::count(discards_.begin(), discards_.end(), discard_card);
+        } else if (this->qa_ == 5) {
+            //In-game Q&A logic for cards remaining in deck
+            event.answer = this->cardsRemainingInDeck();
         }
+        //qa 1 asks about the agent's own cards: observers log the whole state
+        notify_([&](ServerObserver &o) { o.onQuestion(*this, event); });
+        // End the game after generating the question and logging the answer,
+        // between turns: player 0 never moves
+        questionAsked_ = true;
+        movesFromActivePlayer_ = -1;
+        break;
     }
 
+    observeSecsInMove_ = 0;
+    const auto moveStart = latency_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
     players_[activePlayer_]->pleaseMakeMove(*this);  /* make a move */
+    if (latency_) {
+        /* the decision only: the move's observation callbacks are timed apart */
+        latency_->moveOf(activePlayer_).add(secondsSince(moveStart) - observeSecsInMove_);
+    }
+    ++turn_;
     //(*log_) << moveExplanation << "\n";
     
     // added this short-circuit in case you forcibly end the game, toa void asserts and waiting
@@ -428,18 +477,25 @@ int Server::runToCompletion() {
     movesFromActivePlayer_ = -1;
     for (int i=0; i < numPlayers_; ++i) {
         observingPlayer_ = i;
+        ObserveTimer timer(*this, i);
         players_[i]->pleaseObserveAfterMove(*this);
     }
     activePlayer_ = (activePlayer_ + 1) % numPlayers_;
     assert(0 <= finalCountdown_ && finalCountdown_ <= numPlayers_);
     if (deck_.empty()) {
         if (finalCountdown_ == 0) {
-            (*log_) << "0 Cards Remaining\n";
+            notify_([&](ServerObserver &o) { o.onFinalRound(*this); });
         }
         finalCountdown_ += 1;
     }
   }
 
+  if ((this->gameOver() || questionAsked_) && !gameEnded_) {
+    gameEnded_ = true;
+    if (latency_) latency_->game.add(secondsSince(gameStart_));
+    const int score = this->currentScore();
+    notify_([&](ServerObserver &o) { o.onGameEnd(*this, score); });
+  }
   return this->currentScore();
 }
 
@@ -454,7 +510,12 @@ int Server::numPlayers() const
 
 int Server::handSize() const
 {
-    return HAND_SIZE_OVERRIDE >= 0 ? HAND_SIZE_OVERRIDE : ((numPlayers_ <= 3) ? 5 : 4);
+    return this->handSize(numPlayers_);
+}
+
+int Server::handSize(int numPlayers) const
+{
+    return params_.HAND_SIZE_OVERRIDE >= 0 ? params_.HAND_SIZE_OVERRIDE : ((numPlayers <= 3) ? 5 : 4);
 }
 
 int Server::whoAmI() const
@@ -714,6 +775,7 @@ void Server::pleaseDiscard(int index)
     int oldObservingPlayer = observingPlayer_;
     for (int i=0; i < numPlayers_; ++i) {
         observingPlayer_ = i;
+        ObserveTimer timer(*this, i);
         players_[i]->pleaseObserveBeforeDiscard(*this, activePlayer_, index);
     }
     observingPlayer_ = oldObservingPlayer;
@@ -722,17 +784,7 @@ void Server::pleaseDiscard(int index)
     /* Discard the selected card. */
     discards_.push_back(discardedCard);
 
-    if (log_) {
-        if (activePlayer_ == 0) {
-            (*log_) << "You" 
-                << " discarded your " << nth(index, hands_[activePlayer_].size())
-                << " card (" << discardedCard.toString() << "). ";
-        } else {
-            (*log_) << "P" << activePlayer_
-                << " discarded his " << nth(index, hands_[activePlayer_].size())
-                << " card (" << discardedCard.toString() << "). ";
-        }
-    }
+    notify_([&](ServerObserver &o) { o.onDiscard(*this, activePlayer_, index, discardedCard); });
 
     /* Shift the old cards down, and draw a replacement if possible. */
     hands_[activePlayer_].erase(hands_[activePlayer_].begin() + index);
@@ -740,18 +792,12 @@ void Server::pleaseDiscard(int index)
     if (mulligansRemaining_ > 0 && !deck_.empty()) {
         Card replacementCard = this->draw_();
         hands_[activePlayer_].push_back(replacementCard);
-        if (log_) {
-            if (activePlayer_ == 0) {
-                (*log_) << "You drew a card\n";
-            } else {
-                (*log_) << "P" << activePlayer_
-                    << " drew card " << replacementCard.toString() << "\n";
-            }   
-        }
+        notify_([&](ServerObserver &o) { o.onDraw(*this, activePlayer_, replacementCard); });
     }
 
     regainHintStoneIfPossible_();
     movesFromActivePlayer_ = 1;
+    notify_([&](ServerObserver &o) { o.onMoveEnd(*this, activePlayer_); });
 
     //Hint logic. It only affects the hints vector so it does not matter where in pleaseDiscard() it is updated
     this->pleaseUpdateValuableHintsAfterPlay(index);
@@ -775,6 +821,7 @@ void Server::pleasePlay(int index)
     int oldObservingPlayer = observingPlayer_;
     for (int i=0; i < players_.size(); ++i) {
         observingPlayer_ = i;
+        ObserveTimer timer(*this, i);
         players_[i]->pleaseObserveBeforePlay(*this, activePlayer_, index);
     }
     observingPlayer_ = oldObservingPlayer;
@@ -783,17 +830,9 @@ void Server::pleasePlay(int index)
     /* Examine the selected card. */
     Pile &pile = piles_[(int)selectedCard.color];
 
-    if (pile.nextValueIs(selectedCard.value)) {
-        if (log_) {
-            if (activePlayer_ == 0) {
-                (*log_) << "You played your " << nth(index, hands_[activePlayer_].size())
-                    << " card (" << selectedCard.toString() << "). ";
-            } else {
-                (*log_) << "P" << activePlayer_
-                    << " played his " << nth(index, hands_[activePlayer_].size())
-                    << " card (" << selectedCard.toString() << "). ";
-            }
-        }
+    const bool success = pile.nextValueIs(selectedCard.value);
+    notify_([&](ServerObserver &o) { o.onPlay(*this, activePlayer_, index, selectedCard, success); });
+    if (success) {
         pile.increment_();
         if (selectedCard.value == 5) {
             /* Successfully playing a 5 regains a hint stone. */
@@ -801,18 +840,6 @@ void Server::pleasePlay(int index)
         }
     } else {
         /* The card was unplayable! */
-        if (log_) {
-            if (activePlayer_ == 0) {
-                (*log_) << "You played your " << nth(index, hands_[activePlayer_].size())
-                    << " card (" << selectedCard.toString() << ")"
-                    << " but failed. ";
-            } else {
-                (*log_) << "P" << activePlayer_
-                    << " played his " << nth(index, hands_[activePlayer_].size())
-                    << " card (" << selectedCard.toString() << ")"
-                    << " but failed. ";
-            }
-        }
         discards_.push_back(selectedCard);
         loseMulligan_();
     }
@@ -823,21 +850,11 @@ void Server::pleasePlay(int index)
     if (mulligansRemaining_ > 0 && !deck_.empty()) {
         Card replacementCard = this->draw_();
         hands_[activePlayer_].push_back(replacementCard);
-        if (log_) {
-            if (activePlayer_ == 0) {
-                (*log_) << "You drew a card\n";
-            } else {
-                (*log_) << "P" << activePlayer_
-                    << " drew card " << replacementCard.toString() << "\n";
-            }   
-        }
-    } else {
-        (*log_) << "\n";
+        notify_([&](ServerObserver &o) { o.onDraw(*this, activePlayer_, replacementCard); });
     }
 
-    this->logPiles_();
-
     movesFromActivePlayer_ = 1;
+    notify_([&](ServerObserver &o) { o.onMoveEnd(*this, activePlayer_); });
 
     //Hint logic. It only affects the hints vector so it does not matter where in pleasePlay() it is updated
     this->pleaseUpdateValuableHintsAfterPlay(index);
@@ -865,31 +882,7 @@ void Server::pleaseGiveColorHint(int to, Color color)
     HANABI_SERVER_ASSERT(!card_indices.empty(), "hint must include at least one card");
 #endif
 
-    if (log_) {
-        const bool singular = (card_indices.size() == 1);
-        if (activePlayer_ == 0) {
-            // LLM player gives hint
-            (*log_) << "You told P" << to;
-        } else if (to == 0) {
-            // Hint given to LLM player
-            (*log_) << "P" << activePlayer_ << " told You";
-        } else {
-            // Hint between other players
-            (*log_) << "P" << activePlayer_ << " told P" << to;
-        }
-        
-        if (card_indices.empty()) {
-            (*log_) << " no";
-        } else {
-            if (to == 0) {
-                (*log_) << (card_indices.size() == hands_[to].size() ? " all your": (" your " + nth(card_indices, hands_[to].size())));
-            } else {
-                (*log_) << (card_indices.size() == hands_[to].size() ? " all his": (" his " + nth(card_indices, hands_[to].size())));
-            }  
-        }
-        
-        (*log_) << (singular ? " card is " : " cards are ") << colorname(color) << "\n"; 
-    }
+    notify_([&](ServerObserver &o) { o.onColorHint(*this, activePlayer_, to, color, card_indices); });
 
     //Hint logic. Given hint should be added to the server hint vector
     if (card_indices.empty()) {
@@ -907,12 +900,14 @@ void Server::pleaseGiveColorHint(int to, Color color)
     int oldObservingPlayer = observingPlayer_;
     for (int i=0; i < players_.size(); ++i) {
         observingPlayer_ = i;
+        ObserveTimer timer(*this, i);
         players_[i]->pleaseObserveColorHint(*this, activePlayer_, to, color, card_indices);
     }
     observingPlayer_ = oldObservingPlayer;
 
     hintStonesRemaining_ -= 1;
     movesFromActivePlayer_ = 1;
+    notify_([&](ServerObserver &o) { o.onMoveEnd(*this, activePlayer_); });
 }
 
 void Server::pleaseGiveValueHint(int to, Value value)
@@ -936,32 +931,7 @@ void Server::pleaseGiveValueHint(int to, Value value)
     HANABI_SERVER_ASSERT(!card_indices.empty(), "hint must include at least one card");
 #endif
 
-    if (log_) {
-        const bool singular = (card_indices.size() == 1);
-        if (activePlayer_ == 0) {
-            // LLM player gives hint
-            (*log_) << "You told P" << to;
-        } else if (to == 0) {
-            // Hint given to LLM player
-            (*log_) << "P" << activePlayer_ << " told You";
-        } else {
-            // Hint between other players
-            (*log_) << "P" << activePlayer_ << " told P" << to;
-        }
-        
-        if (card_indices.empty()) {
-            (*log_) << " no";
-        } else {
-            if (to == 0) {
-                (*log_) << (card_indices.size() == hands_[to].size() ? " all your": (" your " + nth(card_indices, hands_[to].size())));
-            } else {
-                (*log_) << (card_indices.size() == hands_[to].size() ? " all his": (" his " + nth(card_indices, hands_[to].size())));
-            }  
-        }
-        
-        /*Cast value to integer for logging purposes*/
-        (*log_) << (singular ? " card is a " : " cards are a ") << static_cast<int>(value) << "\n";
-    }
+    notify_([&](ServerObserver &o) { o.onValueHint(*this, activePlayer_, to, value, card_indices); });
 
     //Hint logic. Given hint should be added to the server hint vector
     if (card_indices.empty()) {
@@ -979,12 +949,14 @@ void Server::pleaseGiveValueHint(int to, Value value)
     int oldObservingPlayer = observingPlayer_;
     for (int i=0; i < players_.size(); ++i) {
         observingPlayer_ = i;
+        ObserveTimer timer(*this, i);
         players_[i]->pleaseObserveValueHint(*this, activePlayer_, to, value, card_indices);
     }
     observingPlayer_ = oldObservingPlayer;
 
     hintStonesRemaining_ -= 1;
     movesFromActivePlayer_ = 1;
+    notify_([&](ServerObserver &o) { o.onMoveEnd(*this, activePlayer_); });
 }
 
 void Server::pleaseAddColorHint(int giverId, int receiverId, int cardPosition, bool negativeHint, Color color) {
@@ -1005,7 +977,7 @@ void Server::pleaseUpdateValuableHints() {
         if (hint.getIsValuable() == true) {
             int playerId = hint.getReceiverId();
             int cardPosition = hint.getCardPosition();
-            const std::vector<Card>& playerHand = cheatGetHand(playerId);
+            const std::vector<Card>& playerHand = hands_[playerId];
 
             // If the hint card position is out of bounds, mark it as not valuable
             if (cardPosition >= playerHand.size()) {
@@ -1047,18 +1019,23 @@ void Server::pleaseUpdateHintCardPosition(int index) {
     }
 }
 
+std::pair<int, int> Server::questionRounds(int numPlayers) const {
+    int first_question_round = 50 - numPlayers * handSize(numPlayers);
+    int last_question_round = numPlayers - 1;
+    return std::make_pair(last_question_round, first_question_round);
+}
+
 int Server::selectQuestionRound() {
-    std::mt19937 rng(std::random_device{}());
+    std::mt19937 &rng = questionRand_;
 
-    int first_question_round = 50 - numPlayers_ * handSize();
-    int last_question_round = numPlayers_ - 1;
-    std::uniform_int_distribution<int> remainingCardDist(last_question_round, first_question_round);
+    const auto rounds = questionRounds(numPlayers_);
+    std::uniform_int_distribution<int> remainingCardDist(rounds.first, rounds.second);
 
     return remainingCardDist(rng);
 }
 
 Question Server::generateRandomQuestion() {
-    std::mt19937 rng(std::random_device{}());
+    std::mt19937 &rng = questionRand_;
 
     std::uniform_int_distribution<int> typeDist(0, 1);
     std::uniform_int_distribution<int> colorDist(0, NUMCOLORS - 1);
@@ -1078,14 +1055,14 @@ Question Server::generateRandomQuestion() {
 }
 
 Color Server::generatePileQuestion() {
-    std::mt19937 rng(std::random_device{}());
+    std::mt19937 &rng = questionRand_;
 
     std::uniform_int_distribution<int> colorDist(0, NUMCOLORS - 1);
     return static_cast<Color>(colorDist(rng));
 }
 
 Card Server::generateDiscardQuestion() {
-    std::mt19937 rng(std::random_device{}());
+    std::mt19937 &rng = questionRand_;
 
     std::uniform_int_distribution<int> colorDist(0, NUMCOLORS - 1);
     Color color = static_cast<Color>(colorDist(rng));
@@ -1176,47 +1153,6 @@ int Server::countValues(int value) const
     return -1; // silence compiler
 }
 
-void Server::logHands_() const
-{
-    if (log_) {
-        (*log_) << "Hands:";
-        for (int i=1; i < numPlayers_; ++i) {
-            (*log_) << " P" << i << " cards are";
-            for (int j=0; j < (int)hands_[i].size(); ++j) {
-                (*log_) << (j ? "," : " ") << hands_[i][j].toString();
-            }
-            (*log_) << ";";
-        }
-        (*log_) << "\n";
-    }
-}
-
-void Server::logAllHands_() const
-{
-    if (log_) {
-        (*log_) << "Hands:";
-        for (int i=0; i < numPlayers_; ++i) {
-            (*log_) << " P" << i << " cards are";
-            for (int j=0; j < (int)hands_[i].size(); ++j) {
-                (*log_) << (j ? "," : " ") << hands_[i][j].toString();
-            }
-            (*log_) << ";";
-        }
-        (*log_) << "\n";
-    }
-}
-
-void Server::logPiles_() const
-{
-    if (log_) {
-        (*log_) << "Piles:";
-        for (Color k = RED; k <= BLUE; ++k) {
-            (*log_) << " " << piles_[k].size() << Card(k, 1).toString()[1];
-        }
-        (*log_) << "\n";
-    }
-}
-
 std::map<std::string, std::shared_ptr<BotFactory>> &getBotFactoryMap() {
   static std::map<std::string, std::shared_ptr<BotFactory>> factoryMap;
   return factoryMap;
@@ -1234,6 +1170,14 @@ std::shared_ptr<Hanabi::BotFactory> getBotFactory(const std::string &botName) {
   return getBotFactoryMap().at(botName);
 }
 
+std::vector<std::string> getBotNames() {
+  std::vector<std::string> names;
+  for (const auto &kv : getBotFactoryMap()) {
+    names.push_back(kv.first);
+  }
+  return names;
+}
+
 // Constructor for color question
 Question::Question(int playerId, int cardPosition, Color color)
     : type(Type::COLOR), playerId(playerId), cardPosition(cardPosition), color(color) {}
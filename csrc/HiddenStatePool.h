@@ -0,0 +1,131 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <torch/torch.h>
+
+#include "Batcher.h"
+#include "InferenceStats.h"
+
+/* Central arena for TorchBot LSTM hidden states.
+ *
+ * A search range holds one TorchBot clone per hand, and each used to own a
+ * TensorDict of h0/c0 (2x512 floats each, and a view that kept the whole
+ * batch output alive). Here a state is a fixed-size record in a block of the
+ * arena, optionally stored as fp16/bf16. States are immutable: clones share
+ * a Handle, and a bot that runs the model stores a new state and drops its
+ * reference, so sharing is copy-on-write. Records return to a free list when
+ * their last Handle goes away. */
+class HiddenStatePool : public std::enable_shared_from_this<HiddenStatePool> {
+ public:
+  /* nullptr means the all-zeros initial state */
+  using Handle = std::shared_ptr<const void>;
+
+  HiddenStatePool(const InputShapes &layout, const std::string &dtype, size_t blockStates = 4096)
+      : layout_(layout), dtype_(dtype), scalar_(parseDtype_(dtype)), blockStates_(blockStates) {
+    size_t numel = 0;
+    for (const auto &kv : layout_) {
+      int64_t n = 1;
+      for (auto s : kv.second) n *= s;
+      offsets_.push_back(numel);
+      numel += n;
+    }
+    stateBytes_ = numel * c10::elementSize(scalar_);
+  }
+
+  const InputShapes &layout() const { return layout_; }
+
+  /* Copies (and converts) a state into the arena. */
+  Handle store(const TensorDict &state) {
+    char *record = allocate_();
+    for (size_t i = 0; i < layout_.size(); i++) {
+      view_(record, i).copy_(state.at(layout_[i].first));
+    }
+    auto self = shared_from_this();
+    return Handle(record, [self](const void *p) { self->release_((char *) p); });
+  }
+
+  /* Writes a state, as float, into the tensors of dst (e.g. a batch slot). */
+  void load(const Handle &handle, TensorDict &dst) const {
+    for (size_t i = 0; i < layout_.size(); i++) {
+      auto &out = dst.at(layout_[i].first);
+      if (handle) {
+        out.copy_(view_((char *) handle.get(), i));
+      } else {
+        out.zero_();
+      }
+    }
+  }
+
+  HiddenStateStats stats() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    HiddenStateStats stats;
+    stats.dtype = dtype_;
+    stats.stateBytes = stateBytes_;
+    stats.live = live_;
+    stats.peakLive = peakLive_;
+    stats.capacity = blocks_.size() * blockStates_;
+    stats.bytes = stats.capacity * stateBytes_;
+    stats.peakBytes = peakLive_ * stateBytes_;
+    return stats;
+  }
+
+ private:
+  static torch::ScalarType parseDtype_(const std::string &dtype) {
+    if (dtype == "float32") return torch::kFloat;
+    if (dtype == "float16") return torch::kHalf;
+    if (dtype == "bfloat16") return torch::kBFloat16;
+    throw std::runtime_error("Unknown hidden state dtype '" + dtype + "' (float32, float16 or bfloat16)");
+  }
+
+  torch::Tensor view_(char *record, size_t i) const {
+    return torch::from_blob(record + offsets_[i] * c10::elementSize(scalar_),
+                            layout_[i].second, torch::TensorOptions().dtype(scalar_));
+  }
+
+  char *allocate_() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (free_.empty()) {
+      blocks_.emplace_back(new char[blockStates_ * stateBytes_]);
+      char *block = blocks_.back().get();
+      for (size_t i = blockStates_; i-- > 0; ) {
+        free_.push_back(block + i * stateBytes_);
+      }
+    }
+    char *record = free_.back();
+    free_.pop_back();
+    live_++;
+    peakLive_ = std::max(peakLive_, live_);
+    return record;
+  }
+
+  void release_(char *record) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    free_.push_back(record);
+    live_--;
+  }
+
+  const InputShapes layout_;
+  const std::string dtype_;
+  const torch::ScalarType scalar_;
+  const size_t blockStates_;
+  std::vector<size_t> offsets_;  // in elements
+  size_t stateBytes_ = 0;
+
+  mutable std::mutex mtx_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  std::vector<char *> free_;
+  size_t live_ = 0;
+  size_t peakLive_ = 0;
+};
@@ -411,16 +411,31 @@ class HleSerializedMove {
     return s;
   }
 
-  std::vector<float> toArray() const {
-    std::vector<float> res;
-    res.insert(res.end(), handSection_.begin(), handSection_.end());
-    res.insert(res.end(), boardSection_.begin(), boardSection_.end());
-    res.insert(res.end(), discardSection_.begin(), discardSection_.end());
-    res.insert(res.end(), lastActionSection_.begin(), lastActionSection_.end());
-    res.insert(res.end(), beliefSection_.begin(), beliefSection_.end());
+  /* number of features written by writeTo() */
+  size_t size() const {
+    size_t n = handSection_.size() + boardSection_.size() + discardSection_.size() +
+               lastActionSection_.size() + beliefSection_.size();
+    if (HleParams::GREEDY_ACTION) {
+      n += lastActionSection_.size();
+    }
+    return n;
+  }
+
+  /* Encodes the features into out[0..size()), e.g. directly into a batch slot. */
+  void writeTo(float *out) const {
+    out = std::copy(handSection_.begin(), handSection_.end(), out);
+    out = std::copy(boardSection_.begin(), boardSection_.end(), out);
+    out = std::copy(discardSection_.begin(), discardSection_.end(), out);
+    out = std::copy(lastActionSection_.begin(), lastActionSection_.end(), out);
+    out = std::copy(beliefSection_.begin(), beliefSection_.end(), out);
     if (HleParams::GREEDY_ACTION) {
-      res.insert(res.end(), lastActionSection_.begin(), lastActionSection_.end());
+      out = std::copy(lastActionSection_.begin(), lastActionSection_.end(), out);
     }
+  }
+
+  std::vector<float> toArray() const {
+    std::vector<float> res(size());
+    writeTo(res.data());
     // std::cout << "size of feature: " << res.size() << std::endl;
     return res;
   }
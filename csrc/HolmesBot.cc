@@ -11,6 +11,8 @@
 #include "Hanabi.h"
 #include "HolmesBot.h"
 #include "BotFactory.h"
+#include "BotState.h"
+#include "CardMask.h"
 
 using namespace Hanabi;
 using namespace Holmes;
@@ -733,6 +735,26 @@ void HolmesBot::printHandKnowledge(const std::map<std::string, std::string>& kno
 
 }
 
+void HolmesBot::writeHandKnowledge(const Server &server, const HandKnowledgeTensor &out) const {
+  const BoardMasks board = BoardMasks::compute(server);
+  for (int p = 0; p < (int)handKnowledge_.size(); ++p) {
+    for (int i = 0; i < (int)handKnowledge_[p].size(); ++i) {
+      const CardKnowledge &knol = handKnowledge_[p][i];
+      CardMask possible;
+      for (Color k = RED; k <= BLUE; ++k) {
+        for (int v = 1; v <= 5; ++v) {
+          if (!knol.cannotBe(Card(k, v))) possible.add(k, v);
+        }
+      }
+      writeCardKnowledge(out, p, i, possible, board);
+      /* what hints have marked, beyond what the identities alone show */
+      if (knol.isPlayable) out.at(p, i, KNOWLEDGE_PLAYABLE) = KNOWLEDGE_YES;
+      if (knol.isValuable) out.at(p, i, KNOWLEDGE_VALUABLE) = KNOWLEDGE_YES;
+      if (knol.isWorthless) out.at(p, i, KNOWLEDGE_WORTHLESS) = KNOWLEDGE_YES;
+    }
+  }
+}
+
 HolmesBot *HolmesBot::clone() const {
   HolmesBot *b = new HolmesBot(me_, handKnowledge_.size(), handKnowledge_[0].size());
   b->me_ = this->me_;
@@ -755,3 +777,36 @@ HolmesBot *HolmesBot::clone() const {
   b->permissive_ = this->permissive_;
   return b;
 }
+
+void HolmesBot::saveState(std::string &buf) const {
+  StateWriter out(buf);
+  out.tag("HolmesBot");
+  out.pod(permissive_);
+  out.pod(me_);
+  out.pod(myHandSize_);
+  out.pod(uint32_t(handKnowledge_.size()));
+  for (auto &hk : handKnowledge_) {
+    out.vec(hk);
+  }
+  out.pod(playedCount_);
+  out.pod(locatedCount_);
+  out.pod(lowestPlayableValue_);
+}
+
+size_t HolmesBot::restoreState(const char *data, size_t size) {
+  StateReader in(data, size);
+  in.tag("HolmesBot");
+  in.pod(permissive_);
+  in.pod(me_);
+  in.pod(myHandSize_);
+  uint32_t numPlayers;
+  in.pod(numPlayers);
+  handKnowledge_.resize(numPlayers);
+  for (auto &hk : handKnowledge_) {
+    in.vec(hk);
+  }
+  in.pod(playedCount_);
+  in.pod(locatedCount_);
+  in.pod(lowestPlayableValue_);
+  return in.consumed();
+}
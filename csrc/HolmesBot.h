@@ -101,6 +101,9 @@ class HolmesBot final : public Hanabi::Bot {
     void pleaseObserveAfterMove(const Hanabi::Server &) override;
     std::map<std::string, std::string> handKnowledgeToMap() override;
     void printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) override;
+    void writeHandKnowledge(const Hanabi::Server &server, const Hanabi::HandKnowledgeTensor &out) const override;
     HolmesBot *clone() const override;
+    void saveState(std::string &buf) const override;
+    size_t restoreState(const char *data, size_t size) override;
 
 };
@@ -0,0 +1,49 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class ThreadPool;
+
+/* Throughput counters of the batched inference engine that serves TorchBot.
+ * Kept free of torch includes so that the extension can report them whether
+ * or not TorchBot was compiled in. */
+struct InferenceStats {
+  std::string device;
+  int batchSize = 0;
+  int maxDelayUs = 0;
+  int intraOpThreads = 0;
+
+  long batches = 0;
+  long inferences = 0;
+  double meanBatchFill = 0;     // mean of (batch size / max batch size)
+  double inferencesPerSec = 0;  // over the wall time since the model was loaded
+  double waitSecs = 0;          // time the forward thread spent waiting for a batch
+  double forwardSecs = 0;       // time spent copying to the device and running the model
+};
+
+/* Memory used by TorchBot hidden states (see HiddenStatePool). */
+struct HiddenStateStats {
+  std::string dtype;
+  size_t stateBytes = 0;  // per hidden state
+  size_t live = 0;        // states currently referenced by some bot
+  size_t peakLive = 0;
+  size_t capacity = 0;    // states allocated in the arena
+  size_t bytes = 0;       // arena size
+  size_t peakBytes = 0;   // peakLive * stateBytes
+};
+
+/* Fills *stats with the counters of the model the given pool's TorchBots
+ * loaded last. Returns false if the pool has not loaded a model.
+ * Defined in TorchBot.cc, so only available when TorchBot is built. */
+bool getInferenceStats(const ThreadPool &pool, InferenceStats *stats);
+
+/* Fills *stats with the hidden state pool of the given dtype. Returns false if
+ * no TorchBot has used it yet. Defined in TorchBot.cc. */
+bool getHiddenStateStats(const std::string &dtype, HiddenStateStats *stats);
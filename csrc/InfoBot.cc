@@ -7,6 +7,7 @@
 #include "Hanabi.h"
 #include "InfoBot.h"
 #include "BotFactory.h"
+#include "CardMask.h"
 
 #include <cassert>
 #include <memory>
@@ -1544,6 +1545,19 @@ public:
     void printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) {
 
     }
+
+    void writeHandKnowledge(const Hanabi::Server& server, const Hanabi::HandKnowledgeTensor& out) const override
+    {
+        const Hanabi::BoardMasks board = Hanabi::BoardMasks::compute(server);
+        for (int player = 0; player < (int)this->public_info.size(); ++player) {
+            const auto& hand_info = this->public_info[player];
+            for (int i = 0; i < (int)hand_info.size(); ++i) {
+                Hanabi::CardMask possible;
+                hand_info[i].for_each_possibility([&](Card card) { possible.add(card.color, card.value); });
+                Hanabi::writeCardKnowledge(out, player, i, possible, board);
+            }
+        }
+    }
 };
 
 std::unique_ptr<InfoBot> InfoBot::makeImpl(int index, int numPlayers, int handSize)
@@ -44,6 +44,9 @@ class InfoBot : public Hanabi::Bot {
     void printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) override {
         return impl_->printHandKnowledge(knowledgeMap);
     }
+    void writeHandKnowledge(const Hanabi::Server& server, const Hanabi::HandKnowledgeTensor& out) const override {
+        return impl_->writeHandKnowledge(server, out);
+    }
     virtual ~InfoBot() = default;
 
     Bot *clone() const override {
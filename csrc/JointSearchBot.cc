@@ -20,9 +20,6 @@
 #include "JointSearchBot.h"
 
 using namespace Hanabi;
-using namespace HanabiParams;
-using namespace SearchBotParams;
-using namespace JointSearchBotParams;
 
 static void _registerBots() {
   registerBotFactory(
@@ -43,7 +40,6 @@ JointSearchBot::JointSearchBot(int index, int numPlayers, int handSize)
       if (numPlayers > 2) {
         throw std::runtime_error("Joint search only works for 2 players.");
       }
-      std::cerr << now() << "JointSearchBotParams {" << std::endl; // legacy
       memoizedRange.clear();
 }
 
@@ -55,7 +51,7 @@ void JointSearchBot::applyToAll(ObservationFunc f) {
 
 void JointSearchBot::init_(const Server &server) {
 
-  std::cerr << now() << "Generating initial hand distribution..." << std::endl;
+  if (params_.search.SEARCH_LOG) std::cerr << now() << "Generating initial hand distribution..." << std::endl;
   DeckComposition deck = getCurrentDeckComposition(server, -1); // -1 means public
   for (int p = 0; p < server.numPlayers(); p++) {
     HandDist handDist;
@@ -141,11 +137,12 @@ size_t constructPrivateBeliefs_(const Hand &partnerHand, const HandDistCDF &publ
   const DeckComposition deck = getCurrentDeckComposition(server, -1); // -1 means public
   std::atomic<int> num_private_beliefs(publicPDF.probs.size());
   std::vector<boost::fibers::future<void>> futures;
-  for (int t = 0; t < NUM_THREADS; t++) {
+  const int num_threads = server.params().NUM_THREADS;
+  for (int t = 0; t < num_threads; t++) {
     futures.push_back(getThreadPool().enqueue([&, t]() {
       std::array<int, 25> fast_deck;
       for (int i = 0; i < 25; i++) fast_deck[i] = deck.at(indexToCard(i));
-      for (int i = t; i < publicPDF.probs.size(); i += NUM_THREADS) {
+      for (int i = t; i < publicPDF.probs.size(); i += num_threads) {
         const Hand &my_hand = publicPDF.hands.at(i);
         double old_prior = 1, new_prior = 1;
         for (const Card &card : my_hand) {
@@ -185,16 +182,16 @@ void JointSearchBot::pleaseMakeMove(Server &server)
     updateFrames_(me_, server);
     simulserver_.sync(server);
     Move bp_move = simulserver_.simulatePlayerMove(me_, players_[me_].get());
-    std::cerr << now() << "Frame " << numFrames_ << " : Blueprint strat says to play " << bp_move.toString() << std::endl;
+    if (params_.search.SEARCH_LOG) std::cerr << now() << "Frame " << numFrames_ << " : Blueprint strat says to play " << bp_move.toString() << std::endl;
     SearchStats stats;
     size_t num_partner_beliefs = hand_dists_[1 - me_].size();
-    std::cerr << now() << "  My partner has " << num_partner_beliefs << " public beliefs. " << std::endl;
+    if (params_.search.SEARCH_LOG) std::cerr << now() << "  My partner has " << num_partner_beliefs << " public beliefs. " << std::endl;
     Move move;
     if (history_[me_].size() > 0) {
-      std::cerr << now() << "  Bailing from search because I dont know my beliefs." << std::endl;
+      if (params_.search.SEARCH_LOG) std::cerr << now() << "  Bailing from search because I dont know my beliefs." << std::endl;
       move = bp_move;
     } else {
-      applyDelayedObservations(hand_dists_[me_], copyKeys(hand_dists_[me_]));
+      applyDelayedObservations(hand_dists_[me_], copyKeys(hand_dists_[me_]), params_);
       HandDistCDF pdf = populateHandDistPDF(hand_dists_[me_]);
       size_t num_private_beliefs = constructPrivateBeliefs_(
         server.handOfPlayer(1 - me_), pdf, pdf, server);
@@ -202,17 +199,19 @@ void JointSearchBot::pleaseMakeMove(Server &server)
       pdfToCdf(pdf, cdf);
 
       assert(num_private_beliefs > 0);
-      std::mt19937 search_gen(JOINT_SEARCH_SEED); // coordinate on seed yuck
+      std::mt19937 search_gen(params_.joint.JOINT_SEARCH_SEED); // coordinate on seed yuck
       move = doSearch_(me_, bp_move, Move(), players_[me_].get(), hand_dists_[me_], cdf, stats, search_gen, server);
-      logSearchResults(stats, server.numPlayers(), me_);
-      if (move != bp_move) std::cerr << now() << "Search changed the move. ";
-      std::cerr << now() << "Blueprint picked " << bp_move.toString() << " with average score " << stats[bp_move].mean
-                << "; search picked " << move.toString() << " with average score " << stats[move].mean << std::endl;
+      logSearchResults(stats, server.numPlayers(), me_, params_.search);
+      if (params_.search.SEARCH_LOG) {
+        if (move != bp_move) std::cerr << now() << "Search changed the move. ";
+        std::cerr << now() << "Blueprint picked " << bp_move.toString() << " with average score " << stats[bp_move].mean
+                  << "; search picked " << move.toString() << " with average score " << stats[move].mean << std::endl;
+      }
 
       if (move != bp_move) {
         changed_moves_++;
         score_difference_ += stats[move].mean - stats[bp_move].mean;
-        if (DOUBLE_SEARCH) {
+        if (params_.search.DOUBLE_SEARCH) {
           SearchStats unbiased_stats;
           SearchStats unbiased_win_stats;
           doSearch_(me_, bp_move, Move(), players_[me_].get(), hand_dists_[me_], cdf, unbiased_stats, gen_, server, false, &unbiased_win_stats);
@@ -271,32 +270,34 @@ void JointSearchBot::updateFrames_(int who, const Server &server) {
   auto &history = history_[who];
   int init_num_frames = history.size();
   int from = 1 - who;
-  std::cerr << now() << "(P" << me_ << ") updateFrames_ P " << who << ": " << history.size() << " frames." << std::endl;
+  if (params_.search.SEARCH_LOG) std::cerr << now() << "(P" << me_ << ") updateFrames_ P " << who << ": " << history.size() << " frames." << std::endl;
   while (history.size() > 0) {
     auto &frame = history[0];
     auto &hand_dist = frame.hand_dist_;
 
-    if (RANGE_MAX >= 0 && hand_dist.size() > RANGE_MAX) {
+    if (params_.joint.RANGE_MAX >= 0 && hand_dist.size() > params_.joint.RANGE_MAX) {
       break;
     }
     // alright! we can do an update!
     auto &frame_simulserver = frame.simulserver_;
     assert(frame_simulserver.numPlayers() == 2);
-    std::cerr << now() << " Frame " << frame.frame_idx_
-              << " : Looking for hands for P " << who
-              << " consistent with P " << from << " action " << frame.move_.toString()
-              << " (range= " << frame.hand_dist_.size() << " , partner range= " << frame.partner_hand_dist_.size() << " )" << std::endl;
+    if (params_.search.SEARCH_LOG) {
+      std::cerr << now() << " Frame " << frame.frame_idx_
+                << " : Looking for hands for P " << who
+                << " consistent with P " << from << " action " << frame.move_.toString()
+                << " (range= " << frame.hand_dist_.size() << " , partner range= " << frame.partner_hand_dist_.size() << " )" << std::endl;
+    }
 
     auto memoize_key = std::tie(from, frame.frame_idx_);
     if (memoizedRange.count(memoize_key)) {
-      std::cerr << now() << "Using memoized values to update frame " << frame.frame_idx_ << std::endl;
+      if (params_.search.SEARCH_LOG) std::cerr << now() << "Using memoized values to update frame " << frame.frame_idx_ << std::endl;
       auto &my_memoized_range = memoizedRange[memoize_key];
       for (auto &hand : my_memoized_range) {
         assert(hand_dist.count(hand));
         hand_dist.erase(hand);
         propagatePrunedHand_(who, 0, hand);
       }
-      std::cerr << now() << "  Filtered historical range down to " << hand_dist.size() << " (MEMOIZED) " << std::endl;
+      if (params_.search.SEARCH_LOG) std::cerr << now() << "  Filtered historical range down to " << hand_dist.size() << " (MEMOIZED) " << std::endl;
       checkBeliefs_(server);
       history.erase(history.begin());
       continue;
@@ -304,11 +305,11 @@ void JointSearchBot::updateFrames_(int who, const Server &server) {
     auto hand_dist_keys = copyKeys(hand_dist);
     std::vector<Hand> my_memoized_range;
 
-    std::cerr << now() << "Applying delayed obs on my hand dist..." << std::endl;
-    applyDelayedObservations(hand_dist, hand_dist_keys);
-    std::cerr << now() << "Applying delayed obs on partner dist..." << std::endl;
-    applyDelayedObservations(frame.partner_hand_dist_, copyKeys(frame.partner_hand_dist_));
-    std::cerr << now() << "Done delayed updates." << std::endl;
+    if (params_.search.SEARCH_LOG) std::cerr << now() << "Applying delayed obs on my hand dist..." << std::endl;
+    applyDelayedObservations(hand_dist, hand_dist_keys, params_);
+    if (params_.search.SEARCH_LOG) std::cerr << now() << "Applying delayed obs on partner dist..." << std::endl;
+    applyDelayedObservations(frame.partner_hand_dist_, copyKeys(frame.partner_hand_dist_), params_);
+    if (params_.search.SEARCH_LOG) std::cerr << now() << "Done delayed updates." << std::endl;
 
     HandDistCDF public_pdf = populateHandDistPDF(frame.partner_hand_dist_);
     HandDistCDF private_cdf = populateHandDistPDF(frame.partner_hand_dist_); // not done
@@ -332,7 +333,7 @@ void JointSearchBot::updateFrames_(int who, const Server &server) {
       }
       pdfToCdf(private_cdf, private_cdf);
 
-      std::mt19937 search_gen(JOINT_SEARCH_SEED); // coordinate on seed yuck
+      std::mt19937 search_gen(params_.joint.JOINT_SEARCH_SEED); // coordinate on seed yuck
       SearchStats stats;
       // move = doSearch_(me_, bp_move, players_[me_].get(), my_private_beliefs, stats, search_gen, server);
       Move cf_move = doSearch_(from, bp_move, frame.move_, from_bot.get(), frame.partner_hand_dist_, private_cdf, stats, search_gen, my_server, false);
@@ -341,7 +342,7 @@ void JointSearchBot::updateFrames_(int who, const Server &server) {
       //   << " ) pred_move= " << cf_move.toString() << " (score= " << stats[cf_move].mean << " )" << std::endl;
       if (frame.move_ != cf_move) {
         hand_dist.erase(hand);
-        if(MEMOIZE_RANGE_SEARCH) {
+        if(params_.joint.MEMOIZE_RANGE_SEARCH) {
           my_memoized_range.push_back(hand);
         }
         // std::cerr << now() << " Gonna propagate pruning of hand " << handAsString(hand) << " ; current beliefs contain " << hand_dists_[who].size() << std::endl;
@@ -350,19 +351,19 @@ void JointSearchBot::updateFrames_(int who, const Server &server) {
         checkBeliefs_(server);
       }
     }
-    if (MEMOIZE_RANGE_SEARCH) {
+    if (params_.joint.MEMOIZE_RANGE_SEARCH) {
       memoizedRange[memoize_key] = my_memoized_range;
     }
-    std::cerr << now() << "  Filtered historical range down to " << hand_dist.size() << std::endl;
+    if (params_.search.SEARCH_LOG) std::cerr << now() << "  Filtered historical range down to " << hand_dist.size() << std::endl;
 
     checkBeliefs_(server);
     history.erase(history.begin()); // FIXME: use more efficient data structure or use SmartPtr to avoid copies
-    if (history.size() == 0) {
+    if (params_.search.SEARCH_LOG && history.size() == 0) {
       std::cerr << now() << "Woo! pushed up to the present!" << std::endl;
     }
   }
-  if (init_num_frames != history.size()) std::cerr << now() << "updateFrames_ reduced history from " << init_num_frames << " to " << history.size() << " frames." << std::endl;
-  std::cerr << now() << "updateFrames_ done." << std::endl;
+  if (params_.search.SEARCH_LOG && init_num_frames != history.size()) std::cerr << now() << "updateFrames_ reduced history from " << init_num_frames << " to " << history.size() << " frames." << std::endl;
+  if (params_.search.SEARCH_LOG) std::cerr << now() << "updateFrames_ done." << std::endl;
 }
 
 
@@ -381,11 +382,11 @@ void JointSearchBot::filterBeliefsConsistentWithAction_(const Move &move, int fr
     assert(history_[who].size() == 0);
     auto &hand_dist = hand_dists_[who];
     auto hand_dist_keys = copyKeys(hand_dist);
-    applyDelayedObservations(hand_dist, hand_dist_keys);
+    applyDelayedObservations(hand_dist, hand_dist_keys, params_);
     std::vector<boost::fibers::future<void>> futures;
-    for (int t = 0; t < NUM_THREADS; t++) {
+    for (int t = 0; t < params_.hanabi.NUM_THREADS; t++) {
       futures.push_back(getThreadPool().enqueue([&, t]() {
-        for (int i = t; i < hand_dist_keys.size(); i += NUM_THREADS) {
+        for (int i = t; i < hand_dist_keys.size(); i += params_.hanabi.NUM_THREADS) {
           const Hand &hand = hand_dist_keys[i];
           auto bot = hand_dist.at(hand).getPartner(from);
           SimulServer my_server(server);
@@ -407,15 +408,17 @@ void JointSearchBot::filterBeliefsConsistentWithAction_(const Move &move, int fr
         hand_dist.erase(hand);
       }
     }
-    std::cerr << now() << "Filtered current beliefs consistent with player " << from << " BLUEPRINT action '" << move.toString()
-              << "' reduced from " << hand_dist_keys.size() << " to " <<
-              hand_dist.size() << std::endl;
+    if (params_.search.SEARCH_LOG) {
+      std::cerr << now() << "Filtered current beliefs consistent with player " << from << " BLUEPRINT action '" << move.toString()
+                << "' reduced from " << hand_dist_keys.size() << " to " <<
+                hand_dist.size() << std::endl;
+    }
     checkBeliefs_(server);
   } else {
     // in this case my partner played search. If my history is empty I can update
     // my beliefs directly, but it's simpler to just push it onto the end of the
     // history and do the full history update
-    std::cerr << now() << "Player " << from << " did search; pushing a frame for player " << who << " ; frames= " << history_[who].size() + 1 << std::endl;
+    if (params_.search.SEARCH_LOG) std::cerr << now() << "Player " << from << " did search; pushing a frame for player " << who << " ; frames= " << history_[who].size() + 1 << std::endl;
     history_[who].emplace_back(*this, who, move, server);
 
   }
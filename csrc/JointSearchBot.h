@@ -13,19 +13,6 @@
 struct BeliefFrame;
 
 
-namespace JointSearchBotParams {
-
-  // read in parameters from environment variables
-  const int RANGE_MAX = Params::getParameterInt("RANGE_MAX", 2000,
-    "For JointSearchBot, the max range to perform search. Higher allows more search, at a higher computational cost.");
-  const int JOINT_SEARCH_SEED = Params::getParameterInt("JOINT_SEARCH_SEED", 12345,
-    "For JointSearchBot, the shared seed to use to select MC samples for search.");
-  const int MEMOIZE_RANGE_SEARCH = Params::getParameterInt("MEMOIZE_RANGE_SEARCH", 0,
-    "For JointSearchBot, if 1 then speed up play by only performing common-knowledge belief updates once and copying it to the other agent.");
-
-} // namespace SearchBotParams
-
-
 struct JointSearchBot : public SearchBot {
   friend class BeliefFrame;
 
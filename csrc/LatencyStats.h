@@ -0,0 +1,136 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* A histogram of durations in logarithmic buckets (BUCKETS_PER_DECADE per
+ * power of ten, from 1ns up, since an observation callback often takes well
+ * under a microsecond), so it takes constant memory however long it runs,
+ * and its percentiles are exact to within one bucket (12%). */
+class LatencyHistogram {
+public:
+  static constexpr int BUCKETS_PER_DECADE = 20;
+  static constexpr int DECADES = 13;  // 1ns to 10^4 s
+  static constexpr double MIN_SECS = 1e-9;
+
+  LatencyHistogram() : buckets_(BUCKETS_PER_DECADE * DECADES, 0) {}
+
+  void add(double secs) {
+    int bucket = secs > MIN_SECS ? int(std::log10(secs / MIN_SECS) * BUCKETS_PER_DECADE) : 0;
+    buckets_[std::min<int>(bucket, buckets_.size() - 1)] += 1;
+    count_ += 1;
+    sumSecs_ += secs;
+    maxSecs_ = std::max(maxSecs_, secs);
+  }
+
+  void merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sumSecs_ += other.sumSecs_;
+    maxSecs_ = std::max(maxSecs_, other.maxSecs_);
+  }
+
+  long count() const { return count_; }
+  double sumSecs() const { return sumSecs_; }
+  double maxSecs() const { return maxSecs_; }
+  double meanSecs() const { return count_ ? sumSecs_ / count_ : 0; }
+
+  /* The duration under which a fraction p of the samples fall: the upper
+   * edge of its bucket, but no more than the max. */
+  double percentile(double p) const {
+    if (count_ == 0) return 0;
+    const double rank = p * count_;
+    long seen = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      seen += buckets_[i];
+      if (seen >= rank && buckets_[i] > 0) {
+        return std::min(maxSecs_, MIN_SECS * std::pow(10.0, double(i + 1) / BUCKETS_PER_DECADE));
+      }
+    }
+    return maxSecs_;
+  }
+
+  /* {"count": ..., "mean": ..., "p50": ..., "p95": ..., "p99": ..., "max": ...}, in seconds */
+  std::string toJson() const {
+    std::ostringstream out;
+    out << "{\"count\": " << count_ << ", \"mean\": " << meanSecs()
+        << ", \"p50\": " << percentile(0.5) << ", \"p95\": " << percentile(0.95)
+        << ", \"p99\": " << percentile(0.99) << ", \"max\": " << maxSecs_ << "}";
+    return out.str();
+  }
+
+private:
+  std::vector<long> buckets_;
+  long count_ = 0;
+  double sumSecs_ = 0;
+  double maxSecs_ = 0;
+};
+
+/* Timings collected by a Server's game loop (see Server::setLatencyStats),
+ * indexed by seat. */
+struct LatencyStats {
+  /* pleaseMakeMove() calls, without the observation callbacks that the
+   * move triggers, i.e. the time the bot took to decide */
+  std::vector<LatencyHistogram> move;
+  /* each pleaseObserve*() callback */
+  std::vector<LatencyHistogram> observe;
+  /* wall time of each game, from startGame() to its end */
+  LatencyHistogram game;
+
+  LatencyHistogram &moveOf(int seat) { return at_(move, seat); }
+  LatencyHistogram &observeOf(int seat) { return at_(observe, seat); }
+
+  /* Lines for eval_bot's report, naming seats after botnames. */
+  std::string summary(const std::vector<std::string> &botnames) const {
+    std::ostringstream out;
+    for (size_t seat = 0; seat < move.size(); ++seat) {
+      const LatencyHistogram &m = move[seat];
+      out << "  Move latency of seat " << seat << " (" << nameOf_(botnames, seat) << "): p50 "
+          << 1e3 * m.percentile(0.5) << " ms, p95 " << 1e3 * m.percentile(0.95)
+          << " ms, p99 " << 1e3 * m.percentile(0.99) << " ms, max " << 1e3 * m.maxSecs()
+          << " ms over " << m.count() << " moves";
+      if (seat < observe.size()) {
+        out << "; observing " << 1e3 * observe[seat].meanSecs() << " ms/callback, "
+            << observe[seat].sumSecs() << " s total";
+      }
+      out << ".\n";
+    }
+    if (game.count()) {
+      out << "  Game wall time: p50 " << game.percentile(0.5) << " s, p95 " << game.percentile(0.95)
+          << " s, max " << game.maxSecs() << " s over " << game.count() << " games.\n";
+    }
+    return out.str();
+  }
+
+  std::string toJson(const std::vector<std::string> &botnames) const {
+    std::ostringstream out;
+    out << "{\"seats\": [";
+    for (size_t seat = 0; seat < move.size(); ++seat) {
+      out << (seat ? ", " : "") << "{\"bot\": \"" << nameOf_(botnames, seat) << "\", \"move\": "
+          << move[seat].toJson() << ", \"observe\": "
+          << (seat < observe.size() ? observe[seat] : LatencyHistogram()).toJson() << "}";
+    }
+    out << "], \"game\": " << game.toJson() << "}";
+    return out.str();
+  }
+
+private:
+  static LatencyHistogram &at_(std::vector<LatencyHistogram> &v, int seat) {
+    if (seat >= (int)v.size()) v.resize(seat + 1);
+    return v[seat];
+  }
+  static std::string nameOf_(const std::vector<std::string> &botnames, size_t seat) {
+    return seat < botnames.size() ? botnames[seat] : "";
+  }
+};
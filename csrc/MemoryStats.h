@@ -0,0 +1,88 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+/* Approximate bytes held by a SearchBot's range, by category, and by the
+ * process (see measureRangeMemory in BotUtils.h). Objects shared between
+ * range entries (partner bots before they diverge, the servers of delayed
+ * observations) are counted once. */
+struct MemoryReport {
+  long handDistEntries = 0;
+  size_t handDistBytes = 0;      // map nodes of the range
+  long partnerBots = 0;          // distinct partner bots held by the range
+  size_t partnerBotBytes = 0;    // the bots, and the BotVecs holding them
+  long delayedObservations = 0;  // ObservationThunks not yet applied
+  size_t delayedObsBytes = 0;    // the thunks, and the servers they share
+  long internedHands = 0;        // BoxedHand interner, shared by the process
+  size_t internedHandBytes = 0;
+  size_t hiddenStateBytes = 0;   // TorchBot hidden states in use (see HiddenStatePool)
+  size_t rssBytes = 0;
+  size_t peakRssBytes = 0;
+
+  size_t rangeBytes() const {
+    return handDistBytes + partnerBotBytes + delayedObsBytes;
+  }
+
+  /* Keeps the larger of each field, e.g. the peaks over a game. */
+  void takePeak(const MemoryReport &other) {
+    handDistEntries = std::max(handDistEntries, other.handDistEntries);
+    handDistBytes = std::max(handDistBytes, other.handDistBytes);
+    partnerBots = std::max(partnerBots, other.partnerBots);
+    partnerBotBytes = std::max(partnerBotBytes, other.partnerBotBytes);
+    delayedObservations = std::max(delayedObservations, other.delayedObservations);
+    delayedObsBytes = std::max(delayedObsBytes, other.delayedObsBytes);
+    internedHands = std::max(internedHands, other.internedHands);
+    internedHandBytes = std::max(internedHandBytes, other.internedHandBytes);
+    hiddenStateBytes = std::max(hiddenStateBytes, other.hiddenStateBytes);
+    rssBytes = std::max(rssBytes, other.rssBytes);
+    peakRssBytes = std::max(peakRssBytes, other.peakRssBytes);
+  }
+
+  std::string toJson() const {
+    std::ostringstream out;
+    out << "{\"hand_dist_entries\": " << handDistEntries
+        << ", \"hand_dist_bytes\": " << handDistBytes
+        << ", \"partner_bots\": " << partnerBots
+        << ", \"partner_bot_bytes\": " << partnerBotBytes
+        << ", \"delayed_observations\": " << delayedObservations
+        << ", \"delayed_obs_bytes\": " << delayedObsBytes
+        << ", \"interned_hands\": " << internedHands
+        << ", \"interned_hand_bytes\": " << internedHandBytes
+        << ", \"hidden_state_bytes\": " << hiddenStateBytes
+        << ", \"rss_bytes\": " << rssBytes
+        << ", \"peak_rss_bytes\": " << peakRssBytes << "}";
+    return out.str();
+  }
+};
+
+/* Resident set size of the process, or 0 if /proc is not available. */
+inline size_t currentRssBytes() {
+  long pages = 0, resident = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (!f) return 0;
+  if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+  fclose(f);
+  return size_t(resident) * sysconf(_SC_PAGESIZE);
+}
+
+/* Largest resident set size of the process so far. */
+inline size_t peakRssBytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;  // bytes
+#else
+  return size_t(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+}
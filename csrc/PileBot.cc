@@ -8,6 +8,7 @@
 #include <set>
 #include <iomanip>
 #include "PileBot.h"
+#include "BotState.h"
 #include "BotFactory.h"
 #include "Hanabi.h"
 
@@ -22,35 +23,21 @@ static int dummy = (_registerBots(), 0);
 
 CardKnowledge::CardKnowledge()
     : isPlayable(false)
-    , isDiscardable(false) {
-    possibleColors.resize(NUMCOLORS, true);
-    possibleValues.resize(5, true);
+    , isDiscardable(false)
+    , possible(CardMask::all())
+    , lastHintTurn(-1) {
 }
 
 void CardKnowledge::updateFromHint(bool isColor, int value, bool positive) {
-    if (isColor) {
-        if (positive) {
-            for (int c = 0; c < NUMCOLORS; c++) {
-                possibleColors[c] = (c == value);
-            }
-        } else {
-            possibleColors[value] = false;
-        }
-    } else {
-        if (positive) {
-            for (int v = 0; v < 5; v++) {
-                possibleValues[v] = (v == value - 1);
-            }
-        } else {
-            possibleValues[value - 1] = false;
-        }
-    }
+    const CardMask hinted = isColor ? CardMask::ofColor(value) : CardMask::ofValue(value);
+    possible &= (positive ? hinted : ~hinted);
 }
 
 PileBot::PileBot(int index, int numPlayers, int handSize)
     : me_(index)
     , numPlayers_(numPlayers)
-    , currentTurn_(0) {
+    , currentTurn_(0)
+    , server_(nullptr) {
     handKnowledge_.resize(numPlayers);
     for (int i = 0; i < numPlayers; ++i) {
         handKnowledge_[i].resize(handSize);
@@ -138,10 +125,8 @@ bool PileBot::tryGivePriorityHint(Hanabi::Server& server) {
         std::vector<bool> needsColorInfo(hand.size());
         std::vector<bool> needsValueInfo(hand.size());
         for (int i = 0; i < hand.size(); i++) {
-            needsColorInfo[i] = std::count(knowledge[i].possibleColors.begin(), 
-                                         knowledge[i].possibleColors.end(), true) > 1;
-            needsValueInfo[i] = std::count(knowledge[i].possibleValues.begin(), 
-                                         knowledge[i].possibleValues.end(), true) > 1;
+            needsColorInfo[i] = __builtin_popcount(knowledge[i].possible.colors()) > 1;
+            needsValueInfo[i] = __builtin_popcount(knowledge[i].possible.values()) > 1;
         }
 
         // Try color hints for all piles
@@ -302,9 +287,8 @@ bool PileBot::trySafePriorityDiscard(Hanabi::Server& server) {
         // Reduce score for cards that might be critical
         int possibleCriticalColors = 0;
         for (int c = 0; c < NUMCOLORS; c++) {
-            if (!knowledge.possibleColors[c]) continue;
-            Card hypothetical(static_cast<Color>(c), 5); // Worst case: it's a 5
-            if (isCardCritical(hypothetical)) {
+            // Worst case: it's a 5
+            if (knowledge.possible.containsColor(c) && critical_.contains(c, 5)) {
                 possibleCriticalColors++;
             }
         }
@@ -349,20 +333,7 @@ bool PileBot::trySafePriorityDiscard(Hanabi::Server& server) {
         // Find card with highest index (newest) that isn't definitely critical
         for (int i = handSize - 1; i >= 0; i--) {
             const CardKnowledge& knowledge = handKnowledge_[me_][i];
-            bool mightBeCritical = false;
-            
-            for (int c = 0; c < NUMCOLORS; c++) {
-                if (!knowledge.possibleColors[c]) continue;
-                for (int v = 1; v <= 5; v++) {
-                    if (!knowledge.possibleValues[v-1]) continue;
-                    Card hypothetical(static_cast<Color>(c), v);
-                    if (isCardCritical(hypothetical)) {
-                        mightBeCritical = true;
-                        break;
-                    }
-                }
-                if (mightBeCritical) break;
-            }
+            const bool mightBeCritical = !(knowledge.possible & critical_).empty();
             
             if (!mightBeCritical) {
                 server.pleaseDiscard(i);
@@ -440,40 +411,9 @@ bool PileBot::tryGiveOneStoneHint(Server& server) {
 double PileBot::calculatePlayProbability(const CardKnowledge& knowledge, Color targetColor) const {
     if (knowledge.isPlayable) return 1.0;
     
-    int playableCombs = 0;
-    int totalCombs = 0;
-    
-    const Pile& targetPile = server_->pileOf(targetColor);
-    int pileHeight = targetPile.size();
-    
-    for (int c = 0; c < knowledge.possibleColors.size(); c++) {
-        if (!knowledge.possibleColors[c]) continue;
-        Color color = static_cast<Color>(c);
-        const Pile& pile = server_->pileOf(color);
-        
-        for (int v = 0; v < knowledge.possibleValues.size(); v++) {
-            if (!knowledge.possibleValues[v]) continue;
-            
-            totalCombs++;
-            int value = v + 1;  // Convert to 1-based value
-            
-            // A card is only playable if:
-            // 1. It's the next value needed
-            // 2. All previous values are already played
-            if (pile.nextValueIs(value)) {
-                bool prerequisitesMet = true;
-                for (int prev = 1; prev < value; prev++) {
-                    if (!pile.contains(prev)) {
-                        prerequisitesMet = false;
-                        break;
-                    }
-                }
-                if (prerequisitesMet) {
-                    playableCombs++;
-                }
-            }
-        }
-    }
+    // A card is only playable if it's the next value needed on its pile
+    int playableCombs = (knowledge.possible & board_.playable).count();
+    int totalCombs = knowledge.possible.count();
     
     return totalCombs > 0 ? static_cast<double>(playableCombs) / totalCombs : 0.0;
 }
@@ -561,37 +501,25 @@ double PileBot::evaluateHintValue(int to, Value value) const {
 }
 
 bool PileBot::isCardPlayable(const Card& card) const {
-    return server_->pileOf(card.color).nextValueIs(card.value);
+    return board_.playable.contains(card);
 }
 
 bool PileBot::isCardCritical(const Card& card) const {
+    return critical_.contains(card);
+}
+
+void PileBot::updateBoard(const Hanabi::Server& server) {
+    board_ = BoardMasks::compute(server);
+
     // A card is critical if:
     // 1. It hasn't been played yet
     // 2. All other copies have been discarded
     // 3. It's needed for one of the active piles
-    
-    if (server_->pileOf(card.color).contains(card.value)) {
-        return false;  // Already played
-    }
-    
-    int discardedCopies = 0;
-    for (const auto& discarded : server_->discards()) {
-        if (discarded == card) {
-            discardedCopies++;
-        }
-    }
-    
-    // If this is the last copy and it's part of a priority pile, it's critical
-    if (discardedCopies == card.count() - 1) {
-        auto piles = getPrioritizedPiles(*server_);
-        for (const auto& pile : piles) {
-            if (pile.isActive && pile.color == card.color && card.value >= pile.nextValueNeeded) {
-                return true;
-            }
-        }
+    CardMask activePiles;
+    for (const auto& pile : getPrioritizedPiles(server)) {
+        if (pile.isActive) activePiles |= CardMask::ofColor(pile.color);
     }
-    
-    return false;
+    critical_ = board_.lastCopy & ~board_.played & activePiles;
 }
 
 bool PileBot::willCompletePile(const Card& card) const {
@@ -624,6 +552,7 @@ bool PileBot::shouldPreserveCard(const Card& card) const {
 
 void PileBot::pleaseObserveBeforeMove(const Hanabi::Server& server) {
     server_ = &server;
+    updateBoard(server);
     assert(server.whoAmI() == me_);
     
     // Update hand knowledge sizes
@@ -646,6 +575,7 @@ void PileBot::pleaseObserveBeforeMove(const Hanabi::Server& server) {
 
 void PileBot::pleaseMakeMove(Hanabi::Server& server) {
     server_ = &server;
+    updateBoard(server);
     assert(server.whoAmI() == me_);
     currentTurn_++;
     
@@ -758,6 +688,8 @@ PileBot* PileBot::clone() const {
 
     b->currentTurn_ = this->currentTurn_;
     b->server_ = this->server_;
+    b->board_ = this->board_;
+    b->critical_ = this->critical_;
     
     assert(this->handKnowledge_.size() == b->handKnowledge_.size());
     for (int i = 0; i < handKnowledge_.size(); i++) {
@@ -770,4 +702,38 @@ PileBot* PileBot::clone() const {
     b->permissive_ = this->permissive_;
     
     return b;
+}
+
+void PileBot::saveState(std::string &buf) const {
+    StateWriter out(buf);
+    out.tag("PileBot");
+    out.pod(permissive_);
+    out.pod(me_);
+    out.pod(numPlayers_);
+    out.pod(currentTurn_);
+    out.pod(board_);
+    out.pod(critical_);
+    out.pod(uint32_t(handKnowledge_.size()));
+    for (const auto& hk : handKnowledge_) {
+        out.vec(hk);
+    }
+}
+
+size_t PileBot::restoreState(const char *data, size_t size) {
+    StateReader in(data, size);
+    in.tag("PileBot");
+    in.pod(permissive_);
+    in.pod(me_);
+    in.pod(numPlayers_);
+    in.pod(currentTurn_);
+    in.pod(board_);
+    in.pod(critical_);
+    uint32_t numHands;
+    in.pod(numHands);
+    handKnowledge_.resize(numHands);
+    for (auto& hk : handKnowledge_) {
+        in.vec(hk);
+    }
+    server_ = nullptr;  // picked up again on the next observation
+    return in.consumed();
 }
\ No newline at end of file
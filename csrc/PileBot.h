@@ -1,5 +1,6 @@
 #pragma once
 #include "Hanabi.h"
+#include "CardMask.h"
 #include <map>
 #include <vector>
 #include <memory>
@@ -27,8 +28,7 @@ namespace PileB {
     struct CardKnowledge {
         bool isPlayable;
         bool isDiscardable;
-        std::vector<bool> possibleColors;
-        std::vector<bool> possibleValues;
+        Hanabi::CardMask possible;  // identities not ruled out by hints
         int lastHintTurn;
         CardKnowledge();
         void updateFromHint(bool isColor, int value, bool positive);
@@ -46,6 +46,8 @@ public:
     void pleaseObserveValueHint(const Hanabi::Server &, int from, int to, Hanabi::Value value, Hanabi::CardIndices card_indices) override;
     void pleaseObserveAfterMove(const Hanabi::Server &) override;
     PileBot* clone() const override;
+    void saveState(std::string &buf) const override;
+    size_t restoreState(const char *data, size_t size) override;
 
 private:
     // Core member variables
@@ -54,6 +56,9 @@ private:
     int currentTurn_;
     const Hanabi::Server* server_;
     std::vector<std::vector<PileB::CardKnowledge>> handKnowledge_;
+    // Refreshed from server_ at the start of each turn
+    Hanabi::BoardMasks board_;
+    Hanabi::CardMask critical_;  // last copies of cards needed by the active piles
 
     std::vector<PileB::PileStatus> getPrioritizedPiles(const Hanabi::Server& server) const;
     Hanabi::Color getMostAdvancedPlayablePile(const Hanabi::Server& server) const;
@@ -66,6 +71,7 @@ private:
 
 
     // Utility methods
+    void updateBoard(const Hanabi::Server& server);
     double calculatePlayProbability(const PileB::CardKnowledge& card, Hanabi::Color targetColor) const;
     bool isCardPlayable(const Hanabi::Card& card) const;
     bool isCardCritical(const Hanabi::Card& card) const;
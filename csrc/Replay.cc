@@ -0,0 +1,159 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include "Replay.h"
+
+using namespace Hanabi;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////    RecordingServer    ///////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Card> RecordingServer::shuffledDeck_() {
+  /* the deck runGame() would have shuffled, using the same generator */
+  deck_.clear();
+  for (Color color = RED; color <= BLUE; ++color) {
+    for (int value = 1; value <= 5; ++value) {
+      const Card card(color, value);
+      for (int k = 0; k < card.count(); ++k) deck_.push_back(card);
+    }
+  }
+  shuffleDeck();
+  return std::vector<Card>(deck_.rbegin(), deck_.rend());
+}
+
+int RecordingServer::recordGame(const Hanabi::BotFactory &botFactory, int numPlayers) {
+  record_ = GameRecord();
+  record_.numPlayers = numPlayers;
+  record_.deck = shuffledDeck_();
+  record_.score = runGame(botFactory, numPlayers, record_.deck);
+  return record_.score;
+}
+
+int RecordingServer::recordGame(std::vector<Bot*> players) {
+  record_ = GameRecord();
+  record_.numPlayers = players.size();
+  record_.deck = shuffledDeck_();
+  record_.score = runGame(players, record_.deck);
+  return record_.score;
+}
+
+void RecordingServer::pleaseDiscard(int index) {
+  record_.moves.push_back(Move(DISCARD_CARD, index));
+  Server::pleaseDiscard(index);
+}
+
+void RecordingServer::pleasePlay(int index) {
+  record_.moves.push_back(Move(PLAY_CARD, index));
+  Server::pleasePlay(index);
+}
+
+void RecordingServer::pleaseGiveColorHint(int player, Color color) {
+  record_.moves.push_back(Move(HINT_COLOR, color, player));
+  Server::pleaseGiveColorHint(player, color);
+}
+
+void RecordingServer::pleaseGiveValueHint(int player, Value value) {
+  record_.moves.push_back(Move(HINT_VALUE, value, player));
+  Server::pleaseGiveValueHint(player, value);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////    Replay    ////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+/* Makes the recorded moves of its seat, and forwards what it observes. */
+class ReplayBot final : public Bot {
+public:
+  ReplayBot(const GameRecord &record, int &nextMove, const ReplayCallback &beforeMove, Bot *observer)
+    : record_(record), nextMove_(nextMove), beforeMove_(beforeMove), observer_(observer) {}
+
+  void pleaseObserveBeforeMove(const Server &server) override {
+    if (observer_) observer_->pleaseObserveBeforeMove(server);
+  }
+  void pleaseMakeMove(Server &server) override {
+    if (nextMove_ >= (int)record_.moves.size()) {
+      throw std::runtime_error("Replay ran out of moves before the game ended.");
+    }
+    const Move &move = record_.moves[nextMove_++];
+    if (beforeMove_) beforeMove_(server, move);
+    execute_(server.whoAmI(), move, server);
+  }
+  void pleaseObserveBeforeDiscard(const Server &server, int from, int card_index) override {
+    if (observer_) observer_->pleaseObserveBeforeDiscard(server, from, card_index);
+  }
+  void pleaseObserveBeforePlay(const Server &server, int from, int card_index) override {
+    if (observer_) observer_->pleaseObserveBeforePlay(server, from, card_index);
+  }
+  void pleaseObserveColorHint(const Server &server, int from, int to, Color color, CardIndices card_indices) override {
+    if (observer_) observer_->pleaseObserveColorHint(server, from, to, color, card_indices);
+  }
+  void pleaseObserveValueHint(const Server &server, int from, int to, Value value, CardIndices card_indices) override {
+    if (observer_) observer_->pleaseObserveValueHint(server, from, to, value, card_indices);
+  }
+  void pleaseObserveAfterMove(const Server &server) override {
+    if (observer_) observer_->pleaseObserveAfterMove(server);
+  }
+
+private:
+  const GameRecord &record_;
+  int &nextMove_;
+  const ReplayCallback &beforeMove_;
+  Bot *observer_;
+};
+
+}  // namespace
+
+int replayGame(Server &server, const GameRecord &record,
+               const ReplayCallback &beforeMove,
+               const std::vector<Bot*> &observers) {
+  if (!observers.empty() && (int)observers.size() != record.numPlayers) {
+    throw std::runtime_error("replayGame needs one observer per player, or none.");
+  }
+  int nextMove = 0;
+  std::vector<ReplayBot> bots;
+  bots.reserve(record.numPlayers);
+  std::vector<Bot*> players;
+  for (int p = 0; p < record.numPlayers; ++p) {
+    bots.emplace_back(record, nextMove, beforeMove, observers.empty() ? nullptr : observers[p]);
+    players.push_back(&bots.back());
+  }
+  /* stop where the record stops, in case the game was cut short */
+  server.startGame(players, record.deck);
+  return server.runToTurn(record.moves.size());
+}
+
+HandKnowledgeTrace traceHandKnowledge(const GameRecord &record, const Hanabi::BotFactory &botFactory) {
+  Server server;
+  server.setLog(nullptr);
+  HandKnowledgeTrace trace;
+  trace.numPlayers = record.numPlayers;
+  trace.handSize = server.handSize(record.numPlayers);
+  std::vector<Bot*> observers;
+  std::vector<std::shared_ptr<Bot> > owned;
+  for (int p = 0; p < record.numPlayers; ++p) {
+    observers.push_back(botFactory.create(p, record.numPlayers, trace.handSize));
+    owned.emplace_back(observers.back(), [&botFactory](Bot *bot) { botFactory.destroy(bot); });
+    observers.back()->setPermissive(true);
+  }
+  const size_t perSeat = trace.numPlayers * trace.handSize * NUM_KNOWLEDGE_FEATURES;
+  trace.data.reserve(record.moves.size() * trace.numPlayers * perSeat);
+  replayGame(server, record, [&](const Server &s, const Move &) {
+    for (Bot *observer : observers) {
+      trace.data.resize(trace.data.size() + perSeat, KNOWLEDGE_NO);
+      HandKnowledgeTensor out{trace.data.data() + trace.data.size() - perSeat, trace.numPlayers, trace.handSize};
+      observer->writeHandKnowledge(s, out);
+    }
+  }, observers);
+  return trace;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include "Hanabi.h"
+#include "BotUtils.h"
+
+#include <functional>
+#include <vector>
+
+/* A game as dealt and played: enough to replay it move for move, without
+ * running any bot. */
+struct GameRecord {
+  int numPlayers = 0;
+  /* in drawing order, as for Server::runGame()'s stackedDeck */
+  std::vector<Hanabi::Card> deck;
+  std::vector<Move> moves;
+  int score = 0;
+};
+
+/* A Server that records the deck and every move of the games it runs.
+ * Given the same seed, it deals the same decks as Server::runGame(). */
+class RecordingServer : public Hanabi::Server {
+public:
+  int recordGame(const Hanabi::BotFactory &botFactory, int numPlayers);
+  int recordGame(std::vector<Hanabi::Bot*> players);
+  const GameRecord &record() const { return record_; }
+
+  void pleaseDiscard(int index) override;
+  void pleasePlay(int index) override;
+  void pleaseGiveColorHint(int player, Hanabi::Color color) override;
+  void pleaseGiveValueHint(int player, Hanabi::Value value) override;
+
+private:
+  std::vector<Hanabi::Card> shuffledDeck_();
+
+  GameRecord record_;
+};
+
+/* Called before each replayed move with the server as it stands (any hand
+ * can be inspected with cheatGetHand()) and the move about to be made. */
+typedef std::function<void(const Hanabi::Server &, const Move &)> ReplayCallback;
+
+/* Replays a recorded game on server without running any bot policy: the
+ * deck is stacked and each seat makes its recorded move, up to the last
+ * one recorded (so games cut short, e.g. by a question, replay too).
+ * Observers, if given (one per seat), receive every pleaseObserve* call of
+ * the original game, e.g. to rebuild a bot's hand knowledge, but are never
+ * asked to move. Returns the final score, which matches record.score
+ * unless the record is corrupt. */
+int replayGame(Hanabi::Server &server, const GameRecord &record,
+               const ReplayCallback &beforeMove=nullptr,
+               const std::vector<Hanabi::Bot*> &observers={});
+
+/* What each seat knew before every move of a game, as written by
+ * Bot::writeHandKnowledge(): data is laid out
+ * [move][seat][player][slot][NUM_KNOWLEDGE_FEATURES]. Empty slots are all
+ * KNOWLEDGE_NO. */
+struct HandKnowledgeTrace {
+  int numPlayers = 0;
+  int handSize = 0;
+  std::vector<int8_t> data;
+};
+
+/* Replays record with a (permissive) bot from botFactory observing from
+ * each seat, and traces their hand knowledge. */
+HandKnowledgeTrace traceHandKnowledge(const GameRecord &record, const Hanabi::BotFactory &botFactory);
@@ -0,0 +1,161 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <string>
+#include <boost/fiber/fss.hpp>
+
+namespace Params {
+  std::string getParameterString(
+    const std::string &name,
+    std::string default_val,
+    const std::string help=""
+  );
+  int getParameterInt(
+    const std::string &name,
+    int default_val,
+    const std::string help=""
+  );
+  float getParameterFloat(
+    const std::string &name,
+    float default_val,
+    const std::string help=""
+  );
+}
+
+/* Every tunable parameter lives in one of the Config structs below. The
+ * environment variable of the same name only provides the default value of a
+ * field; a RunParams can be modified and bound at runtime (see RunParamsScope),
+ * so a single process can run a whole sweep. */
+
+namespace HanabiParams {
+  struct Config {
+    // return a score of 0 when bombing out
+    int BOMB0 = Params::getParameterInt("BOMB0", 0,
+      "If 1, then the score is 0 if agents bomb out (official rules).");
+    int BOMBD = Params::getParameterInt("BOMBD", 1,
+      "Subtract this number of points from the score when bombing out.");
+    int FIBER_THREADS = Params::getParameterInt("FIBER_THREADS", 10,
+      "Number of threads in the thread pool that executes fibers (i.e. # cores to use).");
+    int NUM_THREADS = Params::getParameterInt("NUM_THREADS", 1000,
+      "Number of user-space threads (i.e. fibers) to use for search (i.e. max parallelism). "
+      "These fibers are run on the fiber thread pool defined by FIBER_THREADS");
+    int HAND_SIZE_OVERRIDE = Params::getParameterInt("HAND_SIZE_OVERRIDE", -1,
+      "If >0, this overrides the hand size. Must be >= 3.");
+  };
+} // namespace HanabiParams
+
+namespace SearchBotParams {
+  struct Config {
+    std::string BPBOT = Params::getParameterString("BPBOT", "SmartBot",
+      "The blueprint agent to use for search.");
+    int SEARCH_PLAYER = Params::getParameterInt("SEARCH_PLAYER", -1,
+      "For single-agent search, which player performs search (negative numbers count from the end).");
+    int SEARCH_ALL = Params::getParameterInt("SEARCH_ALL", 0,
+      "If 1, all agents perform search independently (unsound)");
+    float SEARCH_THRESH = Params::getParameterFloat("SEARCH_THRESH", 0.1,
+      "Search deviates from the blueprint only if the EV of a move exceeds the blueprint action EV by SEARCH_THRESH.");
+    int SEARCH_N = Params::getParameterInt("SEARCH_N", 10000,
+      "Number of MC rollouts to perform for search.");
+    int DOUBLE_SEARCH = Params::getParameterInt("DOUBLE_SEARCH", 0,
+      "Perform a second (independent) search to use as an unbiased estimator of the true scores.");
+    float PARTNER_UNIFORM_UNC = Params::getParameterFloat("PARTNER_UNIFORM_UNC", 0.,
+      "Add 'uniform' uncertainty to the belief update. Should be 0-1, with 1 corresponding to assuming a uniform policy.");
+    float PARTNER_BOLTZMANN_UNC = Params::getParameterFloat("PARTNER_BOLTZMANN_UNC", 0.,
+      "Assume the TorchBot partner plays a Boltzmann distribution of actions proportional to exp(Q_a / T), where T is chosen so the 'best' action is played with probability 1-unc. (TorchBot only).");
+
+    int OPTIMIZE_WINS = Params::getParameterInt("OPTIMIZE_WINS", 0,
+      "Have search ptimize for wins (25 points) rather than max score. This tends to produce worse scores *and* fewer wins, due to bad reward shaping.");
+    int UCB = Params::getParameterInt("UCB", 1,
+      "Use UCB for search MC rollouts.");
+    int SEARCH_BASELINE = Params::getParameterInt("SEARCH_BASELINE", 0,
+      "If 1, subtract blueprint action EV from EVs for other actions during MC rollouts; reduces the number of MC rollouts required.");
+    int DELAYED_OBS_THRESH = Params::getParameterInt("DELAYED_OBS_THRESH", 100000,
+      "Only apply observations to belief bots if the range is below this size. For TorchBot, this trades off time vs space "
+      "(higher THRESH uses less memory at the cost of more compute).");
+    std::string SEARCH_PROFILE_JSON = Params::getParameterString("SEARCH_PROFILE_JSON", "",
+      "If set, SearchBot appends its profile of every game (see SearchProfile.h), one JSON object per line, to this file.");
+    int SEARCH_LOG = Params::getParameterInt("SEARCH_LOG", 0,
+      "If 1, the searchers log every belief update and search to stderr, with timestamps. Off, only the SearchProfile counts them.");
+  };
+} // namespace SearchBotParams
+
+namespace JointSearchBotParams {
+  struct Config {
+    int RANGE_MAX = Params::getParameterInt("RANGE_MAX", 2000,
+      "For JointSearchBot, the max range to perform search. Higher allows more search, at a higher computational cost.");
+    int JOINT_SEARCH_SEED = Params::getParameterInt("JOINT_SEARCH_SEED", 12345,
+      "For JointSearchBot, the shared seed to use to select MC samples for search.");
+    int MEMOIZE_RANGE_SEARCH = Params::getParameterInt("MEMOIZE_RANGE_SEARCH", 0,
+      "For JointSearchBot, if 1 then speed up play by only performing common-knowledge belief updates once and copying it to the other agent.");
+  };
+} // namespace JointSearchBotParams
+
+namespace TorchBotParams {
+  struct Config {
+    std::string TORCHBOT_MODEL = Params::getParameterString("TORCHBOT_MODEL", "",
+      "File path to the TorchBot model, saved as serialized TorchScript (required for TorchBot)");
+    std::string TORCHBOT_DEVICE = Params::getParameterString("TORCHBOT_DEVICE", "auto",
+      "Device that runs TorchBot inference, e.g. 'cpu' or 'cuda:0'. 'auto' uses cuda:0 if available, else cpu.");
+    int TORCHBOT_BATCH_SIZE = Params::getParameterInt("TORCHBOT_BATCH_SIZE", 400,
+      "Max number of TorchBot inferences batched into a single model call.");
+    int TORCHBOT_MAX_DELAY_US = Params::getParameterInt("TORCHBOT_MAX_DELAY_US", 0,
+      "Microseconds to wait for a TorchBot batch to fill before running it. 0 runs whatever is ready.");
+    int TORCHBOT_INTRAOP_THREADS = Params::getParameterInt("TORCHBOT_INTRAOP_THREADS", 0,
+      "Torch intra-op threads for TorchBot inference (separate from FIBER_THREADS). 0 uses the torch default.");
+    std::string TORCHBOT_HIDDEN_DTYPE = Params::getParameterString("TORCHBOT_HIDDEN_DTYPE", "float32",
+      "Storage type of TorchBot LSTM hidden states: float32, float16 or bfloat16 (half the memory, slightly lossy).");
+  };
+} // namespace TorchBotParams
+
+
+struct RunParams {
+  HanabiParams::Config hanabi;
+  SearchBotParams::Config search;
+  JointSearchBotParams::Config joint;
+  TorchBotParams::Config torch;
+
+  /* The params bound to the calling fiber by a RunParamsScope, or else the
+   * process defaults. Fibers do not inherit their creator's binding: servers
+   * and bots copy what they need when they are constructed, so fibers
+   * spawned by a bot keep using the bot's params. */
+  static const RunParams &current();
+  /* The process defaults, initialized from the environment. */
+  static RunParams &defaults();
+  /* Per fiber rather than per thread, since pool fibers migrate between
+   * workers when they yield. */
+  static boost::fibers::fiber_specific_ptr<RunParams> &bound_();
+};
+
+/* Binds params to the calling fiber for the lifetime of the scope. */
+class RunParamsScope {
+public:
+  explicit RunParamsScope(const RunParams *params) : prev_(RunParams::bound_().get()) {
+    /* fiber_specific_ptr cannot hold a const pointer; nothing writes through it */
+    RunParams::bound_().reset(const_cast<RunParams*>(params));
+  }
+  ~RunParamsScope() { RunParams::bound_().reset(const_cast<RunParams*>(prev_)); }
+private:
+  const RunParams *prev_;
+};
+
+inline RunParams &RunParams::defaults() {
+  static RunParams params;
+  return params;
+}
+
+inline boost::fibers::fiber_specific_ptr<RunParams> &RunParams::bound_() {
+  /* the scopes own the params, so nothing is freed when a fiber ends; never
+   * destroyed, as fibers may still run during static destruction */
+  static auto *params = new boost::fibers::fiber_specific_ptr<RunParams>([](RunParams*) {});
+  return *params;
+}
+
+inline const RunParams &RunParams::current() {
+  const RunParams *params = bound_().get();
+  return params ? *params : defaults();
+}
@@ -13,19 +13,14 @@
 #include <algorithm>
 #include <atomic>
 #include <cstring>
+#include <deque>
 #include "SearchBot.h"
+#include "InferenceStats.h"
 #include <thread>
 #include <mutex>
 #include <shared_mutex>
 
 using namespace Hanabi;
-using namespace HanabiParams;
-using namespace SearchBotParams;
-
-namespace SearchBotParams {
-  float SEARCH_THRESH = Params::getParameterFloat("SEARCH_THRESH", 0.1,
-    "Search deviates from the blueprint only if the EV of a move exceeds the blueprint action EV by SEARCH_THRESH.");
-}
 
 static void _registerBots() {
   registerBotFactory("SearchBot", std::shared_ptr<Hanabi::BotFactory>(new ::BotFactory<SearchBot>()));
@@ -34,19 +29,22 @@ static void _registerBots() {
 static int dummy =  (_registerBots(), 0);
 
 
-void applyDelayedObservations(HandDist &handDist, const std::vector<BoxedHand> &handDistKeys) {
-  if (handDist.size() > DELAYED_OBS_THRESH) {
+int applyDelayedObservations(HandDist &handDist, const std::vector<BoxedHand> &handDistKeys, const RunParams &params) {
+  if (handDist.size() > params.search.DELAYED_OBS_THRESH) {
     // bail to save memory
-    return;
+    return 0;
   }
   std::vector<boost::fibers::future<void>> futures;
-  std::cerr << now() << "Applying "
-    << handDist[handDistKeys[0]].delayed_observations.size() << " observations to "
-    << handDistKeys.size() << " bots." << std::endl;
+  if (params.search.SEARCH_LOG) {
+    std::cerr << now() << "Applying "
+      << handDist[handDistKeys[0]].delayed_observations.size() << " observations to "
+      << handDistKeys.size() << " bots." << std::endl;
+  }
 
-  for (int t = 0; t < NUM_THREADS; t++) {
+  const int num_threads = params.hanabi.NUM_THREADS;
+  for (int t = 0; t < num_threads; t++) {
     futures.push_back(getThreadPool().enqueue([&, t]() {
-      for (int i = t; i < handDistKeys.size(); i += NUM_THREADS) {
+      for (int i = t; i < handDistKeys.size(); i += num_threads) {
         auto key = handDistKeys[i];
         handDist.at(key).applyObservations();
       }
@@ -55,23 +53,25 @@ void applyDelayedObservations(HandDist &handDist, const std::vector<BoxedHand> &
   for (auto &f: futures) {
     f.get();
   }
-  std::cerr << now() << "Done applying delayed observations." << std::endl;
+  if (params.search.SEARCH_LOG) std::cerr << now() << "Done applying delayed observations." << std::endl;
+  return handDistKeys.size();
 }
 
 
-SearchBot::SearchBot(int index, int numPlayers, int handSize) : simulserver_(numPlayers)
+SearchBot::SearchBot(int index, int numPlayers, int handSize)
+  : params_(RunParams::current()), simulserver_(numPlayers)
 {
-  std::cerr << now() << "SearchBotParams {" << std::endl; // legacy
-
   me_ = index;
   last_move_ = std::vector<Move>(numPlayers, Move());
-  std::cerr << now() << "Initializing sub-bots..." << std::endl;
-  auto botFactory = getBotFactory(SearchBotParams::BPBOT);
+  game_profile_.player = index;
+  game_profile_.numPlayers = numPlayers;
+  if (params_.search.SEARCH_LOG) std::cerr << now() << "Initializing sub-bots..." << std::endl;
+  auto botFactory = getBotFactory(params_.search.BPBOT);
 
   for (int player = 0; player < numPlayers; player++) {
     auto bot = botFactory->create(player, numPlayers, handSize);
-    if (PARTNER_BOLTZMANN_UNC > 0 && player != me_) {
-      bot->setActionUncertainty(PARTNER_BOLTZMANN_UNC);
+    if (params_.search.PARTNER_BOLTZMANN_UNC > 0 && player != me_) {
+      bot->setActionUncertainty(params_.search.PARTNER_BOLTZMANN_UNC);
     }
     players_.push_back(std::shared_ptr<Bot>(bot));
     players_.back()->setPermissive(true); // because we may not follow the blueprint
@@ -86,7 +86,7 @@ void SearchBot::populateInitialHandDistribution_(Hand &hand, float prob, DeckCom
     hand.reserve(handSize);
   }
   if (hand.size() == handSize) {
-    if (handDist.size() % 1000000 == 0) {
+    if (params_.search.SEARCH_LOG && handDist.size() % 1000000 == 0) {
       std::cerr << now() << "Generated " << handDist.size() << " hands." << std::endl;
     }
     // assert(handDist.count(hand) == 0);
@@ -108,6 +108,7 @@ void SearchBot::populateInitialHandDistribution_(Hand &hand, float prob, DeckCom
 }
 
 void SearchBot::applyToAll(ObservationFunc f) {
+  ScopedTimer timer(&move_profile_.beliefSecs);
   simulserver_.applyToAll(f, hand_distribution_, me_);
 }
 
@@ -115,12 +116,16 @@ void SearchBot::init_(const Server &server) {
   // we have to generate the initial hand distribution here rather than in the constructor
   // because we need access to the server to know what the partner hand is
   assert(hand_distribution_.empty());
-  std::cerr << now() << "Generating initial hand distribution..." << std::endl;
+  ScopedTimer timer(&move_profile_.rangeInitSecs);
+  if (params_.search.SEARCH_LOG) std::cerr << now() << "Generating initial hand distribution..." << std::endl;
   DeckComposition deck = getCurrentDeckComposition(server, me_);
   Hand hand;
   auto partners = cloneBotVec(players_, me_);
+  move_profile_.botClones += server.numPlayers() - 1;
   populateInitialHandDistribution_(hand, 1, deck, server.handSize(), me_, hand_distribution_, partners);
-  std::cerr << now() << "Hand distribution contains " << hand_distribution_.size() << " hands." << std::endl;
+  if (params_.search.SEARCH_LOG) {
+    std::cerr << now() << "Hand distribution contains " << hand_distribution_.size() << " hands." << std::endl;
+  }
 }
 
 void SearchBot::pleaseObserveBeforeMove(const Server &server) {
@@ -133,11 +138,11 @@ void SearchBot::pleaseObserveBeforeMove(const Server &server) {
 
   assert(server.whoAmI() == me_);
   simulserver_.sync(server);
-  std::cerr << now() << "applyToAll ObserveBeforeMove start" << std::endl;
+  if (params_.search.SEARCH_LOG) std::cerr << now() << "applyToAll ObserveBeforeMove start" << std::endl;
   applyToAll(
     [](Bot *bot, const Server &server) { bot->pleaseObserveBeforeMove(server); }
   );
-  std::cerr << now() << "applyToAll ObserveBeforeMove end" << std::endl;
+  if (params_.search.SEARCH_LOG) std::cerr << now() << "applyToAll ObserveBeforeMove end" << std::endl;
 
 }
 
@@ -209,14 +214,13 @@ void SearchBot::pleaseObserveAfterMove(const Server &server) {
   );
   if(server.gameOver() || server.finalCountdown() == server.numPlayers()) {
     std::cout << "SearchBot changed " << changed_moves_ << " moves, gaining ";
-    if (DOUBLE_SEARCH) {
+    if (params_.search.DOUBLE_SEARCH) {
       std::cout << unbiased_score_difference_ << " (unbiased) " << score_difference_ << " (biased) ";
       std::cout << "Win delta: " << unbiased_win_difference_ << " (unbiased) ";
     } else {
       std::cout << score_difference_;
     }
     std::cout << " points. Total search iters: " << total_iters_ << std::endl;
-
   }
 }
 
@@ -229,7 +233,10 @@ void SearchBot::filterBeliefsConsistentWithHint_(
   if (move.to != me_) {
     return;
   }
-  filterBeliefsConsistentWithHint_(from, move, card_indices, server, hand_distribution_);
+  {
+    ScopedTimer timer(&move_profile_.hintFilterSecs);
+    filterBeliefsConsistentWithHint_(from, move, card_indices, server, hand_distribution_);
+  }
   checkBeliefs_(server);
 
 }
@@ -264,9 +271,11 @@ void SearchBot::filterBeliefsConsistentWithHint_(
       handDist.erase(hand);
     }
   }
-  std::cerr << now() << "Player " << me_ << ": Filtered beliefs consistent with hint " << move.toString()
-            << " reduced from " << old_size << " to " <<
-            handDist.size() << std::endl;
+  if (params_.search.SEARCH_LOG) {
+    std::cerr << now() << "Player " << me_ << ": Filtered beliefs consistent with hint " << move.toString()
+              << " reduced from " << old_size << " to " <<
+              handDist.size() << std::endl;
+  }
 }
 
 void SearchBot::filterBeliefsConsistentWithAction_(const Move &move, int from, const Server &server) {
@@ -274,7 +283,7 @@ void SearchBot::filterBeliefsConsistentWithAction_(const Move &move, int from, c
     return;
   }
 
-  {
+  if (params_.search.SEARCH_LOG) {
     // just for logging
     auto cheat_hand = server.cheatGetHand(me_);
     auto cheat_bot = hand_distribution_[cheat_hand].getPartner(from);
@@ -284,33 +293,40 @@ void SearchBot::filterBeliefsConsistentWithAction_(const Move &move, int from, c
     std::cerr << "SearchBot expected " << expected_move.toString() << " , observed " << move.toString() << std::endl;
   }
 
-  if (PARTNER_UNIFORM_UNC == 1) {
+  const float uniform_unc = params_.search.PARTNER_UNIFORM_UNC;
+  if (uniform_unc == 1) {
     return;
   }
   size_t old_size = hand_distribution_.size();
-  std::cerr << now() << "filterAction_ with " << old_size << " beliefs." << std::endl;
+  if (params_.search.SEARCH_LOG) std::cerr << now() << "filterAction_ with " << old_size << " beliefs." << std::endl;
   auto hand_dist_keys = copyKeys(hand_distribution_);
-  applyDelayedObservations(hand_distribution_, hand_dist_keys);
+  {
+    ScopedTimer timer(&move_profile_.delayedObsSecs);
+    move_profile_.botClones += applyDelayedObservations(hand_distribution_, hand_dist_keys, params_) * (server.numPlayers() - 1);
+  }
+  ScopedTimer timer(&move_profile_.actionFilterSecs);
+  move_profile_.botClones += hand_dist_keys.size();
   std::vector<boost::fibers::future<void>> futures;
-  for (int t = 0; t < NUM_THREADS; t++) {
+  const int num_threads = params_.hanabi.NUM_THREADS;
+  for (int t = 0; t < num_threads; t++) {
     futures.push_back(getThreadPool().enqueue([&, t]() {
       SimulServer simulserver(simulserver_);
-      for (int i = t; i < hand_dist_keys.size(); i += NUM_THREADS) {
+      for (int i = t; i < hand_dist_keys.size(); i += num_threads) {
         auto &hand = hand_dist_keys[i];
         simulserver.setHand(me_, hand);
         auto bot = hand_distribution_[hand].getPartner(from);
-        if (PARTNER_BOLTZMANN_UNC > 0) {
+        if (params_.search.PARTNER_BOLTZMANN_UNC > 0) {
           auto action_probs = bot->getActionProbs();
-          if (server.cheatGetHand(me_) == hand.get()) {
+          if (params_.search.SEARCH_LOG && server.cheatGetHand(me_) == hand.get()) {
             for (auto kv : action_probs) std::cerr << "Action " << kv.first << " : " <<kv.second << std::endl;
             std::cerr << "Prob of " << move.toString() << " ( " << moveToIndex(move, server) << ") : " << action_probs[moveToIndex(move, server)] << std::endl;
           }
-          hand_distribution_[hand].prob *= (action_probs[moveToIndex(move, server)] + PARTNER_UNIFORM_UNC);
+          hand_distribution_[hand].prob *= (action_probs[moveToIndex(move, server)] + uniform_unc);
         } else {
           Move cf_move = simulserver.simulatePlayerMove(from, bot.get());
 
           if (move != cf_move) {
-            hand_distribution_[hand].prob *= PARTNER_UNIFORM_UNC;
+            hand_distribution_[hand].prob *= uniform_unc;
           }
         }
       }
@@ -324,14 +340,18 @@ void SearchBot::filterBeliefsConsistentWithAction_(const Move &move, int from, c
       hand_distribution_.erase(hand);
     }
   }
-  std::cerr << now() << "Player " << me_ << ": Filtered beliefs consistent with player " << from << " action '" << move.toString()
-            << "' reduced from " << old_size << " to " <<
-            hand_distribution_.size() << std::endl;
+  move_profile_.peakRangeSize = std::max<long>(move_profile_.peakRangeSize, old_size);
+  if (params_.search.SEARCH_LOG) {
+    std::cerr << now() << "Player " << me_ << ": Filtered beliefs consistent with player " << from << " action '" << move.toString()
+              << "' reduced from " << old_size << " to " <<
+              hand_distribution_.size() << std::endl;
+  }
 
   checkBeliefs_(server);
 }
 
 void SearchBot::updateBeliefsFromDraw_(int who, int card_index, Card played_card, const Server &server) {
+  ScopedTimer timer(&move_profile_.drawUpdateSecs);
   if (who == me_) {
     updateBeliefsFromMyDraw_(who, card_index, played_card, server, hand_distribution_, false);
   } else if (server.sizeOfHandOfPlayer(who) == server.handSize()) {
@@ -398,9 +418,11 @@ void SearchBot::updateBeliefsFromMyDraw_(
     addToDeck(new_hand, deck);
 
   }
-  std::cerr << now() << "Player " << me_ << ": Filtered player " << who << " beliefs consistent with my draw; went from "
-            << handDist.size() << " to " <<
-            new_hand_distribution.size() << std::endl;
+  if (params_.search.SEARCH_LOG) {
+    std::cerr << now() << "Player " << me_ << ": Filtered player " << who << " beliefs consistent with my draw; went from "
+              << handDist.size() << " to " <<
+              new_hand_distribution.size() << std::endl;
+  }
   handDist = new_hand_distribution;
 }
 
@@ -434,9 +456,11 @@ void SearchBot::updateBeliefsFromRevealedCard_(
       }
     }
   }
-  std::cerr << now() << "Player " << me_ << ": Filtered player " << who << " beliefs consistent with revealed card " << revealed_card.toString()
-            << " reduced from " << old_size << " to " <<
-            handDist.size() << std::endl;
+  if (params_.search.SEARCH_LOG) {
+    std::cerr << now() << "Player " << me_ << ": Filtered player " << who << " beliefs consistent with revealed card " << revealed_card.toString()
+              << " reduced from " << old_size << " to " <<
+              handDist.size() << std::endl;
+  }
 }
 
 void SearchBot::checkBeliefs_(const Server &server) const {
@@ -482,24 +506,24 @@ Hand sampleFromCDF_(const HandDistCDF &cdf, std::mt19937 &gen) {
     assert(0);
   }
   Hand hand = cdf.hands[idx];
-  assert(cdf.probs[idx + 1] - cdf.probs[idx] > 0 || idx + 1 == cdf.probs.size());
+  assert(idx + 1 == cdf.probs.size() || cdf.probs[idx + 1] - cdf.probs[idx] > 0);
   // std::cerr << now() << "Got prob " << prob << " sampled idx " << idx << " i.e. hand " << handAsString(hand) << " cdf: " << cdf.probs[idx] << std::endl;
   return hand;
 }
 
-bool canPruneMove(const SearchStats &stats, Move move, Move bp_move) {
-  if (SEARCH_BASELINE && move == bp_move) {
+bool canPruneMove(const SearchStats &stats, Move move, Move bp_move, const SearchBotParams::Config &params) {
+  if (params.SEARCH_BASELINE && move == bp_move) {
     return false;
   }
 
-  if (!UCB) {
+  if (!params.UCB) {
     return false;
   }
 
   const UCBStats &this_ucb = stats.at(move);
 
   Move best_move(INVALID_MOVE, 0);
-  if (SEARCH_BASELINE) {
+  if (params.SEARCH_BASELINE) {
     double best_stderr = 0;
     double best_mean = -100;
     for (auto &kv: stats) {
@@ -534,10 +558,10 @@ bool canPruneMove(const SearchStats &stats, Move move, Move bp_move) {
 
 
 
-std::string oneMoveStatToString(const SearchStats &stats, Move m) {
+std::string oneMoveStatToString(const SearchStats &stats, Move m, const SearchBotParams::Config &params) {
   if(stats.count(m)) {
     char buff[100];
-    if (SEARCH_BASELINE) {
+    if (params.SEARCH_BASELINE) {
       snprintf(buff, sizeof(buff), "%6.2f +/- %4.2g (%4d)",
         stats.at(m).mean,
         ((float)((int) (stats.at(m).search_baseline_stderr() * 100))) / 100, stats.at(m).N);
@@ -553,17 +577,18 @@ std::string oneMoveStatToString(const SearchStats &stats, Move m) {
   }
 }
 
-void logSearchResults(const SearchStats &stats, int numPlayers, int me) {
+void logSearchResults(const SearchStats &stats, int numPlayers, int me, const SearchBotParams::Config &params) {
+  if (!params.SEARCH_LOG) return;
   std::cerr << now() << "Play:            ";
   for (int i = 0; i < 5; i++) {
     std::cerr << i << ": ";
-    std::cerr << oneMoveStatToString(stats, Move(PLAY_CARD, i)) << " ";
+    std::cerr << oneMoveStatToString(stats, Move(PLAY_CARD, i), params) << " ";
   }
   std::cerr << std::endl;
   std::cerr << now() << "Discard:         ";
   for (int i = 0; i < 5; i++) {
     std::cerr << i << ": ";
-    std::cerr << oneMoveStatToString(stats, Move(DISCARD_CARD, i)) << " ";
+    std::cerr << oneMoveStatToString(stats, Move(DISCARD_CARD, i), params) << " ";
   }
   std::cerr << std::endl;
   for (int to = 0; to < numPlayers; to++) {
@@ -571,13 +596,13 @@ void logSearchResults(const SearchStats &stats, int numPlayers, int me) {
     std::cerr << now() << "Hint Color to " << to << ": ";
     for (Color color = RED; color < NUMCOLORS; color++) {
       std::cerr << colorname(color)[0] << ": ";
-      std::cerr << oneMoveStatToString(stats, Move(HINT_COLOR, color, to)) << " ";
+      std::cerr << oneMoveStatToString(stats, Move(HINT_COLOR, color, to), params) << " ";
     }
     std::cerr << std::endl;
     std::cerr << now() << "Hint Value to " << to << ": ";
     for (Value value = ONE; value <= VALUE_MAX; value++) {
       std::cerr << value << ": ";
-      std::cerr << oneMoveStatToString(stats, Move(HINT_VALUE, value, to)) << " ";
+      std::cerr << oneMoveStatToString(stats, Move(HINT_VALUE, value, to), params) << " ";
     }
     std::cerr << std::endl;
   }
@@ -684,19 +709,19 @@ int oneSearchIter_(
 }
 
 
-inline void accumScore(int score, int bp_score, Move &move, SearchStats &stats, SearchStats *win_stats) {
+inline void accumScore(int score, int bp_score, Move &move, SearchStats &stats, SearchStats *win_stats, const SearchBotParams::Config &params) {
   if (score == -1) { // skipped
     return;
   }
   assert(score >= 0);
 
   int adj_score = score;
-  if (SEARCH_BASELINE) {
+  if (params.SEARCH_BASELINE) {
     assert(bp_score >= 0);
     adj_score = score - bp_score;
   }
 
-  stats[move].add(OPTIMIZE_WINS ? (score == 25 ? 1 : 0) : adj_score);
+  stats[move].add(params.OPTIMIZE_WINS ? (score == 25 ? 1 : 0) : adj_score);
   if (win_stats) {
     (*win_stats)[move].add(score == 25);
   }
@@ -719,6 +744,7 @@ Move SearchBot::doSearch_(
   // slow to update them for public -> private conversion. The probabilities in
   // cdf are considered the ground truth for the purposes of search
 
+  ScopedTimer timer(&move_profile_.searchSecs);
   std::vector<Move> moves = enumerateLegalMoves(server);
   int num_moves = moves.size();
 
@@ -726,9 +752,10 @@ Move SearchBot::doSearch_(
     stats[move] = UCBStats();
     if (win_stats) (*win_stats)[move] = UCBStats();
   }
-  stats[bp_move].bias = SEARCH_THRESH;
+  const SearchBotParams::Config &params = params_.search;
+  stats[bp_move].bias = params.SEARCH_THRESH;
   std::atomic<int> loop_count(0);
-  if (verbose) {
+  if (verbose && params.SEARCH_LOG) {
     std::cerr << now() << "search player " << server.whoAmI() << " start" << std::endl;
   }
 
@@ -746,24 +773,27 @@ Move SearchBot::doSearch_(
   }
 
   //We use this to facilitate baseline usage. Shouldn't make a big difference
-  int temp_num_threads = NUM_THREADS - (NUM_THREADS % num_moves);
+  const int num_threads = params_.hanabi.NUM_THREADS;
+  int temp_num_threads = num_threads - (num_threads % num_moves);
   assert(temp_num_threads >= num_moves);
 
   //std::cerr << "Temporary number of threads: " << temp_num_threads << std::endl;
-  int temp_search_n = SEARCH_N - (SEARCH_N % temp_num_threads);
+  int temp_search_n = params.SEARCH_N - (params.SEARCH_N % temp_num_threads);
 
   std::vector<boost::fibers::future<void>> futures;
   std::mutex mtx;
   Barrier barrier(temp_num_threads);
 
   std::uniform_int_distribution<int> uid1(0, 1 << 30);
-  std::vector<int> seeds(SEARCH_N / num_moves + 1);
+  std::vector<int> seeds(params.SEARCH_N / num_moves + 1);
   for(int i = 0; i < seeds.size(); i++) seeds[i] = uid1(gen);
 
-  std::vector<int> scores(SEARCH_N, -2);
+  std::vector<int> scores(params.SEARCH_N, -2);
   int accumed = 0;
+  double barrier_wait_secs = 0;
   for (int t = 0; t < temp_num_threads; t++) {
     futures.push_back(getThreadPool().enqueue([&, t](){
+      double wait_secs = 0;
       for (int j = t; j < temp_search_n; j += temp_num_threads) {
         if (frame_bail || prune_count >= num_moves - 1) {
           break;
@@ -787,17 +817,20 @@ Move SearchBot::doSearch_(
         }
 
         // single-threaded stuff
-        if (UCB && j + temp_num_threads < temp_search_n) {
-          barrier.wait();
+        if (params.UCB && j + temp_num_threads < temp_search_n) {
+          {
+            ScopedTimer wait_timer(&wait_secs);
+            barrier.wait();
+          }
 
           if (t == 0) {
             for (int k = j; k < j + temp_num_threads; k++) {
               int bp_score = scores[k - (k % num_moves) + bp_mi];
-              accumScore(scores[k], bp_score, moves[k % num_moves], stats, win_stats);
+              accumScore(scores[k], bp_score, moves[k % num_moves], stats, win_stats, params);
             }
 
             for (int mi = 0; mi < num_moves; mi++) {
-              if (!stats[moves[mi]].pruned && canPruneMove(stats, moves[mi], bp_move)) {
+              if (!stats[moves[mi]].pruned && canPruneMove(stats, moves[mi], bp_move, params)) {
                 stats[moves[mi]].pruned = true;
                 prune_count++;
                 if (moves[mi] == frame_move) {
@@ -808,21 +841,28 @@ Move SearchBot::doSearch_(
             accumed += temp_num_threads;
           } // if (t == 0)
 
+          ScopedTimer wait_timer(&wait_secs);
           barrier.wait();
         }
       }
+      std::lock_guard<std::mutex> lock(mtx);
+      barrier_wait_secs += wait_secs;
     }));
   }
   for(auto &f: futures) {
     f.get();
   }
+  move_profile_.rollouts += loop_count;
+  move_profile_.rolloutsPruned += temp_search_n - loop_count;
+  move_profile_.botClones += loop_count * server.numPlayers();
+  move_profile_.barrierWaitSecs += barrier_wait_secs;
   if (frame_bail) { //Then all that matters is we didn't choose the observed action
     return Move();
   }
   if (prune_count < num_moves - 1) { // accumulate the stragglers
     for (int k = accumed; k < temp_search_n; k++) {
       int bp_score = scores[k - (k % num_moves) + bp_mi];
-      accumScore(scores[k], bp_score, moves[k % num_moves], stats, win_stats);
+      accumScore(scores[k], bp_score, moves[k % num_moves], stats, win_stats, params);
     }
   }
 
@@ -836,7 +876,7 @@ Move SearchBot::doSearch_(
       best_score = kv.second.mean + kv.second.bias;
     }
   }
-  if (verbose) {
+  if (verbose && params.SEARCH_LOG) {
     std::cerr << now() << "Ran " << loop_count << " search iters over " << num_moves << " moves. ( " << server.handsAsString()
               << " ) , p " << server.whoAmI() << " --> " << best_move.toString() << " (" << stats[best_move].mean << ") [bp " << bp_move.toString() << " (" << stats[bp_move].mean << ") ]" << std::endl << std::flush;
   }
@@ -847,21 +887,26 @@ void SearchBot::pleaseMakeMove(Server &server)
 {
     simulserver_.sync(server);
     Move bp_move = simulserver_.simulatePlayerMove(me_, players_[me_].get());
-    std::cerr << now() << "Blueprint strat says to play " << bp_move.toString() << std::endl;
+    if (params_.search.SEARCH_LOG) std::cerr << now() << "Blueprint strat says to play " << bp_move.toString() << std::endl;
 
     SearchStats stats;
     auto hand_dist_keys = copyKeys(hand_distribution_);
-    applyDelayedObservations(hand_distribution_, hand_dist_keys);
+    {
+      ScopedTimer timer(&move_profile_.delayedObsSecs);
+      move_profile_.botClones += applyDelayedObservations(hand_distribution_, hand_dist_keys, params_) * (server.numPlayers() - 1);
+    }
     HandDistCDF cdf = populateHandDistCDF(hand_distribution_);
     Move move = doSearch_(me_, bp_move, Move(), players_[me_].get(), hand_distribution_, cdf, stats, gen_, server);
-    logSearchResults(stats, server.numPlayers(), me_);
-    if (bp_move != move) std::cerr << now() << "Search changed move. ";
-    std::cerr << now() << "Blueprint picked " << bp_move.toString() << " with average score " << stats[bp_move].mean
-              << "; search picked " << move.toString() << " with average score " << stats[move].mean << std::endl;
+    logSearchResults(stats, server.numPlayers(), me_, params_.search);
+    if (params_.search.SEARCH_LOG) {
+      if (bp_move != move) std::cerr << now() << "Search changed move. ";
+      std::cerr << now() << "Blueprint picked " << bp_move.toString() << " with average score " << stats[bp_move].mean
+                << "; search picked " << move.toString() << " with average score " << stats[move].mean << std::endl;
+    }
     if (move != bp_move) {
       changed_moves_++;
       score_difference_ += stats[move].mean - stats[bp_move].mean;
-      if (DOUBLE_SEARCH) {
+      if (params_.search.DOUBLE_SEARCH) {
         SearchStats unbiased_stats;
         SearchStats unbiased_win_stats;
         doSearch_(me_, bp_move, Move(), players_[me_].get(), hand_distribution_, cdf, unbiased_stats, gen_, server, false, &unbiased_win_stats);
@@ -870,5 +915,109 @@ void SearchBot::pleaseMakeMove(Server &server)
       }
     }
 
+    endMoveProfile_();
     execute_(me_, move, server);
 }
+
+void SearchBot::endMoveProfile_() {
+  move_profile_.moves = 1;
+  move_profile_.rangeSize = hand_distribution_.size();
+  move_profile_.peakRangeSize = std::max(move_profile_.peakRangeSize, move_profile_.rangeSize);
+  move_profile_.memory = measureRangeMemory(hand_distribution_);
+#ifdef TORCHBOT
+  HiddenStateStats hidden;
+  if (getHiddenStateStats(params_.torch.TORCHBOT_HIDDEN_DTYPE, &hidden)) {
+    move_profile_.memory.hiddenStateBytes = hidden.live * hidden.stateBytes;
+  }
+#endif
+  game_profile_.total.add(move_profile_);
+  game_profile_.moves.push_back(move_profile_);
+  move_profile_ = SearchProfile();
+}
+
+SearchBot::~SearchBot() {
+  // the server does not tell bots that the game is over, but they are
+  // destroyed with it
+  if (!game_profile_.moves.empty()) {
+    // what I observed after my last move
+    game_profile_.total.add(move_profile_);
+    if (params_.search.SEARCH_LOG) {
+      const MemoryReport &peak = game_profile_.total.memory;
+      const double MB = 1024. * 1024.;
+      std::cerr << now() << "Player " << me_ << " peak memory: range " << peak.handDistEntries << " hands ("
+                << peak.handDistBytes / MB << " MB), partner bots " << peak.partnerBotBytes / MB
+                << " MB, delayed observations " << peak.delayedObsBytes / MB << " MB, interned hands "
+                << peak.internedHandBytes / MB << " MB, hidden states " << peak.hiddenStateBytes / MB
+                << " MB; peak RSS " << peak.peakRssBytes / MB << " MB." << std::endl;
+    }
+    recordSearchProfile(game_profile_, params_.search.SEARCH_PROFILE_JSON);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////    SearchProfile    /////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+std::string SearchProfile::toJson() const {
+  std::ostringstream out;
+  out << "{\"moves\": " << moves
+      << ", \"range_init_secs\": " << rangeInitSecs
+      << ", \"belief_secs\": " << beliefSecs
+      << ", \"draw_update_secs\": " << drawUpdateSecs
+      << ", \"hint_filter_secs\": " << hintFilterSecs
+      << ", \"action_filter_secs\": " << actionFilterSecs
+      << ", \"delayed_obs_secs\": " << delayedObsSecs
+      << ", \"search_secs\": " << searchSecs
+      << ", \"barrier_wait_secs\": " << barrierWaitSecs
+      << ", \"rollouts\": " << rollouts
+      << ", \"rollouts_pruned\": " << rolloutsPruned
+      << ", \"bot_clones\": " << botClones
+      << ", \"range_size\": " << rangeSize
+      << ", \"peak_range_size\": " << peakRangeSize
+      << ", \"memory\": " << memory.toJson() << "}";
+  return out.str();
+}
+
+std::string SearchGameProfile::toJson() const {
+  std::ostringstream out;
+  out << "{\"player\": " << player
+      << ", \"num_players\": " << numPlayers
+      << ", \"total\": " << total.toJson()
+      << ", \"moves\": [";
+  for (size_t i = 0; i < moves.size(); ++i) {
+    out << (i ? ", " : "") << moves[i].toJson();
+  }
+  out << "]}";
+  return out.str();
+}
+
+namespace {
+
+// the most recent games, for getSearchProfiles()
+constexpr size_t MAX_SEARCH_PROFILES = 10000;
+std::mutex search_profiles_mutex;
+std::deque<SearchGameProfile> search_profiles;
+
+}  // namespace
+
+void recordSearchProfile(const SearchGameProfile &profile, const std::string &jsonPath) {
+  std::lock_guard<std::mutex> lock(search_profiles_mutex);
+  search_profiles.push_back(profile);
+  if (search_profiles.size() > MAX_SEARCH_PROFILES) {
+    search_profiles.pop_front();
+  }
+  if (!jsonPath.empty()) {
+    std::ofstream out(jsonPath, std::ios::app);
+    out << profile.toJson() << std::endl;
+  }
+}
+
+std::vector<SearchGameProfile> getSearchProfiles(bool clear) {
+  std::lock_guard<std::mutex> lock(search_profiles_mutex);
+  std::vector<SearchGameProfile> profiles(search_profiles.begin(), search_profiles.end());
+  if (clear) {
+    search_profiles.clear();
+  }
+  return profiles;
+}
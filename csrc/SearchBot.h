@@ -9,6 +9,7 @@
 #include "Hanabi.h"
 #include "BotFactory.h"
 #include "BotUtils.h"
+#include "SearchProfile.h"
 
 #include <memory>
 #include <map>
@@ -16,47 +17,19 @@
 #include <fstream>
 
 
-namespace SearchBotParams {
-  // read in parameters from environment variables
-  const std::string BPBOT = Params::getParameterString("BPBOT", "SmartBot",
-    "The blueprint agent to use for search.");
-  const int SEARCH_PLAYER = Params::getParameterInt("SEARCH_PLAYER", -1,
-    "For single-agent search, which player performs search (negative numbers count from the end).");
-  const int SEARCH_ALL = Params::getParameterInt("SEARCH_ALL", 0,
-    "If 1, all agents perform search independently (unsound)");
-  // hack: not const because we twiddle it in extension.cc
-  extern float SEARCH_THRESH; // score threshold to override the blueprint
-  const int SEARCH_N = Params::getParameterInt("SEARCH_N", 10000,
-    "Number of MC rollouts to perform for search.");
-  const int DOUBLE_SEARCH = Params::getParameterInt("DOUBLE_SEARCH", 0,
-    "Perform a second (independent) search to use as an unbiased estimator of the true scores.");
-  const float PARTNER_UNIFORM_UNC = Params::getParameterFloat("PARTNER_UNIFORM_UNC", 0.,
-    "Add 'uniform' uncertainty to the belief update. Should be 0-1, with 1 corresponding to assuming a uniform policy.");
-  const float PARTNER_BOLTZMANN_UNC = Params::getParameterFloat("PARTNER_BOLTZMANN_UNC", 0.,
-    "Assume the TorchBot partner plays a Boltzmann distribution of actions proportional to exp(Q_a / T), where T is chosen so the 'best' action is played with probability 1-unc. (TorchBot only).");
-
-  const int OPTIMIZE_WINS = Params::getParameterInt("OPTIMIZE_WINS", 0,
-    "Have search ptimize for wins (25 points) rather than max score. This tends to produce worse scores *and* fewer wins, due to bad reward shaping.");
-  const int UCB = Params::getParameterInt("UCB", 1,
-    "Use UCB for search MC rollouts.");
-  const int SEARCH_BASELINE = Params::getParameterInt("SEARCH_BASELINE", 0,
-    "If 1, subtract blueprint action EV from EVs for other actions during MC rollouts; reduces the number of MC rollouts required.");
-  const int DELAYED_OBS_THRESH = Params::getParameterInt("DELAYED_OBS_THRESH", 100000,
-    "Only apply observations to belief bots if the range is below this size. For TorchBot, this trades off time vs space "
-    "(higher THRESH uses less memory at the cost of more compute).");
-} // namespace SearchBotParams
-
-
-void logSearchResults(const SearchStats &stats, int numPlayers, int me);
-
-void applyDelayedObservations(
+void logSearchResults(const SearchStats &stats, int numPlayers, int me, const SearchBotParams::Config &params);
+
+/* Returns the number of hands updated (0 if the range is too large). */
+int applyDelayedObservations(
   HandDist &handDist,
-  const std::vector<BoxedHand> &handDistKeys
+  const std::vector<BoxedHand> &handDistKeys,
+  const RunParams &params
 );
 
 struct SearchBot : public Hanabi::Bot {
   /* public API */
   SearchBot(int index, int numPlayers, int handSize);
+  ~SearchBot() override;
   void pleaseObserveBeforeMove(const Hanabi::Server &server) override;
   void pleaseMakeMove(Hanabi::Server &server) override;
     void pleaseObserveBeforeDiscard(const Hanabi::Server &server, int from, int card_index) override;
@@ -65,6 +38,9 @@ struct SearchBot : public Hanabi::Bot {
     void pleaseObserveValueHint(const Hanabi::Server &server, int from, int to, Hanabi::Value value, Hanabi::CardIndices card_indices) override;
   void pleaseObserveAfterMove(const Hanabi::Server &server) override;
 
+  /* my profile of the game so far (see SearchProfile.h) */
+  const SearchGameProfile &profile() const { return game_profile_; }
+
 protected:
   virtual void init_(const Hanabi::Server &server);
 
@@ -104,6 +80,12 @@ protected:
                  const Hanabi::Server &server, bool verbose=true,
                  SearchStats *win_stats=nullptr) const;
 
+  /* == profiling == */
+  /* Closes move_profile_ as the profile of the move I just made. */
+  void endMoveProfile_();
+
+  // copied from RunParams::current() at construction
+  RunParams params_;
   std::mt19937 gen_;
   SimulServer simulserver_;
   bool inited_ = false;
@@ -126,24 +108,36 @@ protected:
   double unbiased_win_difference_ = 0;
   mutable int total_iters_ = 0;
 
+  /* profile of what I did since my last move, and of the game */
+  mutable SearchProfile move_profile_;
+  SearchGameProfile game_profile_;
+
   std::ofstream dumpFile_;
   int numFrames_ = 0;
 };
 
+/* Whether the SearchBot factory below plays seat index as a SearchBot: the
+ * SEARCH_PLAYER seat (the last one by default), or every seat with
+ * SEARCH_ALL. It plays the other seats as BPBOT. */
+inline bool isSearchSeat(int index, int numPlayers, const SearchBotParams::Config &params) {
+  int searchPlayer = params.SEARCH_PLAYER;
+  if (searchPlayer < 0) {
+    searchPlayer += numPlayers;
+  }
+  return index == searchPlayer || params.SEARCH_ALL;
+}
+
 /* override the bot factory for SearchBot to create a SearchBot only for the last
  * player and SmartBots for everyone else */
 template<>
 struct BotFactory<SearchBot> final : public Hanabi::BotFactory
 {
     Hanabi::Bot *create(int index, int numPlayers, int handSize) const override {
-      int searchPlayer = SearchBotParams::SEARCH_PLAYER;
-      if (searchPlayer < 0) {
-        searchPlayer += numPlayers;
-      }
-      if (index == searchPlayer || SearchBotParams::SEARCH_ALL) {
+      const SearchBotParams::Config &params = RunParams::current().search;
+      if (isSearchSeat(index, numPlayers, params)) {
         return new SearchBot(index, numPlayers, handSize);
       } else {
-        auto bpFactory = Hanabi::getBotFactory(SearchBotParams::BPBOT);
+        auto bpFactory = Hanabi::getBotFactory(params.BPBOT);
         Hanabi::Bot *bot = bpFactory->create(index, numPlayers, handSize);
         bot->setPermissive(true);
         return bot;
@@ -0,0 +1,85 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "MemoryStats.h"
+
+/* Where a SearchBot spends its time, over one of its moves (everything it
+ * did since its previous move) or over a whole game. Times are wall-clock
+ * seconds, except barrierWaitSecs, which is summed over search fibers. */
+struct SearchProfile {
+  long moves = 0;
+  double rangeInitSecs = 0;     // generating the initial range
+  double beliefSecs = 0;        // observations applied to every bot in the range
+  double drawUpdateSecs = 0;    // range updates for drawn cards
+  double hintFilterSecs = 0;
+  double actionFilterSecs = 0;
+  double delayedObsSecs = 0;    // delayed observations applied to the range
+  double searchSecs = 0;
+  double barrierWaitSecs = 0;   // search fibers waiting for UCB pruning
+  long rollouts = 0;
+  long rolloutsPruned = 0;      // rollouts skipped because their move was pruned
+  long botClones = 0;           // bots cloned for rollouts and belief updates
+  long rangeSize = 0;           // at the (last) move
+  long peakRangeSize = 0;
+  MemoryReport memory;          // at the (last) move; over a game, the peak of each field
+
+  void add(const SearchProfile &other) {
+    moves += other.moves;
+    rangeInitSecs += other.rangeInitSecs;
+    beliefSecs += other.beliefSecs;
+    drawUpdateSecs += other.drawUpdateSecs;
+    hintFilterSecs += other.hintFilterSecs;
+    actionFilterSecs += other.actionFilterSecs;
+    delayedObsSecs += other.delayedObsSecs;
+    searchSecs += other.searchSecs;
+    barrierWaitSecs += other.barrierWaitSecs;
+    rollouts += other.rollouts;
+    rolloutsPruned += other.rolloutsPruned;
+    botClones += other.botClones;
+    if (other.moves > 0) rangeSize = other.rangeSize;
+    peakRangeSize = std::max(peakRangeSize, other.peakRangeSize);
+    memory.takePeak(other.memory);
+  }
+
+  std::string toJson() const;
+};
+
+/* A SearchBot's profile of one game: its total, and each of its moves. */
+struct SearchGameProfile {
+  int player = 0;
+  int numPlayers = 0;
+  SearchProfile total;
+  std::vector<SearchProfile> moves;
+
+  std::string toJson() const;
+};
+
+/* Adds to *secs the time from its construction to its destruction. */
+class ScopedTimer {
+public:
+  explicit ScopedTimer(double *secs) : secs_(secs), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    *secs_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  }
+private:
+  double *secs_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/* Every SearchBot that made a move records its profile of the game when it
+ * is destroyed, i.e. at the end of the game. The most recent games are kept
+ * (up to a fixed number) for getSearchProfiles(), and if jsonPath is not
+ * empty, the profile is appended to it as one line of JSON. Defined in
+ * SearchBot.cc. */
+void recordSearchProfile(const SearchGameProfile &profile, const std::string &jsonPath);
+/* The profiles recorded so far, oldest first; clear=true forgets them. */
+std::vector<SearchGameProfile> getSearchProfiles(bool clear=false);
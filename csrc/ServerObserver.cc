@@ -0,0 +1,465 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include "ServerObserver.h"
+
+namespace Hanabi {
+
+namespace {
+
+std::string nth(int n, int total)
+{
+    if (total == 5) {
+        switch (n) {
+            case 0: return "O";
+            case 1: return "SO";
+            case 2: return "M";
+            case 3: return "SN";
+            default: assert(n == 4); return "N";
+        }
+    } else if (total == 4) {
+        switch (n) {
+            case 0: return "O";
+            case 1: return "SO";
+            case 2: return "SN";
+            default: assert(n == 3); return "N";
+        }
+    } else {
+        switch (n) {
+            case 0: return "O";
+            case 1: return "M";
+            default: assert(n == 2); return "N";
+        }
+    }
+}
+
+std::string nth(const CardIndices& ns, int total)
+{
+    assert(!ns.empty());
+    switch (ns.size()) {
+        case 1: return nth(ns[0], total);
+        case 2: return nth(ns[0], total) + ", " + nth(ns[1], total);
+        case 3: return nth(ns[0], total) + ", " + nth(ns[1], total) + ", " + nth(ns[2], total);
+        default:
+            assert(ns.size() == 4);
+            return nth(ns[0], total) + ", " + nth(ns[1], total) + ", " + nth(ns[2], total) + ", " + nth(ns[3], total);
+    }
+}
+
+/* the letter of the color, as in Card::toString() */
+std::string colorname(Color color)
+{
+    return std::string(1, Card(color, 1).toString()[1]);
+}
+
+uint8_t indexMask(const CardIndices &card_indices)
+{
+    uint8_t mask = 0;
+    for (int i = 0; i < card_indices.size(); ++i) {
+        mask |= 1 << card_indices[i];
+    }
+    return mask;
+}
+
+}  // namespace
+
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////   TextTranscriptObserver   //////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+void TextTranscriptObserver::onDeal(const Server &server)
+{
+    *gameStart_ << "Start game" << std::endl;
+}
+
+void TextTranscriptObserver::onRunStart(const Server &server)
+{
+    prevHands_.clear();
+    *out_ << server.cardsRemainingInDeck() << " cards remaining" << std::endl;
+}
+
+void TextTranscriptObserver::onTurnStart(const Server &server)
+{
+    if (server.activePlayer() == 0 && prevHands_ != server.handsAsStringWithoutPlayer0()) {
+        hands_(server, 1);
+        prevHands_ = server.handsAsStringWithoutPlayer0();
+    }
+}
+
+void TextTranscriptObserver::onPlay(const Server &server, int from, int card_index, Card card, bool success)
+{
+    const int handSize = server.sizeOfHandOfPlayer(from);
+    if (from == 0) {
+        *out_ << "You played your " << nth(card_index, handSize);
+    } else {
+        *out_ << "P" << from << " played his " << nth(card_index, handSize);
+    }
+    *out_ << " card (" << card.toString() << ")" << (success ? ". " : " but failed. ");
+    played_ = true;
+    drew_ = false;
+}
+
+void TextTranscriptObserver::onDiscard(const Server &server, int from, int card_index, Card card)
+{
+    const int handSize = server.sizeOfHandOfPlayer(from);
+    if (from == 0) {
+        *out_ << "You discarded your " << nth(card_index, handSize);
+    } else {
+        *out_ << "P" << from << " discarded his " << nth(card_index, handSize);
+    }
+    *out_ << " card (" << card.toString() << "). ";
+}
+
+void TextTranscriptObserver::onDraw(const Server &server, int player, Card card)
+{
+    if (player == 0) {
+        *out_ << "You drew a card\n";
+    } else {
+        *out_ << "P" << player << " drew card " << card.toString() << "\n";
+    }
+    drew_ = true;
+}
+
+void TextTranscriptObserver::hint_(const Server &server, int from, int to, const CardIndices &card_indices)
+{
+    if (from == 0) {
+        *out_ << "You told P" << to;
+    } else if (to == 0) {
+        *out_ << "P" << from << " told You";
+    } else {
+        *out_ << "P" << from << " told P" << to;
+    }
+    const int handSize = server.sizeOfHandOfPlayer(to);
+    if (card_indices.empty()) {
+        *out_ << " no";
+    } else if (to == 0) {
+        *out_ << (card_indices.size() == handSize ? " all your" : (" your " + nth(card_indices, handSize)));
+    } else {
+        *out_ << (card_indices.size() == handSize ? " all his" : (" his " + nth(card_indices, handSize)));
+    }
+}
+
+void TextTranscriptObserver::onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices)
+{
+    hint_(server, from, to, card_indices);
+    *out_ << (card_indices.size() == 1 ? " card is " : " cards are ") << colorname(color) << "\n";
+}
+
+void TextTranscriptObserver::onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices)
+{
+    hint_(server, from, to, card_indices);
+    *out_ << (card_indices.size() == 1 ? " card is a " : " cards are a ") << static_cast<int>(value) << "\n";
+}
+
+void TextTranscriptObserver::onMoveEnd(const Server &server, int from)
+{
+    if (played_) {
+        if (!drew_) *out_ << "\n";
+        piles_(server);
+        played_ = false;
+    }
+}
+
+void TextTranscriptObserver::onFinalRound(const Server &server)
+{
+    *out_ << "0 Cards Remaining\n";
+}
+
+void TextTranscriptObserver::onQuestion(const Server &server, const QuestionEvent &q)
+{
+    const int handSize = server.sizeOfHandOfPlayer(server.activePlayer());
+    switch (q.qa) {
+        case 1:
+            hands_(server, 0);
+            piles_(server);
+            *out_ << "discards: " << server.discardsAsString() << "\n";
+            *out_ << "cards_remaining: " << server.cardsRemainingInDeck() << "\n";
+            break;
+        case 2:
+            *out_ << "Is the " << nth(q.cardPosition, handSize) << " card of P1 ";
+            if (q.isColor) {
+                *out_ << colorname(q.color) << "?\n";
+            } else {
+                *out_ << "a " << q.value << "?\n";
+            }
+            *out_ << "answer: " << (q.answer ? "Yes" : "No") << "\n";
+            *out_ << "cards_remaining: " << q.questionRound << "\n";
+            *out_ << "question_position: " << nth(q.cardPosition, handSize) << "\n";
+            if (q.isColor) {
+                *out_ << "question_value: " << colorname(q.color) << "\n";
+            } else {
+                *out_ << "question_value: " << q.value << "\n";
+            }
+            break;
+        case 3:
+            *out_ << "What is the current score of the " << colorname(q.color) << " pile?" << "\n";
+            *out_ << "answer: " << q.answer << "\n";
+            *out_ << "cards_remaining: " << q.questionRound << "\n";
+            *out_ << "question_pile: " << colorname(q.color) << "\n";
+            break;
+        case 4:
+            *out_ << "How many " << q.value << colorname(q.color) << " cards have been discarded?" << "\n";
+            *out_ << "answer: " << q.answer << "\n";
+            *out_ << "cards_remaining: " << q.questionRound << "\n";
+            break;
+        case 5:
+            *out_ << "How many cards are currently remaining in the deck?" << "\n";
+            *out_ << "answer: " << q.answer << "\n";
+            break;
+    }
+}
+
+void TextTranscriptObserver::hands_(const Server &server, int firstPlayer)
+{
+    *out_ << "Hands:";
+    for (int i = firstPlayer; i < server.numPlayers(); ++i) {
+        *out_ << " P" << i << " cards are";
+        const std::vector<Card> hand = server.cheatGetHand(i);
+        for (int j = 0; j < (int)hand.size(); ++j) {
+            *out_ << (j ? "," : " ") << hand[j].toString();
+        }
+        *out_ << ";";
+    }
+    *out_ << "\n";
+}
+
+void TextTranscriptObserver::piles_(const Server &server)
+{
+    *out_ << "Piles:";
+    for (Color k = RED; k <= BLUE; ++k) {
+        *out_ << " " << server.pileOf(k).size() << colorname(k);
+    }
+    *out_ << "\n";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////   BinaryTraceObserver   /////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+void BinaryTraceObserver::write_(const Server &server, uint8_t type, int player, int target, int slot, int color, int value)
+{
+    BinaryTraceRecord record;
+    record.type = type;
+    record.player = player;
+    record.target = target;
+    record.slot = slot;
+    record.color = color;
+    record.value = value;
+    record.turn = server.turn();
+    record.deck = server.cardsRemainingInDeck();
+    out_->write(reinterpret_cast<const char *>(&record), sizeof record);
+}
+
+void BinaryTraceObserver::onDeal(const Server &server)
+{
+    for (int p = 0; p < server.numPlayers(); ++p) {
+        const std::vector<Card> hand = server.cheatGetHand(p);
+        for (int i = 0; i < (int)hand.size(); ++i) {
+            write_(server, BinaryTraceRecord::DEAL, p, 0, i, hand[i].color, hand[i].value);
+        }
+    }
+}
+
+void BinaryTraceObserver::onPlay(const Server &server, int from, int card_index, Card card, bool success)
+{
+    write_(server, success ? BinaryTraceRecord::PLAY : BinaryTraceRecord::PLAY_FAILED, from, 0, card_index, card.color, card.value);
+}
+
+void BinaryTraceObserver::onDiscard(const Server &server, int from, int card_index, Card card)
+{
+    write_(server, BinaryTraceRecord::DISCARD, from, 0, card_index, card.color, card.value);
+}
+
+void BinaryTraceObserver::onDraw(const Server &server, int player, Card card)
+{
+    write_(server, BinaryTraceRecord::DRAW, player, 0, server.sizeOfHandOfPlayer(player) - 1, card.color, card.value);
+}
+
+void BinaryTraceObserver::onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices)
+{
+    write_(server, BinaryTraceRecord::COLOR_HINT, from, to, indexMask(card_indices), color, 0);
+}
+
+void BinaryTraceObserver::onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices)
+{
+    write_(server, BinaryTraceRecord::VALUE_HINT, from, to, indexMask(card_indices), 0, value);
+}
+
+void BinaryTraceObserver::onFinalRound(const Server &server)
+{
+    write_(server, BinaryTraceRecord::FINAL_ROUND, server.activePlayer(), 0, 0, 0, 0);
+}
+
+void BinaryTraceObserver::onQuestion(const Server &server, const QuestionEvent &q)
+{
+    const int kind = q.qa | (q.isColor ? BinaryTraceRecord::QUESTION_IS_COLOR : 0);
+    write_(server, BinaryTraceRecord::QUESTION, server.activePlayer(), kind, q.cardPosition < 0 ? 0 : q.cardPosition,
+           q.color | q.value << 4, q.answer);
+}
+
+void BinaryTraceObserver::onGameEnd(const Server &server, int score)
+{
+    write_(server, BinaryTraceRecord::GAME_END, server.activePlayer(), 0, 0, 0, score);
+    out_->flush();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////   TokenObserver   ///////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+int TokenObserver::card_(int player, Card card) const
+{
+    if (player == seat_) return CARD_HIDDEN;
+    return CARD + 5 * card.color + card.value - 1;
+}
+
+void TokenObserver::onDeal(const Server &server)
+{
+    for (int p = 0; p < server.numPlayers(); ++p) {
+        for (Card card : server.cheatGetHand(p)) {
+            tokens_.insert(tokens_.end(), {DEAL, PLAYER + p, card_(p, card)});
+        }
+    }
+}
+
+void TokenObserver::onPlay(const Server &server, int from, int card_index, Card card, bool success)
+{
+    tokens_.insert(tokens_.end(), {success ? PLAY : PLAY_FAILED, PLAYER + from, SLOT + card_index,
+                                   CARD + 5 * card.color + card.value - 1});
+}
+
+void TokenObserver::onDiscard(const Server &server, int from, int card_index, Card card)
+{
+    tokens_.insert(tokens_.end(), {DISCARD, PLAYER + from, SLOT + card_index, CARD + 5 * card.color + card.value - 1});
+}
+
+void TokenObserver::onDraw(const Server &server, int player, Card card)
+{
+    tokens_.insert(tokens_.end(), {DRAW, PLAYER + player, card_(player, card)});
+}
+
+void TokenObserver::hint_(int from, int to, const CardIndices &card_indices)
+{
+    tokens_.push_back(PLAYER + from);
+    tokens_.push_back(PLAYER + to);
+    for (int i = 0; i < card_indices.size(); ++i) {
+        tokens_.push_back(SLOT + card_indices[i]);
+    }
+}
+
+void TokenObserver::onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices)
+{
+    tokens_.push_back(COLOR_HINT);
+    hint_(from, to, card_indices);
+    tokens_.push_back(COLOR + color);
+}
+
+void TokenObserver::onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices)
+{
+    tokens_.push_back(VALUE_HINT);
+    hint_(from, to, card_indices);
+    tokens_.push_back(VALUE + value);
+}
+
+void TokenObserver::onFinalRound(const Server &server)
+{
+    tokens_.push_back(FINAL_ROUND);
+}
+
+void TokenObserver::onGameEnd(const Server &server, int score)
+{
+    tokens_.insert(tokens_.end(), {GAME_END, SCORE + score});
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////   StatsObserver   ///////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+StatsObserver::SeatStats &StatsObserver::seat_(int player)
+{
+    if (player >= (int)seats_.size()) seats_.resize(player + 1);
+    return seats_[player];
+}
+
+void StatsObserver::onPlay(const Server &server, int from, int card_index, Card card, bool success)
+{
+    seat_(from).plays += 1;
+    if (!success) seat_(from).failedPlays += 1;
+}
+
+void StatsObserver::onDiscard(const Server &server, int from, int card_index, Card card)
+{
+    seat_(from).discards += 1;
+}
+
+void StatsObserver::onDraw(const Server &server, int player, Card card)
+{
+    seat_(player).draws += 1;
+}
+
+void StatsObserver::onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices)
+{
+    seat_(from).colorHints += 1;
+}
+
+void StatsObserver::onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices)
+{
+    seat_(from).valueHints += 1;
+}
+
+void StatsObserver::onGameEnd(const Server &server, int score)
+{
+    games_ += 1;
+    totalScore_ += score;
+    scores_[score] += 1;
+}
+
+std::string StatsObserver::summary() const
+{
+    SeatStats total;
+    for (const SeatStats &s : seats_) {
+        total.plays += s.plays;
+        total.failedPlays += s.failedPlays;
+        total.discards += s.discards;
+        total.colorHints += s.colorHints;
+        total.valueHints += s.valueHints;
+    }
+    const double games = std::max<long>(games_, 1);
+    std::ostringstream out;
+    out << "  Moves per game: " << total.plays / games << " plays (" << total.failedPlays / games
+        << " failed), " << total.discards / games << " discards, " << total.colorHints / games
+        << " color hints, " << total.valueHints / games << " value hints.\n";
+    return out.str();
+}
+
+std::string StatsObserver::toJson() const
+{
+    std::ostringstream out;
+    out << "{\"games\": " << games_ << ", \"total_score\": " << totalScore_ << ", \"seats\": [";
+    for (size_t i = 0; i < seats_.size(); ++i) {
+        const SeatStats &s = seats_[i];
+        out << (i ? ", " : "") << "{\"plays\": " << s.plays << ", \"failed_plays\": " << s.failedPlays
+            << ", \"discards\": " << s.discards << ", \"color_hints\": " << s.colorHints
+            << ", \"value_hints\": " << s.valueHints << ", \"draws\": " << s.draws << "}";
+    }
+    out << "], \"scores\": {";
+    bool first = true;
+    for (const auto &kv : scores_) {
+        out << (first ? "" : ", ") << "\"" << kv.first << "\": " << kv.second;
+        first = false;
+    }
+    out << "}}";
+    return out.str();
+}
+
+}  /* namespace Hanabi */
@@ -0,0 +1,227 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "Hanabi.h"
+
+namespace Hanabi {
+
+/* An in-game question (see Server::sqa()), asked in place of player 0's
+ * move once questionRound or fewer cards remain; the game ends there, and
+ * onGameEnd() follows with the score so far. */
+struct QuestionEvent {
+    int qa = 0;                  // the kind of question, 1 to 5 as for sqa()
+    int questionRound = 0;
+    /* qa 2: is player 1's card at cardPosition of color (isColor) or value */
+    int cardPosition = -1;
+    bool isColor = false;
+    /* qa 2: the question; qa 3: the pile; qa 4: the card */
+    Color color = RED;
+    int value = 0;
+    /* qa 2: 1 for yes and 0 for no; qa 3: the pile's score; qa 4: how many
+     * copies were discarded; qa 5: the cards remaining in the deck */
+    int answer = 0;
+};
+
+/* Receives what happens in the games of a Server (see Server::addObserver),
+ * as typed events, so that transcripts, traces and statistics are produced
+ * by pluggable sinks rather than by the game loop. Every event comes with
+ * the server as it stands; card indices refer to the hands before the
+ * move. A Server with no observers does no formatting at all. */
+class ServerObserver {
+public:
+    virtual ~ServerObserver() = default;
+
+    /* startGame() dealt the hands (see Server::cheatGetHand()). */
+    virtual void onDeal(const Server &server) {}
+    /* runToCompletion() or runToTurn() starts playing the game; once per
+     * game, not on every call. */
+    virtual void onRunStart(const Server &server) {}
+    /* A turn starts, before the players observe it. */
+    virtual void onTurnStart(const Server &server) {}
+    /* Before the card leaves the hand of from. */
+    virtual void onPlay(const Server &server, int from, int card_index, Card card, bool success) {}
+    virtual void onDiscard(const Server &server, int from, int card_index, Card card) {}
+    /* After card was added to the end of the hand of player. */
+    virtual void onDraw(const Server &server, int player, Card card) {}
+    virtual void onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices) {}
+    virtual void onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices) {}
+    /* After a play, discard or hint of from, and any draw, are done. */
+    virtual void onMoveEnd(const Server &server, int from) {}
+    /* The last card was drawn: every player has one more turn. */
+    virtual void onFinalRound(const Server &server) {}
+    virtual void onQuestion(const Server &server, const QuestionEvent &question) {}
+    /* Once per game, when it is over or its question was asked. */
+    virtual void onGameEnd(const Server &server, int score) {}
+};
+
+/* The text transcript that Server::setLog() writes: seat 0 is "You", and
+ * the hands of the other seats are shown whenever they change. Each game
+ * starts with a "Start game" line on gameStart. */
+class TextTranscriptObserver : public ServerObserver {
+public:
+    explicit TextTranscriptObserver(std::ostream *out, std::ostream *gameStart=&std::cerr) :
+        out_(out), gameStart_(gameStart) {}
+    std::ostream *stream() const { return out_; }
+
+    void onDeal(const Server &server) override;
+    void onRunStart(const Server &server) override;
+    void onTurnStart(const Server &server) override;
+    void onPlay(const Server &server, int from, int card_index, Card card, bool success) override;
+    void onDiscard(const Server &server, int from, int card_index, Card card) override;
+    void onDraw(const Server &server, int player, Card card) override;
+    void onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices) override;
+    void onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices) override;
+    void onMoveEnd(const Server &server, int from) override;
+    void onFinalRound(const Server &server) override;
+    void onQuestion(const Server &server, const QuestionEvent &question) override;
+
+private:
+    void hint_(const Server &server, int from, int to, const CardIndices &card_indices);
+    void hands_(const Server &server, int firstPlayer);
+    void piles_(const Server &server);
+
+    std::ostream *out_;
+    std::ostream *gameStart_;
+    std::string prevHands_;
+    bool played_ = false;
+    bool drew_ = false;
+};
+
+/* Writes every event as a fixed-size BinaryTraceRecord, in host byte
+ * order: a game is its DEAL records (one per card dealt, in seat and slot
+ * order), then the records of its moves, then GAME_END.
+ *
+ * A QUESTION record holds the whole QuestionEvent: target is the qa kind,
+ * or'ed with QUESTION_IS_COLOR for a qa 2 color question; slot is the
+ * card position of qa 2; color is the question's color | its value << 4
+ * (see questionColor() and questionValue()); value is the answer. */
+struct BinaryTraceRecord {
+    enum Type : uint8_t { DEAL, DRAW, PLAY, PLAY_FAILED, DISCARD, COLOR_HINT, VALUE_HINT, FINAL_ROUND, QUESTION, GAME_END };
+    static constexpr uint8_t QUESTION_IS_COLOR = 0x80;
+    uint8_t type;
+    uint8_t player;   // who dealt/drew/moved; hints: the giver
+    uint8_t target;   // hints: the receiver; QUESTION: the qa kind and QUESTION_IS_COLOR
+    uint8_t slot;     // DEAL, PLAY, DISCARD: the card index; hints: a bitmask of the indices
+    uint8_t color;    // of the card, or of the hint; QUESTION: color | value << 4
+    uint8_t value;    // of the card, or of the hint; GAME_END: the score; QUESTION: the answer
+    uint8_t turn;
+    uint8_t deck;     // cards remaining in the deck
+
+    /* the fields of a QUESTION record */
+    int questionKind() const { return target & ~QUESTION_IS_COLOR; }
+    bool questionIsColor() const { return target & QUESTION_IS_COLOR; }
+    int questionColor() const { return color & 0xf; }
+    int questionValue() const { return color >> 4; }
+};
+static_assert(sizeof(BinaryTraceRecord) == 8, "trace records are 8 bytes");
+
+class BinaryTraceObserver : public ServerObserver {
+public:
+    explicit BinaryTraceObserver(std::ostream *out) : out_(out) {}
+
+    void onDeal(const Server &server) override;
+    void onPlay(const Server &server, int from, int card_index, Card card, bool success) override;
+    void onDiscard(const Server &server, int from, int card_index, Card card) override;
+    void onDraw(const Server &server, int player, Card card) override;
+    void onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices) override;
+    void onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices) override;
+    void onFinalRound(const Server &server) override;
+    void onQuestion(const Server &server, const QuestionEvent &question) override;
+    void onGameEnd(const Server &server, int score) override;
+
+private:
+    void write_(const Server &server, uint8_t type, int player, int target, int slot, int color, int value);
+
+    std::ostream *out_;
+};
+
+/* Encodes a game as a sequence of integer tokens, e.g. for sequence models:
+ * each event is an event token followed by its arguments, drawn from
+ * disjoint ranges (see the constants below). With seat >= 0, the cards of
+ * that seat are encoded as CARD_HIDDEN until they are played or discarded,
+ * i.e. the game as that seat saw it. */
+class TokenObserver : public ServerObserver {
+public:
+    enum Token {
+        /* events */
+        DEAL, DRAW, PLAY, PLAY_FAILED, DISCARD, COLOR_HINT, VALUE_HINT, FINAL_ROUND, GAME_END,
+        PLAYER = 16,       // + seat
+        SLOT = 24,         // + card index
+        CARD = 32,         // + 5 * color + value - 1
+        CARD_HIDDEN = CARD + 25,
+        COLOR = 64,        // + color, for hints
+        VALUE = 72,        // + value, for hints
+        SCORE = 80,        // + final score
+        VOCAB_SIZE = SCORE + 26,
+    };
+
+    explicit TokenObserver(int seat=-1) : seat_(seat) {}
+    const std::vector<int> &tokens() const { return tokens_; }
+    void clear() { tokens_.clear(); }
+
+    void onDeal(const Server &server) override;
+    void onPlay(const Server &server, int from, int card_index, Card card, bool success) override;
+    void onDiscard(const Server &server, int from, int card_index, Card card) override;
+    void onDraw(const Server &server, int player, Card card) override;
+    void onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices) override;
+    void onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices) override;
+    void onFinalRound(const Server &server) override;
+    void onGameEnd(const Server &server, int score) override;
+
+private:
+    int card_(int player, Card card) const;
+    void hint_(int from, int to, const CardIndices &card_indices);
+
+    int seat_;
+    std::vector<int> tokens_;
+};
+
+/* Counts moves by kind and seat, and final scores, over any number of
+ * games. */
+class StatsObserver : public ServerObserver {
+public:
+    struct SeatStats {
+        long plays = 0;
+        long failedPlays = 0;
+        long discards = 0;
+        long colorHints = 0;
+        long valueHints = 0;
+        long draws = 0;
+    };
+
+    const std::vector<SeatStats> &seats() const { return seats_; }
+    long games() const { return games_; }
+    long totalScore() const { return totalScore_; }
+    const std::map<int, long> &scores() const { return scores_; }
+
+    /* Moves per game by kind, over all seats, e.g. for eval_bot. */
+    std::string summary() const;
+    std::string toJson() const;
+
+    void onPlay(const Server &server, int from, int card_index, Card card, bool success) override;
+    void onDiscard(const Server &server, int from, int card_index, Card card) override;
+    void onDraw(const Server &server, int player, Card card) override;
+    void onColorHint(const Server &server, int from, int to, Color color, const CardIndices &card_indices) override;
+    void onValueHint(const Server &server, int from, int to, Value value, const CardIndices &card_indices) override;
+    void onGameEnd(const Server &server, int score) override;
+
+private:
+    SeatStats &seat_(int player);
+
+    std::vector<SeatStats> seats_;
+    long games_ = 0;
+    long totalScore_ = 0;
+    std::map<int, long> scores_;
+};
+
+}  /* namespace Hanabi */
@@ -15,6 +15,7 @@
 #include "Hanabi.h"
 #include "SmartBot.h"
 #include "BotFactory.h"
+#include "BotState.h"
 
 using namespace Hanabi;
 using namespace SmartBotInternal;
@@ -38,13 +39,12 @@ static int vector_count(const std::vector<T> &vec, T value)
     return result;
 }
 
-CardKnowledge::CardKnowledge(const SmartBot *bot)
+CardKnowledge::CardKnowledge()
 {
-    bot_ = bot;
     possibilities_ = -1;
     color_ = -2;
     value_ = -2;
-    std::memset(cantBe_, '\0', sizeof cantBe_);
+    possible_ = CardMask::all();
     playable_ = valuable_ = worthless_ = MAYBE;
     probabilityPlayable_ = probabilityValuable_ = probabilityWorthless_ = -1.0;
 }
@@ -56,7 +56,7 @@ std::string CardKnowledge::toString() const
     for (int v = 1; v <= 5; ++v) {
         result << v;
         for (int k = RED; k <= BLUE; ++k) {
-            result << (cantBe_[k][v] ? '.' : 'K');
+            result << (cantBe(k, v) ? '.' : 'K');
         }
         result << '\n';
     }
@@ -69,23 +69,17 @@ std::string CardKnowledge::toString() const
 
 bool CardKnowledge::mustBe(Hanabi::Color color) const { computeIdentity(); return (this->color_ == color); }
 bool CardKnowledge::mustBe(Hanabi::Value value) const { computeIdentity(); return (this->value_ == value); }
-bool CardKnowledge::cannotBe(Hanabi::Card card) const { return cantBe_[card.color][card.value]; }
+bool CardKnowledge::cannotBe(Hanabi::Card card) const { return cantBe(card.color, card.value); }
 bool CardKnowledge::cannotBe(Hanabi::Color color) const
 {
     if (this->color_ >= 0) return (this->color_ != color);
-    for (int v = 1; v <= 5; ++v) {
-        if (!cantBe_[color][v]) return false;
-    }
-    return true;
+    return !possible_.containsColor(color);
 }
 
 bool CardKnowledge::cannotBe(Hanabi::Value value) const
 {
     if (this->value_ >= 0) return (this->value_ != value);
-    for (Color k = RED; k <= BLUE; ++k) {
-        if (!cantBe_[k][value]) return false;
-    }
-    return true;
+    return !possible_.containsValue(value);
 }
 
 void CardKnowledge::befuddleByDiscard()
@@ -110,133 +104,67 @@ void CardKnowledge::befuddleByPlay(bool success)
     if (worthless_ != YES) { worthless_ = MAYBE; probabilityWorthless_ = -1.0f; }
 }
 
-void CardKnowledge::setMustBe(Hanabi::Color color)
+void CardKnowledge::restrictTo(CardMask mask)
 {
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            if (k != color) cantBe_[k][v] = true;
-        }
-    }
+    possible_ &= mask;
     possibilities_ = -1;
-    color_ = color;
+    if (color_ == -1) color_ = -2;
     if (value_ == -1) value_ = -2;
     if (playable_ == MAYBE) probabilityPlayable_ = -1.0;
     if (valuable_ == MAYBE) probabilityValuable_ = -1.0;
     if (worthless_ == MAYBE) probabilityWorthless_ = -1.0;
 }
 
+void CardKnowledge::setMustBe(Hanabi::Color color)
+{
+    restrictTo(CardMask::ofColor(color));
+    color_ = color;
+}
+
 void CardKnowledge::setMustBe(Hanabi::Value value)
 {
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            if (v != value) cantBe_[k][v] = true;
-        }
-    }
-    possibilities_ = -1;
-    if (color_ == -1) color_ = -2;
+    restrictTo(CardMask::ofValue(value));
     value_ = value;
-    if (playable_ == MAYBE) probabilityPlayable_ = -1.0;
-    if (valuable_ == MAYBE) probabilityValuable_ = -1.0;
-    if (worthless_ == MAYBE) probabilityWorthless_ = -1.0;
 }
 
 void CardKnowledge::setMustBe(Hanabi::Card card)
 {
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            cantBe_[k][v] = !(k == card.color && v == card.value);
-        }
-    }
+    possible_ = CardMask::all();
+    restrictTo(CardMask::of(card));
     possibilities_ = 1;
     color_ = card.color;
     value_ = card.value;
-    if (playable_ == MAYBE) probabilityPlayable_ = -1.0;
-    if (valuable_ == MAYBE) probabilityValuable_ = -1.0;
-    if (worthless_ == MAYBE) probabilityWorthless_ = -1.0;
 }
 
 void CardKnowledge::setCannotBe(Hanabi::Color color)
 {
-    for (int v = 1; v <= 5; ++v) {
-        cantBe_[color][v] = true;
-    }
-    possibilities_ = -1;
-    if (color_ == -1) color_ = -2;
-    if (value_ == -1) value_ = -2;
-    if (playable_ == MAYBE) probabilityPlayable_ = -1.0;
-    if (valuable_ == MAYBE) probabilityValuable_ = -1.0;
-    if (worthless_ == MAYBE) probabilityWorthless_ = -1.0;
+    restrictTo(~CardMask::ofColor(color));
 }
 
 void CardKnowledge::setCannotBe(Hanabi::Value value)
 {
-    for (Color k = RED; k <= BLUE; ++k) {
-        cantBe_[k][value] = true;
-    }
-    possibilities_ = -1;
-    if (color_ == -1) color_ = -2;
-    if (value_ == -1) value_ = -2;
-    if (playable_ == MAYBE) probabilityPlayable_ = -1.0;
-    if (valuable_ == MAYBE) probabilityValuable_ = -1.0;
-    if (worthless_ == MAYBE) probabilityWorthless_ = -1.0;
+    restrictTo(~CardMask::ofValue(value));
 }
 
-void CardKnowledge::setIsPlayable(bool knownPlayable)
+void CardKnowledge::setIsPlayable(const SmartBot *bot, bool knownPlayable)
 {
-    for (Color k = RED; k <= BLUE; ++k) {
-        int playableValue = bot_->server_->pileOf(k).size() + 1;
-        for (int v = 1; v <= 5; ++v) {
-            if (this->cantBe_[k][v]) continue;
-            if ((v == playableValue) != knownPlayable) {
-                this->cantBe_[k][v] = true;
-            }
-        }
-    }
-    possibilities_ = -1;
-    if (color_ == -1) color_ = -2;
-    if (value_ == -1) value_ = -2;
+    restrictTo(knownPlayable ? bot->board_.playable : ~bot->board_.playable);
     playable_ = (knownPlayable ? YES : NO);
     probabilityPlayable_ = (knownPlayable ? 1.0 : 0.0);
-    if (valuable_ == MAYBE) probabilityValuable_ = -1.0;
-    if (worthless_ == MAYBE) probabilityWorthless_ = -1.0;
     if (knownPlayable) { worthless_ = NO; probabilityWorthless_ = 0.0; }
 }
 
-void CardKnowledge::setIsValuable(bool knownValuable)
+void CardKnowledge::setIsValuable(const SmartBot *bot, bool knownValuable)
 {
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            if (this->cantBe_[k][v]) continue;
-            if (bot_->isValuable(Card(k,v)) != knownValuable) {
-                this->cantBe_[k][v] = true;
-            }
-        }
-    }
-    possibilities_ = -1;
-    if (color_ == -1) color_ = -2;
-    if (value_ == -1) value_ = -2;
-    if (playable_ == MAYBE) probabilityPlayable_ = -1.0;
+    restrictTo(knownValuable ? bot->board_.valuable : ~bot->board_.valuable);
     valuable_ = (knownValuable ? YES : NO);
     probabilityValuable_ = (knownValuable ? 1.0 : 0.0);
-    if (worthless_ == MAYBE) probabilityWorthless_ = -1.0;
     if (knownValuable) { worthless_ = NO; probabilityWorthless_ = 0.0; }
 }
 
-void CardKnowledge::setIsWorthless(bool knownWorthless)
+void CardKnowledge::setIsWorthless(const SmartBot *bot, bool knownWorthless)
 {
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            if (this->cantBe_[k][v]) continue;
-            if (bot_->isWorthless(Card(k,v)) != knownWorthless) {
-                this->cantBe_[k][v] = true;
-            }
-        }
-    }
-    possibilities_ = -1;
-    if (color_ == -1) color_ = -2;
-    if (value_ == -1) value_ = -2;
-    if (playable_ == MAYBE) probabilityPlayable_ = -1.0;
-    if (valuable_ == MAYBE) probabilityValuable_ = -1.0;
+    restrictTo(knownWorthless ? bot->board_.worthless : ~bot->board_.worthless);
     worthless_ = (knownWorthless ? YES : NO);
     probabilityWorthless_ = (knownWorthless ? 1.0 : 0.0);
     if (knownWorthless) { playable_ = valuable_ = NO; probabilityPlayable_ = probabilityValuable_ = 0.0; }
@@ -245,15 +173,8 @@ void CardKnowledge::setIsWorthless(bool knownWorthless)
 void CardKnowledge::computeIdentity() const
 {
     if (color_ != -2 && value_ != -2) return;
-    int color = -2;
-    int value = -2;
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            if (this->cantBe_[k][v]) continue;
-            color = (color == -2 || color == k) ? k : -1;
-            value = (value == -2 || value == v) ? v : -1;
-        }
-    }
+    int color = possible_.color();
+    int value = possible_.value();
     if (color == -2) {
       //Comment to enable crossplay
       //assert(this->bot_->permissive_);
@@ -271,12 +192,7 @@ void CardKnowledge::computeIdentity() const
 void CardKnowledge::computePossibilities() const
 {
     if (possibilities_ != -1) return;
-    int possibilities = 0;
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            possibilities += !this->cantBe_[k][v];
-        }
-    }
+    int possibilities = possible_.count();
     if (possibilities < 1) { // confused
       //Comment to enable crossplay
       //assert(this->bot_->permissive_);
@@ -286,78 +202,40 @@ void CardKnowledge::computePossibilities() const
     possibilities_ = possibilities;
 }
 
-void CardKnowledge::computePlayable() const
+void CardKnowledge::computeFraction(CardMask yes, float &probability, trivalue &tri) const
 {
-    if (probabilityPlayable_ != -1.0f) return;
-    int total_count = 0;
-    int yes_count = 0;
-    for (Color k = RED; k <= BLUE; ++k) {
-        int playableValue = bot_->server_->pileOf(k).size() + 1;
-        for (int v = 1; v <= 5; ++v) {
-            if (this->cantBe_[k][v]) continue;
-            total_count += 1;
-            yes_count += (v == playableValue);
-        }
-    }
+    const int total_count = possible_.count();
+    const int yes_count = (possible_ & yes).count();
     if (total_count < 1) { // confused
       //Comment to enable crossplay
       //assert(this->bot_->permissive_);
-      probabilityPlayable_ = 0.5;
-      playable_ = MAYBE;
+      probability = 0.5;
+      tri = MAYBE;
       return;
     }
-    probabilityPlayable_ = (float)yes_count / total_count;
-    playable_ = (yes_count == total_count) ? YES : (yes_count != 0) ? MAYBE : NO;
+    probability = (float)yes_count / total_count;
+    tri = (yes_count == total_count) ? YES : (yes_count != 0) ? MAYBE : NO;
+}
+
+void CardKnowledge::computePlayable(const SmartBot *bot) const
+{
+    if (probabilityPlayable_ != -1.0f) return;
+    computeFraction(bot->board_.playable, probabilityPlayable_, playable_);
 }
 
-void CardKnowledge::computeValuable() const
+void CardKnowledge::computeValuable(const SmartBot *bot) const
 {
     if (probabilityValuable_ != -1.0f) return;
-    int total_count = 0;
-    int yes_count = 0;
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            if (this->cantBe_[k][v]) continue;
-            total_count += 1;
-            yes_count += bot_->isValuable(Card(k, v));
-        }
-    }
-    if (total_count < 1) { // confused
-      //Comment to enable crossplay
-      //assert(this->bot_->permissive_);
-      probabilityValuable_ = 0.5;
-      valuable_ = MAYBE;
-      return;
-    }
-    probabilityValuable_ = (float)yes_count / total_count;
-    valuable_ = (yes_count == total_count) ? YES : (yes_count != 0) ? MAYBE : NO;
+    computeFraction(bot->board_.valuable, probabilityValuable_, valuable_);
 }
 
-void CardKnowledge::computeWorthless() const
+void CardKnowledge::computeWorthless(const SmartBot *bot) const
 {
     if (probabilityWorthless_ != -1.0f) return;
-    int total_count = 0;
-    int yes_count = 0;
-    for (Color k = RED; k <= BLUE; ++k) {
-        for (int v = 1; v <= 5; ++v) {
-            if (this->cantBe_[k][v]) continue;
-            total_count += 1;
-            yes_count += bot_->isWorthless(Card(k, v));
-        }
-    }
-    if (total_count < 1) { // confused
-      //Comment to enable crossplay
-      //assert(this->bot_->permissive_);
-      probabilityWorthless_ = 0.5;
-      worthless_ = MAYBE;
-      return;
-    }
-    probabilityWorthless_ = (float)yes_count / total_count;
-    worthless_ = (yes_count == total_count) ? YES : (yes_count != 0) ? MAYBE : NO;
+    computeFraction(bot->board_.worthless, probabilityWorthless_, worthless_);
 }
 
-template<bool useMyEyesight>
-void CardKnowledge::update()
+void CardKnowledge::update(CardMask exhausted)
 {
     /* Rule out any cards that have been completely played and/or discarded. */
     if (!known()) {
@@ -365,22 +243,8 @@ void CardKnowledge::update()
          * listed in locatedCount_/eyesightCount_. Notice that if this card HAS
          * been identified, then it WILL be represented in locatedCount_, by
          * definition, and so we should skip this logic in the "known" case. */
-        bool recompute = false;
-        for (Color k = RED; k <= BLUE; ++k) {
-            for (int v = 1; v <= 5; ++v) {
-                if (this->cantBe_[k][v]) continue;
-                const int total = (v == 1 ? 3 : (v == 5 ? 1 : 2));
-                const int played = bot_->playedCount_[k][v];
-                const int held = (useMyEyesight ? bot_->eyesightCount_[k][v] : bot_->locatedCount_[k][v]);
-                //Comment to enable crossplay
-                //assert(played+held <= total || this->bot_->permissive_);
-                if (played+held >= total) {
-                    this->cantBe_[k][v] = true;
-                    recompute = true;
-                }
-            }
-        }
-        if (recompute) {
+        if (!(possible_ & exhausted).empty()) {
+            possible_ &= ~exhausted;
             possibilities_ = -1;
             color_ = -2;
             value_ = -2;
@@ -390,12 +254,6 @@ void CardKnowledge::update()
     }
 }
 
-CardKnowledge CardKnowledge::transfer(const SmartBot *bot) const {
-  CardKnowledge clone(*this);
-  clone.bot_ = bot;
-  return clone;
-}
-
 Hint::Hint()
 {
     fitness = -1;
@@ -426,70 +284,104 @@ void Hint::give(Server &server)
 
 SmartBot::SmartBot(int index, int numPlayers, int handSize)
 {
+    if (numPlayers > MAX_PLAYERS || handSize > MAX_HAND_SIZE) {
+        throw std::runtime_error("SmartBot supports at most " + std::to_string(MAX_PLAYERS) +
+                                 " players and " + std::to_string(MAX_HAND_SIZE) + " cards per hand");
+    }
+    server_ = nullptr;
     me_ = index;
-    handKnowledge_.resize(numPlayers);
+    numPlayers_ = numPlayers;
+    myHandSize_ = handSize;
     for (int i=0; i < numPlayers; ++i) {
-        handKnowledge_[i].resize(handSize, CardKnowledge(this));
+        handKnowledge_[i].resize(handSize);
     }
     std::memset(playedCount_, '\0', sizeof playedCount_);
+    std::memset(locatedCount_, '\0', sizeof locatedCount_);
+    std::memset(locatedAs_, -1, sizeof locatedAs_);
+    std::memset(eyesightCount_, '\0', sizeof eyesightCount_);
+    drawnSinceSweep_ = true;
 }
 
 bool SmartBot::isPlayable(Card card) const
 {
-    const int playableValue = server_->pileOf(card.color).size() + 1;
-    return (card.value == playableValue);
+    return board_.playable.contains(card);
 }
 
 bool SmartBot::isValuable(Card card) const
 {
     /* A card which has not yet been played, and which is the
      * last of its kind, is valuable. */
-    if (playedCount_[card.color][card.value] != card.count()-1) return false;
-    return !this->isWorthless(card);
+    return board_.valuable.contains(card);
 }
 
 bool SmartBot::isWorthless(Card card) const
 {
-    const int playableValue = server_->pileOf(card.color).size() + 1;
-    if (card.value < playableValue) return true;
     /* If all the red 4s are in the discard pile, then the red 5 is worthless. */
-    while (card.value > playableValue) {
-        --card.value;
-        if (playedCount_[card.color][card.value] == card.count()) return true;
+    return board_.worthless.contains(card);
+}
+
+void SmartBot::updateBoard()
+{
+    int pileSizes[NUMCOLORS];
+    for (Color k = RED; k <= BLUE; ++k) {
+        pileSizes[k] = server_->pileOf(k).size();
     }
-    return false;
+    board_ = BoardMasks::compute(pileSizes, playedCount_);
+}
+
+CardMask SmartBot::exhaustedMask(const int8_t heldCount[NUMCOLORS][5+1]) const
+{
+    CardMask result;
+    for (Color k = RED; k <= BLUE; ++k) {
+        for (int v = 1; v <= 5; ++v) {
+            const int total = (v == 1 ? 3 : (v == 5 ? 1 : 2));
+            //Comment to enable crossplay
+            //assert(playedCount_[k][v] + heldCount[k][v] <= total || permissive_);
+            if (playedCount_[k][v] + heldCount[k][v] >= total) result.add(k, v);
+        }
+    }
+    return result;
 }
 
 /* Could this card be playable, if it were known to be of value "value"? */
-bool CardKnowledge::couldBePlayableWithValue(int value) const
+bool CardKnowledge::couldBePlayableWithValue(const SmartBot *bot, int value) const
 {
     if (value < 1 || 5 < value || this->cannotBe(Value(value))) return false;
-    if (this->playable() != MAYBE) return false;
+    if (this->playable(bot) != MAYBE) return false;
     CardKnowledge newKnol = *this;
     
     newKnol.setMustBe(Value(value));
-    return newKnol.playable() != NO;
+    return newKnol.playable(bot) != NO;
 }
 
 /* Could this card be valuable, if it were known to be of value "value"? */
-bool CardKnowledge::couldBeValuableWithValue(int value) const
+bool CardKnowledge::couldBeValuableWithValue(const SmartBot *bot, int value) const
 {
     if (value < 1 || 5 < value || this->cannotBe(Value(value))) return false;
-    if (this->valuable() != MAYBE) return false;
+    if (this->valuable(bot) != MAYBE) return false;
     CardKnowledge newKnol = *this;
     newKnol.setMustBe(Value(value));
-    return newKnol.valuable() != NO;
+    return newKnol.valuable(bot) != NO;
 }
 
 void SmartBot::invalidateKnol(int player_index, int card_index, bool draw_new_card)
 {
     /* The other cards are shifted down and a new one drawn at the end. */
-    std::vector<CardKnowledge> &vec = handKnowledge_[player_index];
+    HandKnowledge &vec = handKnowledge_[player_index];
+    int8_t *located = locatedAs_[player_index];
+    if (located[card_index] >= 0) {
+        const int id = located[card_index];
+        locatedCount_[id / 5][id % 5 + 1] -= 1;
+        this->updateExhausted(id / 5, id % 5 + 1);
+    }
     for (int i = card_index; i+1 < vec.size(); ++i) {
         vec[i] = vec[i+1];
+        located[i] = located[i+1];
     }
+    located[vec.size() - 1] = -1;
     if (draw_new_card) {
-        vec.back() = CardKnowledge(this);
+        vec.back() = CardKnowledge();
+        drawnSinceSweep_ = true;
     } else {
         vec.pop_back();
     }
@@ -497,40 +389,104 @@ void SmartBot::invalidateKnol(int player_index, int card_index, bool draw_new_ca
 
 void SmartBot::seePublicCard(const Card &card)
 {
-    int &entry = this->playedCount_[card.color][card.value];
+    int8_t &entry = this->playedCount_[card.color][card.value];
     entry += 1;
     // std::cerr << "seePublicCard " << card.toString() << " newcount " << entry << std::endl;
     assert(1 <= entry && entry <= card.count());
+    this->updateExhausted(card.color, card.value);
+    this->updateBoard();
 }
 
 void SmartBot::updateEyesightCount()
 {
     std::memset(this->eyesightCount_, '\0', sizeof this->eyesightCount_);
 
-    const int numPlayers = handKnowledge_.size();
+    /* Other players' hands are read off the server rather than tracked:
+     * search deals different hands to the same bot state. */
+    const int numPlayers = numPlayers_;
     for (int p=0; p < numPlayers; ++p) {
         if (p == me_) {
             for (int i=0; i < myHandSize_; ++i) {
-                CardKnowledge &knol = handKnowledge_[p][i];
-                if (knol.known()) {
-                    this->eyesightCount_[knol.color()][knol.value()] += 1;
+                const int id = locatedAs_[p][i];
+                if (id >= 0) {
+                    this->eyesightCount_[id / 5][id % 5 + 1] += 1;
                 }
             }
         } else {
-            const std::vector<Card> hand = server_->handOfPlayer(p);
+            const std::vector<Card> &hand = server_->handOfPlayer(p);
             for (int i=0; i < hand.size(); ++i) {
                 const Card &card = hand[i];
                 this->eyesightCount_[card.color][card.value] += 1;
             }
         }
     }
+    eyesightExhausted_ = exhaustedMask(eyesightCount_);
 }
 
-bool SmartBot::updateLocatedCount()
+void SmartBot::updateExhausted(int color, int value)
 {
-    int newCount[Hanabi::NUMCOLORS][5+1] = {};
+    const int total = (value == 1 ? 3 : (value == 5 ? 1 : 2));
+    if (playedCount_[color][value] + locatedCount_[color][value] >= total) {
+        locatedExhausted_.add(color, value);
+    } else {
+        locatedExhausted_.remove(color, value);
+    }
+}
+
+/* Bring locatedCount_ up to date with what is now known about a card. */
+void SmartBot::relocate(int player_index, int card_index)
+{
+    const CardKnowledge &knol = handKnowledge_[player_index][card_index];
+    const int id = knol.known() ? knol.color() * 5 + knol.value() - 1 : -1;
+    int8_t &was = locatedAs_[player_index][card_index];
+    if (id == was) return;
+    if (was >= 0) {
+        locatedCount_[was / 5][was % 5 + 1] -= 1;
+        this->updateExhausted(was / 5, was % 5 + 1);
+    }
+    if (id >= 0) {
+        locatedCount_[id / 5][id % 5 + 1] += 1;
+        this->updateExhausted(id / 5, id % 5 + 1);
+    }
+    was = id;
+}
+
+void SmartBot::relocateHand(int player_index)
+{
+    for (int i=0; i < handKnowledge_[player_index].size(); ++i) {
+        this->relocate(player_index, i);
+    }
+}
 
-    for (int p=0; p < handKnowledge_.size(); ++p) {
+/* Rule out cards whose copies are all played or located, in every hand,
+ * until that identifies no new cards. Each sweep applies the same mask to
+ * every card. A sweep is only needed once the mask has grown or a card has
+ * been drawn: hints only remove possibilities, so every other card
+ * already excludes sweptExhausted_. */
+void SmartBot::sweepLocated()
+{
+    while (drawnSinceSweep_ || sweptExhausted_ != locatedExhausted_) {
+        const CardMask exhausted = locatedExhausted_;
+        drawnSinceSweep_ = false;
+        for (int p=0; p < numPlayers_; ++p) {
+            const int numCards = handKnowledge_[p].size();
+            for (int i=0; i < numCards; ++i) {
+                handKnowledge_[p][i].update(exhausted);
+                this->relocate(p, i);
+            }
+        }
+        sweptExhausted_ = exhausted;
+    }
+}
+
+/* Build with -DSMARTBOT_CHECK_COUNTS to cross-check the incrementally
+ * maintained tables against a full recount on every turn. */
+void SmartBot::checkLocatedCount() const
+{
+#ifdef SMARTBOT_CHECK_COUNTS
+    int8_t newCount[Hanabi::NUMCOLORS][5+1] = {};
+
+    for (int p=0; p < numPlayers_; ++p) {
         for (int i=0; i < handKnowledge_[p].size(); ++i) {
             const CardKnowledge &knol = handKnowledge_[p][i];
             if (knol.known()) {
@@ -540,10 +496,12 @@ bool SmartBot::updateLocatedCount()
     }
 
     if (std::memcmp(this->locatedCount_, newCount, sizeof newCount) != 0) {
-        std::memcpy(this->locatedCount_, newCount, sizeof newCount);
-        return true;  /* there was a change */
+        throw std::runtime_error("SmartBot: incremental locatedCount_ differs from a full recount");
     }
-    return false;
+    if (locatedExhausted_ != exhaustedMask(newCount)) {
+        throw std::runtime_error("SmartBot: incremental locatedExhausted_ differs from a full recount");
+    }
+#endif
 }
 
 int SmartBot::nextDiscardIndex(int to) const
@@ -554,11 +512,11 @@ int SmartBot::nextDiscardIndex(int to) const
     for (int i=0; i < numCards; ++i) {
         const CardKnowledge &knol = handKnowledge_[to][i];
 
-        if (knol.playable() == YES) return -1;  /* we should just play this card */
-        if (knol.worthless() == YES) return -1;  /* we should already have discarded this card */
-        if (knol.valuable() == YES) continue;  /* we should never discard this card */
+        if (knol.playable(this) == YES) return -1;  /* we should just play this card */
+        if (knol.worthless(this) == YES) return -1;  /* we should already have discarded this card */
+        if (knol.valuable(this) == YES) continue;  /* we should never discard this card */
 
-        double fitness = 100 + knol.probabilityWorthless();
+        double fitness = 100 + knol.probabilityWorthless(this);
         if (fitness > best_fitness) {
             best_fitness = fitness;
             best_index = i;
@@ -578,40 +536,32 @@ void SmartBot::noValuableWarningWasGiven(int from)
     if (server_->cardsRemainingInDeck() == 0) return;
     if (server_->hintStonesRemaining() == 0) return;
 
-    const int playerExpectingWarning = (from + 1) % handKnowledge_.size();
+    const int playerExpectingWarning = (from + 1) % numPlayers_;
     const int discardIndex = this->nextDiscardIndex(playerExpectingWarning);
 
     if (discardIndex != -1) {
-        handKnowledge_[playerExpectingWarning][discardIndex].setIsValuable(false);
+        handKnowledge_[playerExpectingWarning][discardIndex].setIsValuable(this, false);
+        this->relocate(playerExpectingWarning, discardIndex);
     }
 }
 
 void SmartBot::pleaseObserveBeforeMove(const Server &server)
 {
     server_ = &server;
+    this->updateBoard();
     assert(server.whoAmI() == me_);
 
     myHandSize_ = server.sizeOfHandOfPlayer(me_);
 
 #ifndef NDEBUG
-    for (int p=0; p < handKnowledge_.size(); ++p) {
+    for (int p=0; p < numPlayers_; ++p) {
         assert(handKnowledge_[p].size() == server.sizeOfHandOfPlayer(p) || permissive_);
     }
 #endif
 
-    std::memset(this->locatedCount_, '\0', sizeof this->locatedCount_);
-    this->updateLocatedCount();
-    do {
-        for (int p=0; p < handKnowledge_.size(); ++p) {
-            const int numCards = handKnowledge_[p].size();
-            for (int i=0; i < numCards; ++i) {
-                CardKnowledge &knol = handKnowledge_[p][i];
-                knol.update<false>();
-            }
-        }
-    } while (this->updateLocatedCount());
-
-    this->updateEyesightCount();
+    this->checkLocatedCount();
+    this->sweepLocated();
+    this->checkLocatedCount();
 
     //Comment to enable crossplay
     // for (Color k = RED; k <= BLUE; ++k) {
@@ -624,18 +574,19 @@ void SmartBot::pleaseObserveBeforeMove(const Server &server)
 void SmartBot::pleaseObserveBeforeDiscard(const Hanabi::Server &server, int from, int card_index)
 {
     server_ = &server;
+    this->updateBoard();
     assert(server.whoAmI() == me_);
     Card card = server.activeCard();
 
     this->noValuableWarningWasGiven(from);
 
     const CardKnowledge& knol = handKnowledge_[from][card_index];
-    if (knol.known() && knol.playable() == YES) {
+    if (knol.known() && knol.playable(this) == YES) {
         /* Alice is discarding a playable card whose value she knows.
          * This indicates a "discard finesse": she can see someone at the table
          * with that same card as their newest card. Look around the table. If
          * you can't see who has that card, it must be you. */
-        const int numPlayers = handKnowledge_.size();
+        const int numPlayers = numPlayers_;
         bool seenIt = false;
         for (int partner = 0; partner < numPlayers; ++partner) {
             if (partner == from || partner == me_) continue;
@@ -643,6 +594,7 @@ void SmartBot::pleaseObserveBeforeDiscard(const Hanabi::Server &server, int from
             if (newestCard == card) {
                 handKnowledge_[partner].back().setMustBe(card.color);
                 handKnowledge_[partner].back().setMustBe(card.value);
+                this->relocate(partner, handKnowledge_[partner].size() - 1);
                 seenIt = true;
                 break;
             }
@@ -650,6 +602,7 @@ void SmartBot::pleaseObserveBeforeDiscard(const Hanabi::Server &server, int from
         if (!seenIt) {
             handKnowledge_[me_].back().setMustBe(card.color);
             handKnowledge_[me_].back().setMustBe(card.value);
+            this->relocate(me_, handKnowledge_[me_].size() - 1);
         }
     }
 
@@ -666,6 +619,7 @@ void SmartBot::pleaseObserveBeforeDiscard(const Hanabi::Server &server, int from
 void SmartBot::pleaseObserveBeforePlay(const Hanabi::Server &server, int from, int card_index)
 {
     server_ = &server;
+    this->updateBoard();
     assert(server.whoAmI() == me_);
     Card card = server.activeCard();
     const bool success = this->isPlayable(card);
@@ -674,8 +628,8 @@ void SmartBot::pleaseObserveBeforePlay(const Hanabi::Server &server, int from, i
 
 //#ifndef NDEBUG
     //Comment to enable crossplay
-    //assert(handKnowledge_[from][card_index].worthless() != YES || permissive_);
-//     if (handKnowledge_[from][card_index].valuable() == YES) {
+    //assert(handKnowledge_[from][card_index].worthless(this) != YES || permissive_);
+//     if (handKnowledge_[from][card_index].valuable(this) == YES) {
 //         /* We weren't wrong about this card being valuable, were we? */
 //         assert(this->isValuable(card) || permissive_);
 //     }
@@ -694,6 +648,7 @@ void SmartBot::pleaseObserveBeforePlay(const Hanabi::Server &server, int from, i
 void SmartBot::pleaseObserveColorHint(const Hanabi::Server &server, int from, int to, Color color, CardIndices card_indices)
 {
     server_ = &server;
+    this->updateBoard();
     assert(server.whoAmI() == me_);
 
     /* Alice has given Bob a color hint. Using SmartBot's strategy,
@@ -706,30 +661,31 @@ void SmartBot::pleaseObserveColorHint(const Hanabi::Server &server, int from, in
     int inferredPlayableIndex = -1;
     for (int i=numCards-1; i >= 0; --i) {
         CardKnowledge &knol = handKnowledge_[to][i];
-        const bool wasMaybePlayable = (knol.playable() == MAYBE);
+        const bool wasMaybePlayable = (knol.playable(this) == MAYBE);
         if (card_indices.contains(i)) {
             knol.setMustBe(color);
             if (wasMaybePlayable) {
-                if (knol.playable() == YES) {
+                if (knol.playable(this) == YES) {
                     identifiedPlayableCard = true;
-                } else if (knol.playable() == MAYBE) {
+                } else if (knol.playable(this) == MAYBE) {
                     if (inferredPlayableIndex == -1) inferredPlayableIndex = i;
                 }
             }
         } else {
             knol.setCannotBe(color);
             if (wasMaybePlayable) {
-                if (knol.playable() == YES) {
+                if (knol.playable(this) == YES) {
                     identifiedPlayableCard = true;
                 }
             }
         }
     }
     if (!identifiedPlayableCard && inferredPlayableIndex >= 0) {
-        handKnowledge_[to][inferredPlayableIndex].setIsPlayable(true);
+        handKnowledge_[to][inferredPlayableIndex].setIsPlayable(this, true);
     }
+    this->relocateHand(to);
 
-    const int playerExpectingWarning = (from + 1) % handKnowledge_.size();
+    const int playerExpectingWarning = (from + 1) % numPlayers_;
     if (to != playerExpectingWarning) {
         this->noValuableWarningWasGiven(from);
     }
@@ -738,6 +694,7 @@ void SmartBot::pleaseObserveColorHint(const Hanabi::Server &server, int from, in
 void SmartBot::pleaseObserveValueHint(const Hanabi::Server &server, int from, int to, Value value, CardIndices card_indices)
 {
     server_ = &server;
+    this->updateBoard();
     assert(server.whoAmI() == me_);
 
     /* Someone has given Bob a value hint. If the named cards
@@ -745,7 +702,7 @@ void SmartBot::pleaseObserveValueHint(const Hanabi::Server &server, int from, in
      * then this must be a warning that that card is valuable.
      * Otherwise, all the named cards are playable. */
 
-    const int playerExpectingWarning = (from + 1) % handKnowledge_.size();
+    const int playerExpectingWarning = (from + 1) % numPlayers_;
     const int discardIndex = this->nextDiscardIndex(playerExpectingWarning);
 
     const bool isHintStoneReclaim =
@@ -756,12 +713,12 @@ void SmartBot::pleaseObserveValueHint(const Hanabi::Server &server, int from, in
         !isHintStoneReclaim &&
         (to == playerExpectingWarning) &&
         card_indices.contains(discardIndex) &&
-        handKnowledge_[to][discardIndex].couldBeValuableWithValue(value);
+        handKnowledge_[to][discardIndex].couldBeValuableWithValue(this, value);
 
     if (isWarning && discardIndex != -1) {
         //Comment to enable crossplay
         //assert(discardIndex != -1);
-        handKnowledge_[to][discardIndex].setIsValuable(true);
+        handKnowledge_[to][discardIndex].setIsValuable(this, true);
     }
 
     const int numCards = server.sizeOfHandOfPlayer(to);
@@ -770,28 +727,29 @@ void SmartBot::pleaseObserveValueHint(const Hanabi::Server &server, int from, in
     int inferredPlayableIndex = -1;
     for (int i=numCards-1; i >= 0; --i) {
         CardKnowledge &knol = handKnowledge_[to][i];
-        const bool wasMaybePlayable = (knol.playable() == MAYBE);
+        const bool wasMaybePlayable = (knol.playable(this) == MAYBE);
         if (card_indices.contains(i)) {
             knol.setMustBe(value);
             if (wasMaybePlayable) {
-                if (knol.playable() == YES) {
+                if (knol.playable(this) == YES) {
                     identifiedPlayableCard = true;
-                } else if (knol.playable() == MAYBE) {
+                } else if (knol.playable(this) == MAYBE) {
                     if (inferredPlayableIndex == -1) inferredPlayableIndex = i;
                 }
             }
         } else {
             knol.setCannotBe(value);
             if (wasMaybePlayable) {
-                if (knol.playable() == YES) {
+                if (knol.playable(this) == YES) {
                     identifiedPlayableCard = true;
                 }
             }
         }
     }
     if (!isWarning && !isHintStoneReclaim && !identifiedPlayableCard && inferredPlayableIndex >= 0) {
-        handKnowledge_[to][inferredPlayableIndex].setIsPlayable(true);
+        handKnowledge_[to][inferredPlayableIndex].setIsPlayable(this, true);
     }
+    this->relocateHand(to);
     if (to != playerExpectingWarning) {
         assert(!isWarning);
         this->noValuableWarningWasGiven(from);
@@ -808,7 +766,7 @@ bool SmartBot::maybePlayLowestPlayableCard(Server &server)
     int best_index = -1;
     double best_fitness = 0;
     for (int i=0; i < myHandSize_; ++i) {
-        if (handKnowledge_[me_][i].playable() == NO) continue;
+        if (handKnowledge_[me_][i].playable(this) == NO) continue;
 
         /* Try to find a card that nobody else knows I know is playable
          * (because they don't see what I see). Let's try to get that card
@@ -816,8 +774,8 @@ bool SmartBot::maybePlayLowestPlayableCard(Server &server)
          * Otherwise, prefer lower-valued cards over higher-valued ones.
          */
         CardKnowledge eyeKnol = handKnowledge_[me_][i];
-        eyeKnol.update<true>();
-        if (eyeKnol.playable() != YES) continue;
+        eyeKnol.update(eyesightExhausted_);
+        if (eyeKnol.playable(this) != YES) continue;
 
         /* How many further plays are enabled by this play?
          * Rough heuristic: 5 minus its value. Notice that this
@@ -827,7 +785,7 @@ bool SmartBot::maybePlayLowestPlayableCard(Server &server)
          * TODO: avoid stepping on other players' plays.
          */
         double fitness = (6 - eyeKnol.value());
-        if (handKnowledge_[me_][i].playable() != YES) fitness += 100;
+        if (handKnowledge_[me_][i].playable(this) != YES) fitness += 100;
         if (fitness > best_fitness) {
             best_index = i;
             best_fitness = fitness;
@@ -848,18 +806,18 @@ bool SmartBot::maybeDiscardWorthlessCard(Server &server)
     int best_index = -1;
     double best_fitness = 0;
     for (int i=0; i < myHandSize_; ++i) {
-        if (handKnowledge_[me_][i].worthless() == NO) continue;
+        if (handKnowledge_[me_][i].worthless(this) == NO) continue;
 
         /* Prefer a card that nobody else knows I know is worthless
          * (because they don't see what I see). Let's try to get that card
          * out of my hand before someone "helpfully" wastes a hint on it.
          */
-        if (handKnowledge_[me_][i].worthless() == MAYBE) {
+        if (handKnowledge_[me_][i].worthless(this) == MAYBE) {
             CardKnowledge eyeKnol = handKnowledge_[me_][i];
-            eyeKnol.update<true>();
-            if (eyeKnol.worthless() != YES) continue;
+            eyeKnol.update(eyesightExhausted_);
+            if (eyeKnol.worthless(this) != YES) continue;
         }
-        double fitness = 2.0 - handKnowledge_[me_][i].probabilityWorthless();
+        double fitness = 2.0 - handKnowledge_[me_][i].probabilityWorthless(this);
         if (fitness > best_fitness) {
             best_index = i;
             best_fitness = fitness;
@@ -875,7 +833,7 @@ bool SmartBot::maybeDiscardWorthlessCard(Server &server)
     return false;
 }
 
-int reduction_in_entropy(const std::vector<CardKnowledge>& oldKnols, const std::vector<CardKnowledge>& newKnols)
+int reduction_in_entropy(const HandKnowledge& oldKnols, const HandKnowledge& newKnols)
 {
     int result = 0;
     for (int i=0; i < oldKnols.size(); ++i) {
@@ -953,16 +911,16 @@ Hint SmartBot::bestHintForPlayer(int partner) const
 
     /* Avoid giving hints that could be misinterpreted as warnings. */
     int valueToAvoid = -1;
-    if (partner == (me_ + 1) % handKnowledge_.size()) {
+    if (partner == (me_ + 1) % numPlayers_) {
         const int discardIndex = nextDiscardIndex(partner);
         if (discardIndex != -1) {
             const CardKnowledge &knol = handKnowledge_[partner][discardIndex];
             valueToAvoid = partners_hand[discardIndex].value;
-            if (!knol.couldBeValuableWithValue(valueToAvoid)) valueToAvoid = -1;
+            if (!knol.couldBeValuableWithValue(this, valueToAvoid)) valueToAvoid = -1;
         }
     }
 
-    return bestHintForPlayerGivenConstraint(partner, [&](Hint hint, const std::vector<CardKnowledge>& oldKnols, const std::vector<CardKnowledge>& newKnols) {
+    return bestHintForPlayerGivenConstraint(partner, [&](Hint hint, const HandKnowledge& oldKnols, const HandKnowledge& newKnols) {
         if (hint.value != -1 && hint.value == valueToAvoid) {
             // This hint would be misinterpreted as a valuable warning.
             return false;
@@ -977,10 +935,10 @@ Hint SmartBot::bestHintForPlayer(int partner) const
         bool reveals_a_playable_card = false;
         trivalue is_misleading = MAYBE;
         for (int c = partners_hand.size()-1; c >= 0; --c) {
-            if (oldKnols[c].playable() != MAYBE) continue;
-            if (newKnols[c].playable() == YES) {
+            if (oldKnols[c].playable(this) != MAYBE) continue;
+            if (newKnols[c].playable(this) == YES) {
                 reveals_a_playable_card = true;
-            } else if (newKnols[c].playable() == MAYBE && hint.includes(partners_hand[c])) {
+            } else if (newKnols[c].playable(this) == MAYBE && hint.includes(partners_hand[c])) {
                 if (is_misleading == MAYBE) {
                     is_misleading = (is_really_playable[c] ? NO : YES);
                 }
@@ -1001,7 +959,7 @@ bool SmartBot::maybeGiveValuableWarning(Server &server)
     /* Sometimes we just can't give a hint. */
     if (server.hintStonesRemaining() == 0) return false;
 
-    const int numPlayers = handKnowledge_.size();
+    const int numPlayers = numPlayers_;
     const int player_to_warn = (me_ + 1) % numPlayers;
 
     /* Is the player to our left just about to discard a card
@@ -1016,9 +974,9 @@ bool SmartBot::maybeGiveValuableWarning(Server &server)
 
     /* Oh no! Warn him before he discards it! */
     //Comment to enable crossplay
-    // assert(handKnowledge_[player_to_warn][discardIndex].playable() != YES);
-    // assert(handKnowledge_[player_to_warn][discardIndex].valuable() != YES);
-    // assert(handKnowledge_[player_to_warn][discardIndex].worthless() != YES);
+    // assert(handKnowledge_[player_to_warn][discardIndex].playable(this) != YES);
+    // assert(handKnowledge_[player_to_warn][discardIndex].valuable(this) != YES);
+    // assert(handKnowledge_[player_to_warn][discardIndex].worthless(this) != YES);
 
     Hint bestHint = bestHintForPlayer(player_to_warn);
     if (bestHint.fitness > 0) {
@@ -1042,7 +1000,7 @@ bool SmartBot::maybeDiscardFinesse(Server &server)
 
     for (int i = 0; i < handKnowledge_[me_].size(); ++i) {
         const CardKnowledge& knol = handKnowledge_[me_][i];
-        if (knol.known() && knol.valuable() == NO && knol.playable() == YES) {
+        if (knol.known() && knol.valuable(this) == NO && knol.playable(this) == YES) {
             myPlayableCards.push_back(knol.knownCard());
             myPlayableIndices.push_back(i);
         }
@@ -1052,7 +1010,7 @@ bool SmartBot::maybeDiscardFinesse(Server &server)
 
     std::vector<Card> othersNewestCards;
 
-    const int numPlayers = handKnowledge_.size();
+    const int numPlayers = numPlayers_;
     for (int i = 1; i < numPlayers; ++i) {
         const int partner = (me_ + i) % numPlayers;
         othersNewestCards.push_back(server.handOfPlayer(partner).back());
@@ -1072,7 +1030,7 @@ bool SmartBot::maybeGiveHelpfulHint(Server &server)
 {
     if (server.hintStonesRemaining() == 0) return false;
 
-    const int numPlayers = handKnowledge_.size();
+    const int numPlayers = numPlayers_;
     Hint bestHint;
     for (int i = 1; i < numPlayers; ++i) {
         const int partner = (me_ + i) % numPlayers;
@@ -1104,11 +1062,11 @@ bool SmartBot::maybePlayMysteryCard(Server &server)
         int best_index = -1;
         for (int i = handKnowledge_[me_].size() - 1; i >= 0; --i) {
             CardKnowledge eyeKnol = handKnowledge_[me_][i];
-            eyeKnol.update<true>();
+            eyeKnol.update(eyesightExhausted_);
             //Comment to enable crossplay
-            //assert(eyeKnol.playable() != YES);  /* or we would have played it already */
-            if (eyeKnol.playable() == MAYBE) {
-                double fitness = eyeKnol.probabilityPlayable();
+            //assert(eyeKnol.playable(this) != YES);  /* or we would have played it already */
+            if (eyeKnol.playable(this) == MAYBE) {
+                double fitness = eyeKnol.probabilityPlayable(this);
                 if (fitness > best_fitness) {
                     best_fitness = fitness;
                     best_index = i;
@@ -1136,7 +1094,7 @@ bool SmartBot::maybeDiscardOldCard(Server &server)
 
 std::map<std::string, std::string> SmartBot::handKnowledgeToMap() {
     std::map<std::string, std::string> knowledgeMap;
-    const int numPlayers = handKnowledge_.size();
+    const int numPlayers = numPlayers_;
     const int handSize = handKnowledge_[0].size();
     std::vector<std::string> cardPositions;
     if (handSize == 5) {
@@ -1167,12 +1125,12 @@ std::map<std::string, std::string> SmartBot::handKnowledgeToMap() {
             }
             
             // Playable, Valuable, Worthless
-            value << (cardKnowledge.playable() == YES ? "Y " : 
-                      cardKnowledge.playable() == NO ? "N " : "M ")  // Added space
-                  << (cardKnowledge.valuable() == YES ? "Y " : 
-                      cardKnowledge.valuable() == NO ? "N " : "M ")  // Added space
-                  << (cardKnowledge.worthless() == YES ? "Y" : 
-                      cardKnowledge.worthless() == NO ? "N" : "M");  // No space after last value
+            value << (cardKnowledge.playable(this) == YES ? "Y " : 
+                      cardKnowledge.playable(this) == NO ? "N " : "M ")  // Added space
+                  << (cardKnowledge.valuable(this) == YES ? "Y " : 
+                      cardKnowledge.valuable(this) == NO ? "N " : "M ")  // Added space
+                  << (cardKnowledge.worthless(this) == YES ? "Y" : 
+                      cardKnowledge.worthless(this) == NO ? "N" : "M");  // No space after last value
             
             knowledgeMap[key] = value.str();
         }
@@ -1202,9 +1160,34 @@ void SmartBot::printHandKnowledge(const std::map<std::string, std::string>& know
     }
 }
 
+static_assert(int(NO) == KNOWLEDGE_NO && int(MAYBE) == KNOWLEDGE_MAYBE && int(YES) == KNOWLEDGE_YES,
+              "trivalues are exported as they are");
+
+void SmartBot::writeHandKnowledge(const Server &, const HandKnowledgeTensor &out) const
+{
+    for (int p = 0; p < numPlayers_; ++p) {
+        for (int i = 0; i < handKnowledge_[p].size(); ++i) {
+            const CardKnowledge &knol = handKnowledge_[p][i];
+            for (Color k = RED; k <= BLUE; ++k) {
+                out.at(p, i, KNOWLEDGE_COLOR + k) =
+                    knol.mustBe(k) ? KNOWLEDGE_YES : knol.cannotBe(k) ? KNOWLEDGE_NO : KNOWLEDGE_MAYBE;
+            }
+            for (int v = 1; v <= 5; ++v) {
+                out.at(p, i, KNOWLEDGE_VALUE + v - 1) =
+                    knol.mustBe(Value(v)) ? KNOWLEDGE_YES : knol.cannotBe(Value(v)) ? KNOWLEDGE_NO : KNOWLEDGE_MAYBE;
+            }
+            out.at(p, i, KNOWLEDGE_PLAYABLE) = knol.playable(this);
+            out.at(p, i, KNOWLEDGE_VALUABLE) = knol.valuable(this);
+            out.at(p, i, KNOWLEDGE_WORTHLESS) = knol.worthless(this);
+        }
+    }
+}
+
 void SmartBot::pleaseMakeMove(Server &server)
 {
     server_ = &server;
+    this->updateBoard();
+    this->updateEyesightCount();
     assert(server.whoAmI() == me_);
     assert(server.activePlayer() == me_);
     assert(UseMulligans || !server.mulligansUsed());
@@ -1238,7 +1221,7 @@ void SmartBot::pleaseMakeMove(Server &server)
         int best_index = 0;
         for (int i=0; i < myHandSize_; ++i) {
             //Comment to enable crossplay
-            //assert(handKnowledge_[me_][i].valuable() == YES || permissive_);  // FIXME: I'm not sure why this should ever fire...
+            //assert(handKnowledge_[me_][i].valuable(this) == YES || permissive_);  // FIXME: I'm not sure why this should ever fire...
             if (handKnowledge_[me_][i].value() > handKnowledge_[me_][best_index].value()) {
                 best_index = i;
             }
@@ -1248,25 +1231,24 @@ void SmartBot::pleaseMakeMove(Server &server)
 }
 
 SmartBot *SmartBot::clone() const {
-  SmartBot *b = new SmartBot(me_, handKnowledge_.size(), handKnowledge_[0].size());
-  b->server_ = this->server_;
-  b->me_ = this->me_;
-  b->myHandSize_ = this->myHandSize_;
-  assert(this->handKnowledge_.size() == b->handKnowledge_.size());
-  for (int i = 0; i < handKnowledge_.size(); i++) {
-    auto &hk = this->handKnowledge_[i];
-    b->handKnowledge_[i].clear();
-    for (int j = 0; j < hk.size(); j++) {
-      b->handKnowledge_[i].push_back(hk[j].transfer(b));
-    }
-  }
-  for (int c = 0; c < Hanabi::NUMCOLORS; c++) {
-    for (int r = 0; r < 5+1; r++) {
-      b->playedCount_[c][r] = this->playedCount_[c][r];
-      b->locatedCount_[c][r] = this->locatedCount_[c][r];
-      b->eyesightCount_[c][r] = this->eyesightCount_[c][r];
-    }
-  }
-  b->permissive_ = this->permissive_;
-  return b;
+  /* Bot::permissive_ plus a memcpy of SmartBotState */
+  return new SmartBot(*this);
+}
+
+void SmartBot::saveState(std::string &buf) const {
+  /* the same block that clone() copies, minus the server pointer */
+  SmartBotState state = *this;
+  state.server_ = nullptr;
+  StateWriter out(buf);
+  out.tag("SmartBot");
+  out.pod(permissive_);
+  out.pod(state);
+}
+
+size_t SmartBot::restoreState(const char *data, size_t size) {
+  StateReader in(data, size);
+  in.tag("SmartBot");
+  in.pod(permissive_);
+  in.pod(static_cast<SmartBotState &>(*this));
+  return in.consumed();
 }
@@ -7,7 +7,10 @@
 #pragma once
 
 #include "Hanabi.h"
+#include "CardMask.h"
+#include <cassert>
 #include <cstdint>
+#include <type_traits>
 
 class SmartBot;
 
@@ -17,9 +20,17 @@ enum trivalue : int8_t {
     NO, MAYBE, YES
 };
 
+/* SmartBot state is a fixed-size block (see SmartBotState), so these bound
+ * the games it can play. */
+constexpr int MAX_PLAYERS = 5;
+constexpr int MAX_HAND_SIZE = 5;  /* standard rules; HAND_SIZE_OVERRIDE beyond this is not supported */
+
+/* What a player knows about one card: the set of identities it could still
+ * be. Plain data: the queries that depend on the board (playable, valuable,
+ * ...) take the bot whose view to use, and AND with that bot's BoardMasks. */
 class CardKnowledge {
 public:
-    explicit CardKnowledge(const SmartBot *bot);
+    CardKnowledge();
 
     std::string toString() const;
 
@@ -34,14 +45,14 @@ public:
     void setMustBe(Hanabi::Card card);
     void setCannotBe(Hanabi::Color color);
     void setCannotBe(Hanabi::Value value);
-    void setIsPlayable(bool knownPlayable);
-    void setIsValuable(bool knownValuable);
-    void setIsWorthless(bool knownWorthless);
+    void setIsPlayable(const SmartBot *bot, bool knownPlayable);
+    void setIsValuable(const SmartBot *bot, bool knownValuable);
+    void setIsWorthless(const SmartBot *bot, bool knownWorthless);
     void befuddleByDiscard();
     void befuddleByPlay(bool success);
 
-    template<bool useMyEyesight>
-    void update();
+    /* Rule out the identities whose copies are all accounted for. */
+    void update(Hanabi::CardMask exhausted);
 
     bool known() const { computeIdentity(); return color_ != -1 && value_ != -1; }
     int color() const { computeIdentity(); return color_; }
@@ -50,29 +61,29 @@ public:
 
     int possibilities() const { computePossibilities(); return possibilities_; }
 
-    trivalue playable() const { computePlayable(); return playable_; }
-    trivalue valuable() const { computeValuable(); return valuable_; }
-    trivalue worthless() const { computeWorthless(); return worthless_; }
+    trivalue playable(const SmartBot *bot) const { computePlayable(bot); return playable_; }
+    trivalue valuable(const SmartBot *bot) const { computeValuable(bot); return valuable_; }
+    trivalue worthless(const SmartBot *bot) const { computeWorthless(bot); return worthless_; }
 
-    float probabilityPlayable() const { computePlayable(); return probabilityPlayable_; }
-    float probabilityValuable() const { computeValuable(); return probabilityValuable_; }
-    float probabilityWorthless() const { computeWorthless(); return probabilityWorthless_; }
+    float probabilityPlayable(const SmartBot *bot) const { computePlayable(bot); return probabilityPlayable_; }
+    float probabilityValuable(const SmartBot *bot) const { computeValuable(bot); return probabilityValuable_; }
+    float probabilityWorthless(const SmartBot *bot) const { computeWorthless(bot); return probabilityWorthless_; }
 
-    bool couldBePlayableWithValue(int value) const;
-    bool couldBeValuableWithValue(int value) const;
+    bool couldBePlayableWithValue(const SmartBot *bot, int value) const;
+    bool couldBeValuableWithValue(const SmartBot *bot, int value) const;
 
     void computeIdentity() const;
     void computePossibilities() const;
-    void computePlayable() const;
-    void computeValuable() const;
-    void computeWorthless() const;
-
-    CardKnowledge transfer(const SmartBot *bot) const;
+    void computePlayable(const SmartBot *bot) const;
+    void computeValuable(const SmartBot *bot) const;
+    void computeWorthless(const SmartBot *bot) const;
 
 private:
-    const SmartBot *bot_;
+    bool cantBe(int color, int value) const { return !possible_.contains(color, value); }
+    void restrictTo(Hanabi::CardMask mask);
+    void computeFraction(Hanabi::CardMask yes, float &probability, trivalue &tri) const;
 
-    bool cantBe_[Hanabi::NUMCOLORS][5+1];
+    Hanabi::CardMask possible_;
     mutable int8_t possibilities_;
     mutable int8_t color_;
     mutable int8_t value_;
@@ -84,6 +95,66 @@ private:
     mutable float probabilityWorthless_;
 };
 
+/* What a player knows about his hand: a fixed-capacity vector of CardKnowledge. */
+class HandKnowledge {
+public:
+    int size() const { return size_; }
+    CardKnowledge &operator[](int i) { assert(0 <= i && i < size_); return cards_[i]; }
+    const CardKnowledge &operator[](int i) const { assert(0 <= i && i < size_); return cards_[i]; }
+    CardKnowledge &back() { assert(size_ > 0); return cards_[size_ - 1]; }
+    CardKnowledge *begin() { return cards_; }
+    CardKnowledge *end() { return cards_ + size_; }
+    const CardKnowledge *begin() const { return cards_; }
+    const CardKnowledge *end() const { return cards_ + size_; }
+
+    void resize(int size) {
+        assert(0 <= size && size <= MAX_HAND_SIZE);
+        for (int i = size_; i < size; ++i) cards_[i] = CardKnowledge();
+        size_ = size;
+    }
+    void pop_back() { assert(size_ > 0); --size_; }
+
+private:
+    CardKnowledge cards_[MAX_HAND_SIZE];
+    int8_t size_ = 0;
+};
+
+/* Everything SmartBot knows, in one trivially copyable block, so that
+ * cloning a SmartBot (for every rollout and every hand in a search range)
+ * is a single memcpy. */
+struct SmartBotState {
+    const Hanabi::Server *server_;
+    int me_;
+    int numPlayers_;
+    int myHandSize_;  /* purely for convenience */
+
+    /* What does each player know about his own hand? */
+    HandKnowledge handKnowledge_[MAX_PLAYERS];
+    /* What cards have been played so far? */
+    int8_t playedCount_[Hanabi::NUMCOLORS][5+1];
+    /* What cards in players' hands are definitely identified?
+     * This table is kept up to date as hand knowledge changes: locatedAs_
+     * holds the identity (color*5 + value-1) each card is counted as, or -1. */
+    int8_t locatedCount_[Hanabi::NUMCOLORS][5+1];
+    int8_t locatedAs_[MAX_PLAYERS][MAX_HAND_SIZE];
+    /* What cards in players' hands are visible to me in particular?
+     * This table is recomputed when I am about to move. */
+    int8_t eyesightCount_[Hanabi::NUMCOLORS][5+1];
+    /* Cards all of whose copies are played or located (seen). */
+    Hanabi::CardMask locatedExhausted_;
+    Hanabi::CardMask eyesightExhausted_;
+    /* locatedExhausted_ as of the last time it was applied to every card,
+     * and whether a card has been drawn since then. */
+    Hanabi::CardMask sweptExhausted_;
+    bool drawnSinceSweep_;
+    /* Playable/valuable/worthless cards given server_'s piles and playedCount_;
+     * refreshed whenever either may have changed. */
+    Hanabi::BoardMasks board_;
+};
+
+static_assert(std::is_trivially_copyable<SmartBotState>::value,
+              "SmartBot clones by copying its state");
+
 struct Hint {
     int fitness;
     int to;
@@ -97,30 +168,21 @@ struct Hint {
 
 } // namespace SmartbotInternal
 
-class SmartBot final : public Hanabi::Bot {
+class SmartBot final : public Hanabi::Bot, private SmartBotInternal::SmartBotState {
     friend class SmartBotInternal::CardKnowledge;
 
-    const Hanabi::Server *server_;
-    int me_;
-    int myHandSize_;  /* purely for convenience */
-
-    /* What does each player know about his own hand? */
-    std::vector<std::vector<SmartBotInternal::CardKnowledge> > handKnowledge_;
-    /* What cards have been played so far? */
-    int playedCount_[Hanabi::NUMCOLORS][5+1];
-    /* What cards in players' hands are definitely identified?
-     * This table is recomputed every turn. */
-    int locatedCount_[Hanabi::NUMCOLORS][5+1];
-    /* What cards in players' hands are visible to me in particular?
-     * This table is recomputed every turn. */
-    int eyesightCount_[Hanabi::NUMCOLORS][5+1];
-
     bool isPlayable(Hanabi::Card card) const;
     bool isValuable(Hanabi::Card card) const;
     bool isWorthless(Hanabi::Card card) const;
 
+    void updateBoard();
+    Hanabi::CardMask exhaustedMask(const int8_t heldCount[Hanabi::NUMCOLORS][5+1]) const;
     void updateEyesightCount();
-    bool updateLocatedCount();
+    void updateExhausted(int color, int value);
+    void relocate(int player_index, int card_index);
+    void relocateHand(int player_index);
+    void sweepLocated();
+    void checkLocatedCount() const;
     void invalidateKnol(int player_index, int card_index, bool draw_new_card);
     void seePublicCard(const Hanabi::Card &played_card);
 
@@ -155,5 +217,8 @@ class SmartBot final : public Hanabi::Bot {
     void pleaseObserveAfterMove(const Hanabi::Server &) override;
     std::map<std::string, std::string> handKnowledgeToMap() override;
     void printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) override;
+    void writeHandKnowledge(const Hanabi::Server &server, const Hanabi::HandKnowledgeTensor &out) const override;
     SmartBot *clone() const override;
+    void saveState(std::string &buf) const override;
+    size_t restoreState(const char *data, size_t size) override;
 };
@@ -35,6 +35,8 @@ freely, subject to the following restrictions:
 
 #include <vector>
 #include <queue>
+#include <deque>
+#include <map>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -42,55 +44,368 @@ freely, subject to the following restrictions:
 #include <future>
 #include <functional>
 #include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdint>
+#include <tuple>
 #include <boost/fiber/all.hpp>
-#include <boost/thread/barrier.hpp>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 class AsyncModelWrapper;
 
+/* How ready fibers are distributed over the threads of a pool.
+ * SHARED: one FIFO queue per pool that every worker pops from.
+ * WORK_STEALING: one queue per worker; idle workers steal from the others. */
+enum class FiberScheduler { SHARED, WORK_STEALING };
+
+FiberScheduler parseFiberScheduler(const std::string &name);
+std::string fiberSchedulerName(FiberScheduler scheduler);
+
+struct ThreadPoolConfig {
+    ThreadPoolConfig(size_t threads=10) : threads(threads) {}
+
+    size_t threads;
+    FiberScheduler scheduler = FiberScheduler::SHARED;
+    // worker i is pinned to cores[i % cores.size()]; empty means no pinning
+    std::vector<int> cores;
+    // if true, idle workers sleep on a condition variable instead of spinning
+    bool suspend = false;
+};
+
+/* A snapshot of the pool counters. Queue depth counts fibers that are ready
+ * to run but not currently running; pending counts tasks submitted from
+ * outside the pool that no worker has picked up yet. */
+struct ThreadPoolStats {
+    size_t threads = 0;
+    std::string scheduler;
+    uint64_t enqueued = 0;
+    uint64_t completed = 0;
+    uint64_t steals = 0;
+    size_t pending = 0;
+    size_t running = 0;
+    size_t queueDepth = 0;
+    size_t maxQueueDepth = 0;
+};
+
+/* A pool of threads that execute fibers. Every pool has its own ready queues,
+ * so several pools (e.g. one per concurrent game) never share work. Tasks
+ * enqueued from one of the pool's own fibers are launched in place; tasks
+ * enqueued from any other thread are handed over to the workers. */
 class ThreadPool {
 public:
     ThreadPool(size_t);
+    ThreadPool(const ThreadPoolConfig &config);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
     template<class F, class... Args>
     auto enqueue(F&& f, Args&&... args)
         -> boost::fibers::future<typename std::result_of<F(Args...)>::type>;
     void close();
+    ThreadPoolStats stats() const;
+    const ThreadPoolConfig &config() const { return config_; }
+
+    /* The pool bound to the calling thread: set on the pool's own workers,
+     * or by a ThreadPoolScope. nullptr otherwise. */
+    static ThreadPool *&current();
+
+    /* TorchBot models served on this pool, keyed by (path, device, batch
+     * size, max delay, intra-op threads); see get_torchbot_async_module. A
+     * fiber mutex, since bots look them up from the pool's fibers. */
+    using ModelKey = std::tuple<std::string, std::string, int, int, int>;
+    std::map<ModelKey, std::shared_ptr<AsyncModelWrapper>> models; // hack
+    boost::fibers::mutex modelsMtx;
+    /* the last one loaded, for getInferenceStats() */
     std::shared_ptr<AsyncModelWrapper> model; // hack
 
-    bool stop;
+    std::atomic<bool> stop;
 private:
-    std::unique_ptr<boost::barrier> b;
+    class Scheduler;
+    struct Queue {
+        std::mutex mtx;
+        std::deque<boost::fibers::context *> ctxs;
+    };
+    struct Sleeper {
+        std::mutex mtx;
+        std::condition_variable cnd;
+        bool flag = false;
+        std::atomic<bool> sleeping{false};
+    };
+
+    // the pool whose worker the calling thread is, if any
+    static ThreadPool *&worker_();
+    void work_(size_t id);
+    void finished_();
+    void push_(size_t id, boost::fibers::context *ctx);
+    boost::fibers::context *pop_(size_t id);
+    void wakeIdle_(size_t from);
+
+    ThreadPoolConfig config_;
     // need to keep track of threads so we can join them
     std::vector< std::thread > workers;
-    // the task queue
+    // ready queues: one for SHARED, one per worker for WORK_STEALING
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::unique_ptr<Sleeper>> sleepers_;
+    // the task queue, fed by threads outside the pool
+    std::queue<std::function<void()>> tasks;
 
     // synchronization
-    std::mutex mtx;
+    mutable std::mutex mtx;
     boost::fibers::condition_variable_any condition;
+
+    // counters
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> steals_{0};
+    std::atomic<size_t> running_{0};
+    std::atomic<size_t> queueDepth_{0};
+    std::atomic<size_t> maxQueueDepth_{0};
 };
 
-// the constructor just launches some amount of workers
+/* Binds a pool to the calling thread for the lifetime of the scope, so that
+ * getThreadPool() (and therefore search) uses it instead of the default pool. */
+class ThreadPoolScope {
+public:
+    explicit ThreadPoolScope(ThreadPool *pool) : prev_(ThreadPool::current()) {
+        ThreadPool::current() = pool;
+    }
+    ~ThreadPoolScope() { ThreadPool::current() = prev_; }
+private:
+    ThreadPool *prev_;
+};
+
+/* Fiber scheduling algorithm installed on every worker of a pool. Pinned
+ * contexts (the worker's main and dispatcher fibers) never leave their
+ * thread; all other fibers go to the pool's queues. */
+class ThreadPool::Scheduler : public boost::fibers::algo::algorithm {
+public:
+    Scheduler(ThreadPool *pool, size_t id) : pool_(pool), id_(id) {}
+
+    void awakened(boost::fibers::context *ctx) noexcept override {
+        if (ctx->is_context(boost::fibers::type::pinned_context)) {
+            lqueue_.push_back(*ctx);
+        } else {
+            ctx->detach();
+            pool_->push_(id_, ctx);
+        }
+    }
+
+    boost::fibers::context *pick_next() noexcept override {
+        boost::fibers::context *ctx = pool_->pop_(id_);
+        if (ctx != nullptr) {
+            boost::fibers::context::active()->attach(ctx);
+        } else if (!lqueue_.empty()) {
+            ctx = &lqueue_.front();
+            lqueue_.pop_front();
+        }
+        return ctx;
+    }
+
+    bool has_ready_fibers() const noexcept override {
+        return pool_->queueDepth_ > 0 || !lqueue_.empty();
+    }
+
+    void suspend_until(std::chrono::steady_clock::time_point const &time_point) noexcept override {
+        if (!pool_->config_.suspend) return;
+        Sleeper &s = *pool_->sleepers_[id_];
+        std::unique_lock<std::mutex> lk(s.mtx);
+        // publish that we are about to sleep before looking at the queues,
+        // so that a concurrent push_ either is seen here or wakes us up
+        s.sleeping = true;
+        auto ready = [this, &s]{ return s.flag || pool_->queueDepth_ > 0; };
+        if (time_point == (std::chrono::steady_clock::time_point::max)()) {
+            s.cnd.wait(lk, ready);
+        } else {
+            s.cnd.wait_until(lk, time_point, ready);
+        }
+        s.sleeping = false;
+        s.flag = false;
+    }
+
+    void notify() noexcept override {
+        if (!pool_->config_.suspend) return;
+        Sleeper &s = *pool_->sleepers_[id_];
+        {
+            std::unique_lock<std::mutex> lk(s.mtx);
+            s.flag = true;
+        }
+        s.cnd.notify_all();
+    }
+
+private:
+    ThreadPool *pool_;
+    size_t id_;
+    boost::fibers::scheduler::ready_queue_type lqueue_;
+};
+
+inline FiberScheduler parseFiberScheduler(const std::string &name) {
+    if (name == "shared") return FiberScheduler::SHARED;
+    if (name == "work_stealing") return FiberScheduler::WORK_STEALING;
+    throw std::runtime_error("Unknown fiber scheduler '" + name + "' (expected 'shared' or 'work_stealing')");
+}
+
+inline std::string fiberSchedulerName(FiberScheduler scheduler) {
+    return scheduler == FiberScheduler::SHARED ? "shared" : "work_stealing";
+}
+
+inline ThreadPool *&ThreadPool::current() {
+    thread_local ThreadPool *pool = nullptr;
+    return pool;
+}
+
+inline ThreadPool *&ThreadPool::worker_() {
+    thread_local ThreadPool *pool = nullptr;
+    return pool;
+}
+
 inline ThreadPool::ThreadPool(size_t threads)
-    :   stop(false)
+    :   ThreadPool(ThreadPoolConfig(threads))
 {
-    b.reset(new boost::barrier(threads + 1));
-    for (size_t i = 0;i<threads;++i) {
-        workers.emplace_back(
-            [this]
+}
+
+// the constructor just launches some amount of workers
+inline ThreadPool::ThreadPool(const ThreadPoolConfig &config)
+    :   stop(false), config_(config)
+{
+    if (config_.threads == 0)
+        throw std::runtime_error("ThreadPool needs at least one thread");
+    size_t num_queues = config_.scheduler == FiberScheduler::SHARED ? 1 : config_.threads;
+    for (size_t i = 0; i < num_queues; ++i) {
+        queues_.emplace_back(new Queue());
+    }
+    for (size_t i = 0; i < config_.threads; ++i) {
+        sleepers_.emplace_back(new Sleeper());
+    }
+    for (size_t i = 0; i < config_.threads; ++i) {
+        workers.emplace_back([this, i]{ this->work_(i); });
+#ifdef __linux__
+        if (!config_.cores.empty()) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(config_.cores[i % config_.cores.size()], &cpuset);
+            pthread_setaffinity_np(workers.back().native_handle(), sizeof(cpu_set_t), &cpuset);
+        }
+#endif
+    }
+}
+
+inline ThreadPool::~ThreadPool()
+{
+    if (!workers.empty())
+        close();
+}
+
+inline void ThreadPool::work_(size_t id)
+{
+    boost::fibers::use_scheduling_algorithm<Scheduler>(this, id);
+    worker_() = this;
+    current() = this;
+    // the main fiber of each worker moves submitted tasks into fibers; while
+    // it waits, the scheduler runs the pool's fibers on this thread
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->condition.wait(lock,
+                [this]{ return this->stop || !this->tasks.empty(); });
+            if (this->tasks.empty())
+                break;
+            task = std::move(this->tasks.front());
+            this->tasks.pop();
+        }
+        boost::fibers::fiber(boost::fibers::launch::post, std::move(task)).detach();
+    }
+    // drain: keep running fibers until every task has completed
+    std::unique_lock<std::mutex> lock(this->mtx);
+    this->condition.wait(lock, [this]{ return this->running_ == 0; });
+}
+
+inline void ThreadPool::finished_()
+{
+    completed_++;
+    if (--running_ == 0 && stop) {
+        { std::unique_lock<std::mutex> lock(mtx); }
+        condition.notify_all();
+    }
+}
+
+inline void ThreadPool::push_(size_t id, boost::fibers::context *ctx)
+{
+    Queue &q = *queues_[queues_.size() == 1 ? 0 : id];
+    size_t depth;
+    {
+        std::unique_lock<std::mutex> lock(q.mtx);
+        q.ctxs.push_back(ctx);
+        depth = ++queueDepth_;
+    }
+    size_t max_depth = maxQueueDepth_;
+    while (depth > max_depth && !maxQueueDepth_.compare_exchange_weak(max_depth, depth)) {}
+    wakeIdle_(id);
+}
+
+inline boost::fibers::context *ThreadPool::pop_(size_t id)
+{
+    if (queues_.size() == 1) {
+        Queue &q = *queues_[0];
+        std::unique_lock<std::mutex> lock(q.mtx);
+        if (q.ctxs.empty()) return nullptr;
+        boost::fibers::context *ctx = q.ctxs.front();
+        q.ctxs.pop_front();
+        --queueDepth_;
+        return ctx;
+    }
+    // own queue first (FIFO), then steal from the back of the others
+    {
+        Queue &q = *queues_[id];
+        std::unique_lock<std::mutex> lock(q.mtx);
+        if (!q.ctxs.empty()) {
+            boost::fibers::context *ctx = q.ctxs.front();
+            q.ctxs.pop_front();
+            --queueDepth_;
+            return ctx;
+        }
+    }
+    if (queueDepth_ == 0) return nullptr;
+    thread_local std::minstd_rand gen{std::random_device{}()};
+    size_t n = queues_.size();
+    size_t start = gen() % n;
+    for (size_t k = 0; k < n; ++k) {
+        size_t victim = (start + k) % n;
+        if (victim == id) continue;
+        Queue &q = *queues_[victim];
+        std::unique_lock<std::mutex> lock(q.mtx);
+        if (!q.ctxs.empty()) {
+            boost::fibers::context *ctx = q.ctxs.back();
+            q.ctxs.pop_back();
+            --queueDepth_;
+            steals_++;
+            return ctx;
+        }
+    }
+    return nullptr;
+}
+
+inline void ThreadPool::wakeIdle_(size_t from)
+{
+    if (!config_.suspend) return;
+    size_t n = sleepers_.size();
+    for (size_t k = 1; k <= n; ++k) {
+        Sleeper &s = *sleepers_[(from + k) % n];
+        if (s.sleeping) {
             {
-                boost::fibers::use_scheduling_algorithm< boost::fibers::algo::shared_work >();
-                this->b->wait();
-                while(true) {
-                    std::unique_lock<std::mutex> lock(this->mtx);
-                    this->condition.wait(lock,
-                        [this]{ return this->stop; });
-                    if(this->stop)
-                        return;
-                }
+                std::unique_lock<std::mutex> lock(s.mtx);
+                s.flag = true;
             }
-        );
+            s.cnd.notify_one();
+            return;
+        }
     }
-    boost::fibers::use_scheduling_algorithm< boost::fibers::algo::shared_work >();
-    b->wait();
 }
 
 // add new work item to the pool
@@ -98,17 +413,39 @@ template<class F, class... Args>
 auto ThreadPool::enqueue(F&& f, Args&&... args)
     -> boost::fibers::future<typename std::result_of<F(Args...)>::type>
 {
+    using return_type = typename std::result_of<F(Args...)>::type;
     if(stop)
         throw std::runtime_error("enqueue on stopped ThreadPool");
-    auto res = boost::fibers::async(
+    auto task = std::make_shared< boost::fibers::packaged_task<return_type()> >(
       std::bind(std::forward<F>(f), std::forward<Args>(args)...)
     );
+    boost::fibers::future<return_type> res = task->get_future();
+    std::function<void()> job = [this, task]{ (*task)(); this->finished_(); };
+    enqueued_++;
+    running_++;
+    if (worker_() == this) {
+        boost::fibers::fiber(boost::fibers::launch::post, std::move(job)).detach();
+    } else {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if(stop) {
+                running_--;
+                throw std::runtime_error("enqueue on stopped ThreadPool");
+            }
+            tasks.emplace(std::move(job));
+        }
+        condition.notify_one();
+    }
     return res;
 }
 
 inline void ThreadPool::close()
 {
-    model.reset();
+    {
+        std::unique_lock<boost::fibers::mutex> lock(modelsMtx);
+        models.clear();
+    }
+    std::atomic_store(&model, std::shared_ptr<AsyncModelWrapper>());
     {
         std::unique_lock<std::mutex> lock(mtx);
         stop = true;
@@ -116,6 +453,25 @@ inline void ThreadPool::close()
     condition.notify_all();
     for(std::thread &worker: workers)
         worker.join();
+    workers.clear();
+}
+
+inline ThreadPoolStats ThreadPool::stats() const
+{
+    ThreadPoolStats s;
+    s.threads = config_.threads;
+    s.scheduler = fiberSchedulerName(config_.scheduler);
+    s.enqueued = enqueued_;
+    s.completed = completed_;
+    s.steals = steals_;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        s.pending = tasks.size();
+    }
+    s.running = running_;
+    s.queueDepth = queueDepth_;
+    s.maxQueueDepth = maxQueueDepth_;
+    return s;
 }
 
 
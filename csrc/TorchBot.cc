@@ -14,7 +14,6 @@
 #include <torch/csrc/autograd/grad_mode.h>
 
 using namespace Hanabi;
-using namespace TorchBotParams;
 
 static void _registerBots() {
   std::cout << "Registering torchbots..." << std::endl;
@@ -45,12 +44,41 @@ torch::jit::script::Module get_torchbot_module(const std::string &path) {
 }
 
 
-std::shared_ptr<AsyncModelWrapper> get_torchbot_async_module(const std::string &path) {
+static const std::string &resolve_torchbot_device(const std::string &device) {
+  if (device != "auto") {
+    return device;
+  }
+  // probing cuda is slow, so do it once
+  static const std::string autoDevice = torch::cuda::is_available() ? "cuda:0" : "cpu";
+  return autoDevice;
+}
+
+/* The pool's model for these params, loaded on first use. Every bot looks
+ * it up once and its clones share it (see TorchBot::model_), so runs that
+ * mix configs keep one model per config instead of reloading. */
+std::shared_ptr<AsyncModelWrapper> get_torchbot_async_module(const TorchBotParams::Config &params) {
   auto &tp = getThreadPool();
-  if (!tp.model) {
-    tp.model = std::make_shared<AsyncModelWrapper>(path, "cuda:0", 400);
+  const std::string &device = resolve_torchbot_device(params.TORCHBOT_DEVICE);
+  ThreadPool::ModelKey key(params.TORCHBOT_MODEL, device, params.TORCHBOT_BATCH_SIZE,
+                           params.TORCHBOT_MAX_DELAY_US, params.TORCHBOT_INTRAOP_THREADS);
+  std::unique_lock<boost::fibers::mutex> lock(tp.modelsMtx);
+  auto &model = tp.models[key];
+  if (!model) {
+    model = std::make_shared<AsyncModelWrapper>(
+      params.TORCHBOT_MODEL, device, params.TORCHBOT_BATCH_SIZE,
+      params.TORCHBOT_MAX_DELAY_US, params.TORCHBOT_INTRAOP_THREADS);
+    std::atomic_store(&tp.model, model);
   }
-  return tp.model;
+  return model;
+}
+
+bool getInferenceStats(const ThreadPool &pool, InferenceStats *stats) {
+  auto model = std::atomic_load(&pool.model);
+  if (!model) {
+    return false;
+  }
+  *stats = model->stats();
+  return true;
 }
 
 // std::shared_ptr<torch::jit::IValue> vec_to_tuple(std::vector<c10::IValue> vec) {
@@ -59,17 +87,34 @@ std::shared_ptr<AsyncModelWrapper> get_torchbot_async_module(const std::string &
 // }
 
 
-TensorDict make_init_hx() {
-  static TensorDict init_hx = {
+static const InputShapes &hidden_state_layout() {
+  static const InputShapes layout = {
     // num_layer, hid_dim
-    {"h0", torch::zeros({2, 512})},  // TODO: ugly hard-coding
-    {"c0", torch::zeros({2, 512})},  // TODO: ugly hard-coding
+    {"h0", {2, 512}},  // TODO: ugly hard-coding
+    {"c0", {2, 512}},  // TODO: ugly hard-coding
   };
-  return init_hx;
-  // std::vector<c10::IValue> init_hx_vec;
-  // init_hx_vec.push_back(torch::zeros({1}));
-  // init_hx_vec.push_back(torch::zeros({1}));
-  // return vec_to_tuple(init_hx_vec);
+  return layout;
+}
+
+/* one pool per dtype, shared by every TorchBot in the process */
+static std::shared_ptr<HiddenStatePool> get_hidden_state_pool(const std::string &dtype, bool create=true) {
+  static std::mutex mtx;
+  static std::map<std::string, std::shared_ptr<HiddenStatePool>> pools;
+  std::lock_guard<std::mutex> lock(mtx);
+  auto &pool = pools[dtype];
+  if (!pool && create) {
+    pool = std::make_shared<HiddenStatePool>(hidden_state_layout(), dtype);
+  }
+  return pool;
+}
+
+bool getHiddenStateStats(const std::string &dtype, HiddenStateStats *stats) {
+  auto pool = get_hidden_state_pool(dtype, false);
+  if (!pool) {
+    return false;
+  }
+  *stats = pool->stats();
+  return true;
 }
 
 void softmax_(float* model_output, const std::vector<Move> &legal_moves, const Server &server) {
@@ -96,22 +141,26 @@ void softmax_(float* model_output, const std::vector<Move> &legal_moves, const S
 }
 
 // NOTE(hengyuan): somehow static does not work
-// static TensorDict init_hx = make_init_hx();
 
 TorchBot::TorchBot(int index, int numPlayers, int handSize)
-    : me_(index), numPlayers_(numPlayers), handSize_(handSize)
+    : TorchBot(index, numPlayers, handSize,
+               std::make_shared<const TorchBotParams::Config>(RunParams::current().torch))
+{
+}
+
+TorchBot::TorchBot(int index, int numPlayers, int handSize, std::shared_ptr<const TorchBotParams::Config> params)
+    : me_(index), numPlayers_(numPlayers), handSize_(handSize), params_(params)
 {
     // assert(index == 1); // we're only training TorchBot agents for player 1, this is a sanity check
     last_move_ = Move(INVALID_MOVE, 0);
     // inner_ = std::shared_ptr<SmartBot>(new SmartBot(index, numPlayers, handSize));
     // inner_->setPermissive(true);
-    if(TORCHBOT_MODEL == "") {
+    if(params_->TORCHBOT_MODEL == "") {
       throw std::runtime_error("TORCHBOT_MODEL must be specified");
     }
 
-    // just store a copy of the static value to save memory
-    // hx_ = init_hx;
-    hx_ = make_init_hx();
+    // hx_ starts as nullptr, i.e. the all-zeros initial state
+    hxPool_ = get_hidden_state_pool(params_->TORCHBOT_HIDDEN_DTYPE);
 
     // if (TORCHBOT_SAMPLE) {
     //   infosetHash_.reset(new InfosetHash(0)); // FIXME: seed?
@@ -309,33 +358,23 @@ torch::Tensor TorchBot::applyModel(const HleSerializedMove &frame) {
   // be careful not to run in parallel model, it sucks!
   // assert(omp_get_num_threads() == 1 || (!omp_get_nested() && omp_in_parallel()));
 
-  std::vector<float> frame_vec = frame.toArray();
-  // std::cout << ">>>applying: " << me_ << std::endl;
-
-  auto feats = torch::zeros({(long int) frame_vec.size()});
-  auto feat_data = feats.data<float>();
-  for (size_t i = 0; i < frame_vec.size(); i++) {
-    if (frame_vec[i] != frame_vec[i]) { // NaN
-      std::cerr << "input data " << i << " = " << frame_vec[i] << std::endl;
-      throw std::runtime_error("Inputs are NaN");
-    }
-    feat_data[i] = frame_vec[i];
+  // the features and hidden state are written straight into our slot of the batch
+  InputShapes shapes = {{"s", {(int64_t) frame.size()}}};
+  shapes.insert(shapes.end(), hxPool_->layout().begin(), hxPool_->layout().end());
+  if (!model_) {
+    model_ = get_torchbot_async_module(*params_);
   }
-  // std::vector<torch::jit::IValue> inputs;
-  // inputs.push_back(feats);
-  // inputs.push_back(*hx_);
-
-  // Execute the model and turn its output into a tensor.
-  // std::cerr << "Got NN input of size" << feats.sizes() << std::endl;
-  // std::vector<torch::jit::IValue> outputs = get_torchbot_module(TorchBotParams::TORCHBOT_MODEL).forward(inputs).toTuple()->elements();
-  // assert(outputs.size() == 2);
-  // at::Tensor output = outputs[0].toTensor();
-  // std::cerr << "Got NN output of size " << output.sizes() << std::endl;
-  // hx_ = std::make_shared<torch::jit::IValue>(outputs[1]);
-
-  TensorDict input = hx_;
-  input["s"] = feats;
-  auto output = get_torchbot_async_module(TorchBotParams::TORCHBOT_MODEL)->forward(input);
+  auto output = model_->forward(shapes, [&](TensorDict &inputs) {
+    auto feat_data = inputs["s"].data<float>();
+    frame.writeTo(feat_data);
+    for (size_t i = 0; i < frame.size(); i++) {
+      if (feat_data[i] != feat_data[i]) { // NaN
+        std::cerr << "input data " << i << " = " << feat_data[i] << std::endl;
+        throw std::runtime_error("Inputs are NaN");
+      }
+    }
+    hxPool_->load(hx_, inputs);
+  });
   // {
   //   auto output_data = output.data<float>();
   //   for (size_t i = 0; i < 20; i++) {
@@ -350,7 +389,7 @@ torch::Tensor TorchBot::applyModel(const HleSerializedMove &frame) {
   assert(afind != output.end());
   auto action = afind->second;
   output.erase(afind);
-  hx_ = std::move(output);
+  hx_ = hxPool_->store(output);
 
   return action;
 }
@@ -379,16 +418,15 @@ void TorchBot::pleaseMakeMove(Server &server)
 }
 
 TorchBot *TorchBot::clone() const {
-  TorchBot *b = new TorchBot(me_, numPlayers_, handSize_);
+  TorchBot *b = new TorchBot(me_, numPlayers_, handSize_, params_);
   b->frame_idx_ = this->frame_idx_;
+  b->model_ = this->model_;
 
   // b->simulserver_->sync(*this->simulserver_);
   // b->inner_.reset(this->inner_->clone());
 
-  // n.b. we're taking a shortcut here to save memory, and copying hx_ by reference.
-  // this works because the value of the hx_ tensors is never modified, only overwritten
-  // by a new one! Unfortunately const doens't really enforce this because I can only
-  // apply it on the IValue wrapper, not the tensor itself
+  // hidden states are immutable, so clones share ours until they run the model
+  b->hxPool_ = this->hxPool_;
   b->hx_ = this->hx_;
 
   // this is copy-by-value, but maybe be more explicit just in case
@@ -417,5 +455,11 @@ TorchBot *TorchBot::clone() const {
   return b;
 }
 
+size_t TorchBot::memoryBytes() const {
+  // hx_ lives in the HiddenStatePool, which is accounted for separately
+  return sizeof(*this) + hand_distribution_v0_.capacity() * sizeof(FactorizedBeliefs)
+         + action_probs_.size() * (4 * sizeof(void *) + sizeof(std::pair<const int, float>));
+}
+
 const std::map<int, float> &TorchBot::getActionProbs() const { return action_probs_; }
 void TorchBot::setActionUncertainty(float action_unc) { action_unc_ = action_unc; }
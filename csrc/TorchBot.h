@@ -13,28 +13,25 @@
 #include "HleUtils.h"
 #include "SmartBot.h"
 #include "AsyncModelWrapper.h"
+#include "HiddenStatePool.h"
 
 #include <torch/script.h> // One-stop header.
 #include <torch/torch.h>
 #include <torch/csrc/autograd/grad_mode.h>
 
 
-namespace TorchBotParams {
-
-  const std::string TORCHBOT_MODEL = Params::getParameterString("TORCHBOT_MODEL", "",
-    "File path to the TorchBot model, saved as serialized TorchScript (required for TorchBot)");
-
-} /* namespace TorchBotParams */
-
-
 class TorchBot final : public Hanabi::Bot {
     int me_, numPlayers_, handSize_;
+    // shared by all clones, which may number in the millions
+    std::shared_ptr<const TorchBotParams::Config> params_;
     int frame_idx_ = 0;
 
     // std::shared_ptr<SimulServer> simulserver_;
     // std::shared_ptr<Bot> inner_;
-    TensorDict hx_;
-    // std::shared_ptr<torch::jit::IValue> hx_;
+    std::shared_ptr<HiddenStatePool> hxPool_;
+    /* looked up on the first inference, and shared with our clones */
+    std::shared_ptr<AsyncModelWrapper> model_;
+    HiddenStatePool::Handle hx_;
     std::vector<FactorizedBeliefs> hand_distribution_v0_;
 
     /* keep track when a partner plays/discards, so that I can update
@@ -69,6 +66,7 @@ class TorchBot final : public Hanabi::Bot {
 
   public:
     TorchBot(int index, int numPlayers, int handSize);
+    TorchBot(int index, int numPlayers, int handSize, std::shared_ptr<const TorchBotParams::Config> params);
     void pleaseObserveBeforeMove(const Hanabi::Server &) override;
     void pleaseMakeMove(Hanabi::Server &) override;
       void pleaseObserveBeforeDiscard(const Hanabi::Server &, int from, int card_index) override;
@@ -79,4 +77,5 @@ class TorchBot final : public Hanabi::Bot {
     const std::map<int, float> &getActionProbs() const override;
     void setActionUncertainty(float boltzmann_unc) override;
     TorchBot *clone() const override;
+    size_t memoryBytes() const override;
 };
@@ -0,0 +1,186 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include "Tournament.h"
+#include "BotUtils.h"
+#include "SearchBot.h"
+
+using namespace Hanabi;
+
+std::pair<double, double> meanAndStandardError(const std::vector<double> &xs) {
+  const size_t n = xs.size();
+  if (n == 0) return std::make_pair(0., 0.);
+  double sum = 0;
+  for (double x : xs) sum += x;
+  const double mean = sum / n;
+  if (n == 1) return std::make_pair(mean, 0.);
+  double squares = 0;
+  for (double x : xs) squares += (x - mean) * (x - mean);
+  return std::make_pair(mean, std::sqrt(squares / (n - 1) / n));
+}
+
+namespace {
+
+std::vector<double> asDoubles(const std::vector<int> &scores) {
+  return std::vector<double>(scores.begin(), scores.end());
+}
+
+/* SearchBot searches only in the search seat, and would play any other as
+ * BPBOT; every other bot plays the row from seat 0. */
+int rowSeat(const std::string &row, int players, const SearchBotParams::Config &params) {
+  if (row == "SearchBot") {
+    for (int i = 0; i < players; ++i) {
+      if (isSearchSeat(i, players, params)) return i;
+    }
+  }
+  return 0;
+}
+
+/* Plays games [begin, end) of a pairing with params, on a server of its own. */
+void playGames(const TournamentSpec &spec, const RunParams &params, PairingResult *pairing,
+               int begin, int end) {
+  std::vector<std::string> lineup(spec.players, pairing->col);
+  lineup[rowSeat(pairing->row, spec.players, params.search)] = pairing->row;
+  long bombs = 0;
+  playLineupGames(lineup, params, spec.seed, begin, end, [&](int g, int score, const Server &server) {
+    pairing->scores[g] = score;
+    bombs += (server.mulligansRemaining() == 0);
+  });
+  /* the pairing's other chunks run on other threads */
+  static std::mutex mtx;
+  std::lock_guard<std::mutex> lock(mtx);
+  pairing->bombs += bombs;
+}
+
+}  // namespace
+
+std::vector<std::string> defaultTournamentBots() {
+  /* the searchers hold millions of hands per game, which adds up over a
+   * pool's worth of concurrent games, and TorchBot needs a model */
+  static const std::set<std::string> excluded = {"SearchBot", "JointSearchBot", "TorchBot"};
+  std::vector<std::string> bots;
+  for (const auto &name : getBotNames()) {
+    if (!excluded.count(name)) bots.push_back(name);
+  }
+  return bots;
+}
+
+double PairingResult::mean() const {
+  return meanAndStandardError(asDoubles(scores)).first;
+}
+
+double PairingResult::standardError() const {
+  return meanAndStandardError(asDoubles(scores)).second;
+}
+
+std::pair<double, double> TournamentResult::pairedDifference(int a, int b, int c, int d) const {
+  const auto &x = pairings.at(a).at(b).scores;
+  const auto &y = pairings.at(c).at(d).scores;
+  if (x.size() != y.size()) {
+    throw std::runtime_error("Paired pairings must have played the same games");
+  }
+  std::vector<double> diffs(x.size());
+  for (size_t g = 0; g < x.size(); ++g) {
+    diffs[g] = x[g] - y[g];
+  }
+  return meanAndStandardError(diffs);
+}
+
+std::string TournamentResult::table() const {
+  size_t width = 10;
+  for (const auto &bot : bots) width = std::max(width, bot.size() + 2);
+  std::ostringstream out;
+  out << std::setw(width) << "seat 0 \\";
+  for (const auto &bot : bots) out << std::setw(width + 4) << bot;
+  out << "\n" << std::fixed << std::setprecision(2);
+  for (int r = 0; r < bots.size(); ++r) {
+    out << std::setw(width) << bots[r];
+    for (int c = 0; c < bots.size(); ++c) {
+      const PairingResult &p = pairings[r][c];
+      if (p.scores.empty()) {
+        out << std::setw(width + 4) << "-";
+      } else {
+        std::ostringstream cell;
+        cell << std::fixed << std::setprecision(2) << p.mean() << "+-" << p.standardError();
+        out << std::setw(width + 4) << cell.str();
+      }
+    }
+    out << "\n";
+  }
+  return out.str();
+}
+
+std::string TournamentResult::toJson() const {
+  std::ostringstream out;
+  out << "{\"seconds\": " << seconds << ", \"bots\": [";
+  for (int i = 0; i < bots.size(); ++i) {
+    out << (i ? ", " : "") << "\"" << bots[i] << "\"";
+  }
+  out << "], \"pairings\": [";
+  bool first = true;
+  for (const auto &row : pairings) {
+    for (const auto &p : row) {
+      if (p.scores.empty()) continue;
+      out << (first ? "" : ", ") << "{\"row\": \"" << p.row << "\", \"col\": \"" << p.col
+          << "\", \"games\": " << p.scores.size() << ", \"mean\": " << p.mean()
+          << ", \"stderr\": " << p.standardError() << ", \"bombs\": " << p.bombs << "}";
+      first = false;
+    }
+  }
+  out << "]}";
+  return out.str();
+}
+
+TournamentResult runTournament(const TournamentSpec &spec) {
+  const auto start = std::chrono::steady_clock::now();
+  if (spec.games <= 0 || spec.players < 2) {
+    throw std::runtime_error("A tournament needs games and at least 2 players");
+  }
+  TournamentResult result;
+  result.bots = spec.bots.empty() ? defaultTournamentBots() : spec.bots;
+  const int n = result.bots.size();
+  result.pairings.assign(n, std::vector<PairingResult>(n));
+  std::vector<PairingResult*> played;
+  for (int r = 0; r < n; ++r) {
+    for (int c = 0; c < n; ++c) {
+      PairingResult &p = result.pairings[r][c];
+      p.row = result.bots[r];
+      p.col = result.bots[c];
+      getBotFactory(p.row);  /* unknown bots fail here, not on the pool */
+      if (r == c && !spec.selfPlay) continue;
+      p.scores.assign(spec.games, 0);
+      played.push_back(&p);
+    }
+  }
+
+  /* enough chunks to keep every pool thread busy, each on its own server */
+  const int threads = getThreadPool().config().threads;
+  const int chunks = std::max(1, std::min(spec.games, (threads + int(played.size()) - 1) / std::max<int>(1, played.size())));
+  RunParams params = RunParams::current();
+  std::vector<boost::fibers::future<void>> futures;
+  for (PairingResult *p : played) {
+    for (int c = 0; c < chunks; ++c) {
+      const int begin = c * spec.games / chunks;
+      const int end = (c + 1) * spec.games / chunks;
+      futures.push_back(getThreadPool().enqueue([&, p, begin, end]() {
+        playGames(spec, params, p, begin, end);
+      }));
+    }
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
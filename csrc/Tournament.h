@@ -0,0 +1,61 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* A round robin of ordered bot pairings: in the games of (row, col), seat 0
+ * is row and the other seats are col, except that a SearchBot row plays the
+ * seat that searches (see isSearchSeat()). Game g of every pairing is dealt
+ * the same deck, Server::shuffledDeck(seed + g) as in compareLineups() (see
+ * playLineupGames()), so that pairings can be compared game by game. */
+struct TournamentSpec {
+  std::vector<std::string> bots;   // empty: defaultTournamentBots()
+  int games = 1000;                // per pairing
+  int players = 2;
+  int seed = 1;
+  bool selfPlay = true;            // also row == col
+};
+
+struct PairingResult {
+  std::string row;
+  std::string col;
+  std::vector<int> scores;         // of game g, dealt with seed + g
+  long bombs = 0;
+
+  double mean() const;
+  /* of the mean */
+  double standardError() const;
+};
+
+struct TournamentResult {
+  std::vector<std::string> bots;
+  /* [row][col]; empty scores for the pairings that were not played */
+  std::vector<std::vector<PairingResult>> pairings;
+  double seconds = 0;
+
+  /* Mean and standard error of the score of pairing (a, b) minus that of
+   * (c, d), game by game: the shared decks make it much tighter than the
+   * difference of the two means. */
+  std::pair<double, double> pairedDifference(int a, int b, int c, int d) const;
+  /* The score matrix, "mean +- stderr" per pairing. */
+  std::string table() const;
+  std::string toJson() const;
+};
+
+/* Mean of xs and its standard error. */
+std::pair<double, double> meanAndStandardError(const std::vector<double> &xs);
+
+/* The registered bots, but for the search bots and TorchBot. */
+std::vector<std::string> defaultTournamentBots();
+
+/* Plays every pairing of spec, spread over the fiber thread pool (see
+ * getThreadPool()) with the caller's RunParams. */
+TournamentResult runTournament(const TournamentSpec &spec);
@@ -0,0 +1,116 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <zlib.h>
+#include "TranscriptWriter.h"
+
+namespace Hanabi {
+
+GzipTranscriptWriter::GzipTranscriptWriter(const std::string &prefix, int gamesPerShard, int level) :
+    TextTranscriptObserver(&text_, &text_),
+    prefix_(prefix),
+    gamesPerShard_(gamesPerShard),
+    zs_(new z_stream_s()),
+    out_(1 << 16)
+{
+    if (gamesPerShard_ <= 0) {
+        throw std::runtime_error("gamesPerShard must be positive");
+    }
+    /* windowBits 15 + 16: a gzip header and trailer around each game */
+    if (deflateInit2(zs_.get(), level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed for level " + std::to_string(level));
+    }
+}
+
+GzipTranscriptWriter::~GzipTranscriptWriter()
+{
+    try {
+        close();
+    } catch (const std::exception &e) {
+        std::cerr << "GzipTranscriptWriter: " << e.what() << std::endl;
+    }
+    deflateEnd(zs_.get());
+}
+
+void GzipTranscriptWriter::close()
+{
+    if (shard_.is_open()) {
+        shard_.close();
+        index_.close();
+    }
+    gamesInShard_ = 0;
+}
+
+void GzipTranscriptWriter::onDeal(const Server &server)
+{
+    text_.str("");
+    TextTranscriptObserver::onDeal(server);
+}
+
+void GzipTranscriptWriter::onGameEnd(const Server &server, int score)
+{
+    TextTranscriptObserver::onGameEnd(server, score);
+    write(text_.str(), score);
+    text_.str("");
+}
+
+void GzipTranscriptWriter::openShard_()
+{
+    if (shard_.is_open()) {
+        shard_.close();
+        index_.close();
+    }
+    char number[16];
+    snprintf(number, sizeof(number), "-%05d", int(shards_.size()));
+    const std::string path = prefix_ + number;
+    shard_.open(path + ".txt.gz", std::ios::binary);
+    index_.open(path + ".idx");
+    if (!shard_ || !index_) {
+        throw std::runtime_error("Could not open " + path + ".txt.gz");
+    }
+    shards_.push_back(path + ".txt.gz");
+    offset_ = 0;
+    gamesInShard_ = 0;
+}
+
+void GzipTranscriptWriter::write(const std::string &text, int score)
+{
+    if (!shard_.is_open() || gamesInShard_ == gamesPerShard_) {
+        openShard_();
+    }
+
+    deflateReset(zs_.get());
+    zs_->next_in = (Bytef *)text.data();
+    zs_->avail_in = text.size();
+    size_t length = 0;
+    int ret;
+    do {
+        zs_->next_out = (Bytef *)out_.data();
+        zs_->avail_out = out_.size();
+        ret = deflate(zs_.get(), Z_FINISH);
+        if (ret == Z_STREAM_ERROR) {
+            throw std::runtime_error("deflate failed");
+        }
+        const size_t n = out_.size() - zs_->avail_out;
+        shard_.write(out_.data(), n);
+        length += n;
+    } while (ret != Z_STREAM_END);
+    if (!shard_) {
+        throw std::runtime_error("Could not write " + shards_.back());
+    }
+
+    index_ << offset_ << " " << length << " " << score << "\n";
+    offset_ += length;
+    gamesInShard_ += 1;
+    games_ += 1;
+    textBytes_ += text.size();
+    compressedBytes_ += length;
+}
+
+}  /* namespace Hanabi */
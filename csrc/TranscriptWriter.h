@@ -0,0 +1,68 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ServerObserver.h"
+
+struct z_stream_s;
+
+namespace Hanabi {
+
+/* Writes the text transcript of every game (see TextTranscriptObserver),
+ * "Start game" line included, to gzip shards <prefix>-00000.txt.gz,
+ * <prefix>-00001.txt.gz, ... of at most gamesPerShard games. Each game is
+ * a gzip member of its own, so a shard is an ordinary .gz file (zcat gives
+ * the same log as eval_bot on stderr) and any game can be inflated alone:
+ * <prefix>-00000.idx has a line "offset length score" per game of the
+ * shard. A game is compressed and written when it ends (see
+ * ServerObserver::onGameEnd()); one abandoned before its end is dropped. */
+class GzipTranscriptWriter : public TextTranscriptObserver {
+public:
+    GzipTranscriptWriter(const std::string &prefix, int gamesPerShard=100000, int level=6);
+    ~GzipTranscriptWriter();
+    GzipTranscriptWriter(const GzipTranscriptWriter &) = delete;
+    GzipTranscriptWriter &operator=(const GzipTranscriptWriter &) = delete;
+
+    /* Closes the current shard. */
+    void close();
+
+    /* Writes the transcript of a game that was not observed, e.g. one
+     * kept by generateDataset(). */
+    void write(const std::string &text, int score);
+
+    const std::vector<std::string> &shards() const { return shards_; }
+    long games() const { return games_; }
+    size_t textBytes() const { return textBytes_; }
+    size_t compressedBytes() const { return compressedBytes_; }
+
+    void onDeal(const Server &server) override;
+    void onGameEnd(const Server &server, int score) override;
+
+private:
+    void openShard_();
+
+    std::string prefix_;
+    int gamesPerShard_;
+    std::ostringstream text_;
+    std::unique_ptr<z_stream_s> zs_;
+    std::vector<char> out_;
+    std::ofstream shard_;
+    std::ofstream index_;
+    std::vector<std::string> shards_;
+    size_t offset_ = 0;
+    int gamesInShard_ = 0;
+    long games_ = 0;
+    size_t textBytes_ = 0;
+    size_t compressedBytes_ = 0;
+};
+
+}  /* namespace Hanabi */
@@ -4,6 +4,7 @@
 #include "Hanabi.h"
 #include "BotFactory.h"
 #include "ValueBot.h"
+#include "CardMask.h"
 
 using namespace Hanabi;
 using namespace ValueB;
@@ -541,3 +542,24 @@ std::map<std::string, std::string> ValueBot::handKnowledgeToMap() {
 void ValueBot::printHandKnowledge(const std::map<std::string, std::string>& knowledgeMap) {
 
 }
+
+void ValueBot::writeHandKnowledge(const Server &server, const HandKnowledgeTensor &out) const {
+    const BoardMasks board = BoardMasks::compute(server);
+    for (int p = 0; p < (int)handKnowledge_.size(); ++p) {
+        for (int i = 0; i < (int)handKnowledge_[p].size(); ++i) {
+            const CardKnowledge &knol = handKnowledge_[p][i];
+            /* ValueBot tracks colors and values separately */
+            CardMask colors, values;
+            for (Color k = RED; k <= BLUE; ++k) {
+                if (!knol.cannotBe(k)) colors |= CardMask::ofColor(k);
+            }
+            for (int v = 1; v <= 5; ++v) {
+                if (!knol.cannotBe(Value(v))) values |= CardMask::ofValue(v);
+            }
+            writeCardKnowledge(out, p, i, colors & values, board);
+            if (knol.isPlayable) out.at(p, i, KNOWLEDGE_PLAYABLE) = KNOWLEDGE_YES;
+            if (knol.isValuable) out.at(p, i, KNOWLEDGE_VALUABLE) = KNOWLEDGE_YES;
+            if (knol.isWorthless) out.at(p, i, KNOWLEDGE_WORTHLESS) = KNOWLEDGE_YES;
+        }
+    }
+}
@@ -7,13 +7,27 @@
 #include <tuple>
 #include <torch/extension.h>
 #include <ctime>
+#include <chrono>
+#include <sstream>
 
 #include "BotFactory.h"
 #include "PyBot.h"
 #include "SearchBot.h"
+#include "Replay.h"
+#include "HanabiEnv.h"
+#include "InferenceStats.h"
+#include "Benchmark.h"
+#include "EvalBot.h"
+#include "Dataset.h"
+#include "Tournament.h"
+#include "Comparison.h"
+#include "MemoryStats.h"
+#include "ServerObserver.h"
+#include "LatencyStats.h"
 
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 
 namespace py = pybind11;
 using namespace Hanabi;
@@ -65,12 +79,12 @@ std::string get_botname() {
 }
 
 float get_search_thresh() {
-  return SearchBotParams::SEARCH_THRESH;
+  return RunParams::defaults().search.SEARCH_THRESH;
 }
 
 void set_search_thresh(float thresh) {
   std::cerr << "Set SEARCH_THRESH to " << thresh << std::endl;
-  SearchBotParams::SEARCH_THRESH = thresh;
+  RunParams::defaults().search.SEARCH_THRESH = thresh;
 }
 
 
@@ -110,111 +124,690 @@ std::vector<CardKnowledge> pybot_get_card_knowledge(const PyBot &pybot) {
 // Test harness code
 ////////////////////////////////////////////////////////////////////////////////
 
-struct Statistics {
-    int games;
-    int totalScore;
-    int scoreDistribution[26];
-    int mulligansUsed[4];
-};
-
-static void dump_stats(const std::vector<std::string>& botnames, Statistics stats)
-{
-    const double dgames = stats.games;
-    const int perfectGames = stats.scoreDistribution[25];
-
-    std::cout << "Over " << stats.games << " games, bots (";
-    for (size_t i = 0; i < botnames.size(); ++i) {
-        if (i > 0) std::cout << ", ";
-        std::cout << botnames[i];
-    }
-    std::cout << ") scored an average of "
-              << (stats.totalScore / dgames) << " points per game.\n";
-    if (perfectGames != 0) {
-        const double winRate = 100*(perfectGames / dgames);
-        std::cout << "  " << winRate << " percent were perfect games.\n";
-    }
-    if (stats.mulligansUsed[0] != stats.games) {
-        std::cout << "  Mulligans used: 0 (" << 100*(stats.mulligansUsed[0] / dgames)
-                  << "%); 1 (" << 100*(stats.mulligansUsed[1] / dgames)
-                  << "%); 2 (" << 100*(stats.mulligansUsed[2] / dgames)
-                  << "%); 3 (" << 100*(stats.mulligansUsed[3] / dgames) << "%).\n";
-    }
-}
-
 void eval_bot(
   std::vector<std::string> botnames,
   int games,
   int log_every,
   int seed,
-  int qa
+  int qa,
+  std::shared_ptr<ThreadPool> pool,
+  const RunParams *params,
+  const std::string &latency_json,
+  const std::string &transcript,
+  const std::string &trace_path,
+  const std::string &transcript_path,
+  int games_per_shard
 ) {
-    // special case slurm runs
-    if (seed < 0 && std::getenv("SLURM_PROCID")) {
-      // CAREFUL! make sure this doesn't wrap around and become negative
-      seed = (std::stol(std::getenv("SLURM_JOBID")) + std::stol(std::getenv("SLURM_PROCID")) * 102797) % 1000000000;
-      printf("Set seed from slurm to %d\n", seed);
+    // run search on the caller's pool instead of the default one
+    std::unique_ptr<ThreadPoolScope> poolScope;
+    if (pool) {
+      poolScope.reset(new ThreadPoolScope(pool.get()));
     }
-    if (seed <= 0) {
-        std::srand(std::time(NULL));
-        seed = std::rand();
+    // the server and every bot created below copy these params
+    RunParams runParams = params ? *params : RunParams::current();
+    RunParamsScope paramsScope(&runParams);
+
+    EvalOptions options;
+    options.botnames = botnames;
+    options.games = games;
+    options.logEvery = log_every;
+    options.seed = seed;
+    options.qa = qa;
+    options.latencyJson = latency_json;
+    options.transcript = transcript;
+    options.transcriptPath = transcript_path;
+    options.gamesPerShard = games_per_shard;
+    options.tracePath = trace_path;
+    evalBot(options);
+
+    if (!pool) {
+      Hanabi::getThreadPool().close();
     }
-    printf("--seed %d\n", seed);
+}
 
-    Statistics stats = {};
 
-    Hanabi::Server server;
-    server.setLog(&std::cerr);
-    std::vector<std::shared_ptr<Hanabi::BotFactory>> botFactories;
-    for (const auto& botname : botnames) {
-        botFactories.push_back(getBotFactory(botname));
+/* Clones per second of a bot in end-of-game state (i.e. with a full history
+ * of observations), averaged over several games (see benchmarkClone). */
+double benchmark_clone(const std::string &botname, int clones, int games, int players, int seed, bool keep) {
+    BenchResult result = benchmarkClone(botname, clones, games, players, seed, keep);
+    if (!result.skipped.empty()) {
+        throw std::runtime_error(result.skipped);
+    }
+    return result.rate();
+}
+
+
+/* Every ordered pairing of bots (defaultTournamentBots() if empty) on the
+ * caller's pool, or the default one (see runTournament). */
+TournamentResult run_tournament(std::vector<std::string> bots, int games, int players, int seed,
+                                bool self_play, std::shared_ptr<ThreadPool> pool, const RunParams *params) {
+    std::unique_ptr<ThreadPoolScope> poolScope;
+    if (pool) {
+      poolScope.reset(new ThreadPoolScope(pool.get()));
+    }
+    RunParams runParams = params ? *params : RunParams::current();
+    RunParamsScope paramsScope(&runParams);
+    TournamentSpec spec;
+    spec.bots = bots;
+    spec.games = games;
+    spec.players = players;
+    spec.seed = seed;
+    spec.selfPlay = self_play;
+    return runTournament(spec);
+}
+
+/* An A/B comparison of lineups on shared decks, on the caller's pool or
+ * the default one (see compareLineups). params: one per lineup, or none to
+ * use the caller's (or the process defaults) for all. */
+ComparisonResult compare_lineups(std::vector<std::vector<std::string>> lineups, int max_games,
+                                 int batch_games, int min_games, double confidence, bool early_stop,
+                                 int seed, std::shared_ptr<ThreadPool> pool, std::vector<RunParams> params) {
+    std::unique_ptr<ThreadPoolScope> poolScope;
+    if (pool) {
+      poolScope.reset(new ThreadPoolScope(pool.get()));
     }
-    int players = botnames.size();
+    ComparisonSpec spec;
+    spec.lineups = lineups;
+    spec.params = params;
+    spec.maxGames = max_games;
+    spec.batchGames = batch_games;
+    spec.minGames = min_games;
+    spec.confidence = confidence;
+    spec.earlyStop = early_stop;
+    spec.seed = seed;
+    return compareLineups(spec);
+}
 
+/* Games per second and mean score of a bot playing with copies of itself,
+ * without logging. */
+std::pair<double, double> benchmark_games(const std::string &botname, int games, int players, int seed) {
+    BenchResult result = benchmarkGames(botname, games, players, seed);
+    return std::make_pair(result.rate(), result.info.at("mean_score"));
+}
+
+/* Plays a seeded game of botname with copies of itself up to the given turn,
+ * then plays `branches` continuations of it in parallel (see forkGames).
+ * Returns the log of the shared prefix, and each branch's score and log. */
+std::tuple<std::string, std::vector<int>, std::vector<std::string>> fork_games(
+    const std::string &botname, int players, int turn, int branches, int seed, bool reshuffle, int qa) {
+    auto botFactory = getBotFactory(botname);  /* outlives the server's bots */
+    std::ostringstream log;
+    Hanabi::Server server;
+    server.setLog(&log);
     server.srand(seed);
     server.sqa(qa);
+    server.startGame(*botFactory, players);
+    server.runToTurn(turn);
+    ServerSnapshot snapshot = server.snapshot();
+    std::vector<std::string> logs;
+    std::vector<int> scores = forkGames(snapshot, branches, reshuffle, seed, &logs);
+    return std::make_tuple(log.str(), scores, logs);
+}
 
-    for (int i=0; i < games; ++i) {
-        std::vector<Hanabi::Bot*> bots;
-        for (int i = 0; i < players; ++i) {
-            bots.push_back(botFactories[i]->create(i, players, server.handSize()));
-        }
-        int score = server.runGame(bots, std::vector<Hanabi::Card>());
-        for (auto bot : bots) {
-            delete bot;
-        }
-        //std::cout << "botname: " << botname << std::endl;
-        std::cout << "Final score " << i << " : " << score << " bomb: "
-                  << (server.mulligansRemaining() == 0 ? 1 : 0) << std::endl;
-        assert(score == server.currentScore());
-        assert(0 <= server.mulligansUsed() && server.mulligansUsed() <= 3);
-        stats.games++;
-        stats.totalScore += score;
-        stats.scoreDistribution[score] += 1;
-        stats.mulligansUsed[server.mulligansUsed()] += 1;
-
-        if (i % log_every == 0) {
-          dump_stats(botnames, stats);
+/* Records `games` seeded games of botname with copies of itself. */
+std::vector<GameRecord> record_games(const std::string &botname, int games, int players, int seed) {
+    RecordingServer server;
+    server.setLog(nullptr);
+    server.srand(seed);
+    auto botFactory = getBotFactory(botname);
+    std::vector<GameRecord> records;
+    for (int g = 0; g < games; ++g) {
+        server.recordGame(*botFactory, players);
+        records.push_back(server.record());
+    }
+    return records;
+}
+
+/* Plays `games` seeded games of botname with copies of itself and qa
+ * questions, observed by a BinaryTraceObserver, a StatsObserver and a
+ * LatencyStats. Returns the trace, and the stats and latencies as JSON. */
+py::tuple observe_games(const std::string &botname, int games, int players, int seed, int qa) {
+    std::ostringstream trace;
+    auto stats = std::make_shared<StatsObserver>();
+    LatencyStats latency;
+    {
+        py::gil_scoped_release release;
+        auto botFactory = getBotFactory(botname);  /* outlives the server's bots */
+        Hanabi::Server server;
+        server.setLog(nullptr);
+        server.addObserver(std::make_shared<BinaryTraceObserver>(&trace));
+        server.addObserver(stats);
+        server.setLatencyStats(&latency);
+        server.srand(seed);
+        server.sqa(qa);
+        for (int g = 0; g < games; ++g) {
+            server.runGame(*botFactory, players);
         }
     }
-    dump_stats(botnames, stats);
+    return py::make_tuple(py::bytes(trace.str()), stats->toJson(),
+                          latency.toJson(std::vector<std::string>(players, botname)));
+}
+
+/* Replays a record without running any bot, calling before_move(server, move)
+ * (if given) before each move. Returns the final score. */
+int replay_game(const GameRecord &record, py::object before_move) {
+    Hanabi::Server server;
+    server.setLog(nullptr);
+    ReplayCallback callback;
+    if (!before_move.is_none()) {
+        callback = [&](const Server &s, const Move &move) {
+            before_move(py::cast(&s, py::return_value_policy::reference), move);
+        };
+    }
+    return replayGame(server, record, callback);
+}
+
+/* The events of a record as tokens (see TokenObserver), as seen by seat, or
+ * by everyone if seat < 0. */
+std::vector<int> record_tokens(const GameRecord &record, int seat) {
+    Hanabi::Server server;
+    server.setLog(nullptr);
+    auto tokens = std::make_shared<TokenObserver>(seat);
+    server.addObserver(tokens);
+    replayGame(server, record);
+    return tokens->tokens();
+}
+
+/* The text transcript of a record, as eval_bot logs it. */
+std::string record_transcript(const GameRecord &record) {
+    std::ostringstream log;
+    Hanabi::Server server;
+    server.setLog(&log);
+    replayGame(server, record);
+    return log.str();
+}
+
+/* What botname, observing from each seat, knew before every move of record:
+ * an int8 array [move][seat][player][slot][feature] that owns the trace's
+ * buffer rather than a copy of it. */
+py::array_t<int8_t> hand_knowledge(const GameRecord &record, const std::string &botname) {
+    auto botFactory = getBotFactory(botname);
+    std::unique_ptr<HandKnowledgeTrace> trace(new HandKnowledgeTrace);
+    {
+        py::gil_scoped_release release;
+        *trace = traceHandKnowledge(record, *botFactory);
+    }
+    const ssize_t moves = record.moves.size();
+    const ssize_t players = trace->numPlayers;
+    const ssize_t handSize = trace->handSize;
+    int8_t *data = trace->data.data();
+    py::capsule owner(trace.release(), [](void *p) { delete static_cast<HandKnowledgeTrace*>(p); });
+    return py::array_t<int8_t>({moves, players, players, handSize, (ssize_t)NUM_KNOWLEDGE_FEATURES}, data, owner);
+}
+
+
+/* The observation and legal-move mask of the agent seat about to move. */
+std::tuple<py::array_t<float>, py::array_t<float>> env_observation(const HanabiEnv &env) {
+    py::array_t<float> obs(env.observationSize());
+    py::array_t<float> mask(env.numMoves());
+    env.writeObservation(obs.mutable_data());
+    env.writeLegalMask(mask.mutable_data());
+    return std::make_tuple(obs, mask);
+}
+
+/* Steps env and returns (observation, legal_mask, reward, done). */
+template<class MoveT>
+py::tuple env_step(HanabiEnv &env, MoveT move) {
+    int reward;
+    {
+        py::gil_scoped_release release;
+        reward = env.step(move);
+    }
+    auto obs = env_observation(env);
+    return py::make_tuple(std::get<0>(obs), std::get<1>(obs), reward, env.done());
+}
+
+py::tuple vec_env_reset(HanabiVecEnv &env) {
+    py::array_t<float> obs({(ssize_t)env.size(), (ssize_t)env.observationSize()});
+    py::array_t<float> masks({(ssize_t)env.size(), (ssize_t)env.numMoves()});
+    float *obsData = obs.mutable_data();
+    float *masksData = masks.mutable_data();
+    {
+        py::gil_scoped_release release;
+        env.reset(obsData, masksData);
+    }
+    return py::make_tuple(obs, masks);
+}
+
+/* Steps every game; returns stacked (observations, legal_masks, rewards,
+ * dones, scores), scores being the final score of the games that ended. */
+py::tuple vec_env_step(HanabiVecEnv &env, py::array_t<int, py::array::c_style | py::array::forcecast> moves) {
+    if (moves.ndim() != 1 || moves.shape(0) != env.size()) {
+        throw std::runtime_error("step() needs one move index per game.");
+    }
+    const ssize_t n = env.size();
+    py::array_t<float> obs({n, (ssize_t)env.observationSize()});
+    py::array_t<float> masks({n, (ssize_t)env.numMoves()});
+    py::array_t<int> rewards(n);
+    py::array_t<bool> dones(n);
+    py::array_t<int> scores(n);
+    const int *movesData = moves.data();
+    float *obsData = obs.mutable_data();
+    float *masksData = masks.mutable_data();
+    int *rewardsData = rewards.mutable_data();
+    bool *donesData = dones.mutable_data();
+    int *scoresData = scores.mutable_data();
+    {
+        py::gil_scoped_release release;
+        env.step(movesData, obsData, masksData, rewardsData, donesData, scoresData);
+    }
+    return py::make_tuple(obs, masks, rewards, dones, scores);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Thread pool configuration
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPoolConfig make_thread_pool_config(int threads, const std::string &scheduler,
+                                         std::vector<int> cores, bool suspend) {
+  ThreadPoolConfig config(threads > 0 ? threads : RunParams::defaults().hanabi.FIBER_THREADS);
+  config.scheduler = parseFiberScheduler(scheduler);
+  config.cores = cores;
+  config.suspend = suspend;
+  return config;
+}
+
+void configure_thread_pool(int threads, const std::string &scheduler,
+                           std::vector<int> cores, bool suspend) {
+  configureThreadPool(make_thread_pool_config(threads, scheduler, cores, suspend));
+}
+
+ThreadPoolStats thread_pool_stats() {
+  return getDefaultThreadPool()->stats();
+}
+
+#ifdef TORCHBOT
+py::object inference_stats(std::shared_ptr<ThreadPool> pool) {
+  InferenceStats stats;
+  if (!getInferenceStats(pool ? *pool : *getDefaultThreadPool(), &stats)) {
+    return py::none();
+  }
+  return py::cast(stats);
+}
 
-    Hanabi::getThreadPool().close();
+py::object hidden_state_stats(const std::string &dtype) {
+  HiddenStateStats stats;
+  if (!getHiddenStateStats(dtype.empty() ? RunParams::defaults().torch.TORCHBOT_HIDDEN_DTYPE : dtype, &stats)) {
+    return py::none();
+  }
+  return py::cast(stats);
 }
+#endif
 
 
 
 PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
 
   // test harness code
-  // FIXME: make params configurable not just through env vars
   m.def("eval_bot", &eval_bot,
     py::arg("botnames"),
     py::arg("games")=1000,
     py::arg("log_every")=100,
     py::arg("seed")=-1,
-    py::arg("qa")
+    py::arg("qa"),
+    py::arg("pool")=py::none(),
+    py::arg("params")=py::none(),
+    py::arg("latency_json")="",
+    py::arg("transcript")="text",
+    py::arg("trace_path")="",
+    py::arg("transcript_path")="",
+    py::arg("games_per_shard")=100000,
+    py::call_guard<py::gil_scoped_release>()
+  );
+
+  m.def("benchmark_clone", &benchmark_clone,
+    "Bot clones per second, measured on bots at the end of each game.",
+    py::arg("botname"),
+    py::arg("clones")=100000,
+    py::arg("games")=10,
+    py::arg("players")=2,
+    py::arg("seed")=1,
+    py::arg("keep")=false,
+    py::call_guard<py::gil_scoped_release>()
+  );
+
+  m.def("fork_games", &fork_games,
+    "(prefix log, branch scores, branch logs) of a game played up to a turn and then continued several times.",
+    py::arg("botname"),
+    py::arg("players")=2,
+    py::arg("turn")=20,
+    py::arg("branches")=10,
+    py::arg("seed")=1,
+    py::arg("reshuffle")=true,
+    py::arg("qa")=0,
+    py::call_guard<py::gil_scoped_release>()
+  );
+
+  m.def("count_divergent_copies", &countDivergentCopies,
+    "Games of botname that play out differently when every bot is replaced by a copy of itself "
+    "before every turn: its clone, or with restore a new bot restored from its saved state.",
+    py::arg("botname"),
+    py::arg("games")=10,
+    py::arg("players")=2,
+    py::arg("seed")=1,
+    py::arg("restore")=false,
+    py::call_guard<py::gil_scoped_release>()
+  );
+
+  m.def("record_games", &record_games,
+    "Records seeded games of a bot playing with copies of itself, as GameRecords.",
+    py::arg("botname"),
+    py::arg("games")=1,
+    py::arg("players")=2,
+    py::arg("seed")=1,
+    py::call_guard<py::gil_scoped_release>()
+  );
+
+  m.def("observe_games", &observe_games,
+    "Plays seeded games of a bot with copies of itself and qa questions; returns their binary "
+    "trace, and their StatsObserver and LatencyStats as JSON.",
+    py::arg("botname"),
+    py::arg("games")=10,
+    py::arg("players")=2,
+    py::arg("seed")=1,
+    py::arg("qa")=0
+  );
+
+  m.def("replay_game", &replay_game,
+    "Replays a GameRecord without running any bot, calling before_move(server, move) before each move.",
+    py::arg("record"),
+    py::arg("before_move")=py::none()
+  );
+
+  m.def("record_tokens", &record_tokens,
+    "The events of a GameRecord as integer tokens (see TokenObserver in ServerObserver.h), "
+    "with the cards of seat hidden, or none if seat < 0.",
+    py::arg("record"),
+    py::arg("seat")=-1
+  );
+  m.attr("TOKEN_VOCAB_SIZE") = (int)TokenObserver::VOCAB_SIZE;
+
+  m.def("record_transcript", &record_transcript,
+    "The text transcript of a GameRecord, as eval_bot logs it.",
+    py::arg("record")
+  );
+
+  m.def("hand_knowledge", &hand_knowledge,
+    "What botname, observing from each seat, knew before every move of a GameRecord: "
+    "an int8 array [move][seat][player][slot][feature] of KNOWLEDGE_NO/MAYBE/YES.",
+    py::arg("record"),
+    py::arg("botname")
+  );
+  m.attr("KNOWLEDGE_NO") = (int)KNOWLEDGE_NO;
+  m.attr("KNOWLEDGE_MAYBE") = (int)KNOWLEDGE_MAYBE;
+  m.attr("KNOWLEDGE_YES") = (int)KNOWLEDGE_YES;
+  m.attr("KNOWLEDGE_COLOR") = (int)KNOWLEDGE_COLOR;
+  m.attr("KNOWLEDGE_VALUE") = (int)KNOWLEDGE_VALUE;
+  m.attr("KNOWLEDGE_PLAYABLE") = (int)KNOWLEDGE_PLAYABLE;
+  m.attr("KNOWLEDGE_VALUABLE") = (int)KNOWLEDGE_VALUABLE;
+  m.attr("KNOWLEDGE_WORTHLESS") = (int)KNOWLEDGE_WORTHLESS;
+
+  m.def("benchmark_games", &benchmark_games,
+    "(games per second, mean score) of a bot playing with copies of itself.",
+    py::arg("botname"),
+    py::arg("games")=1000,
+    py::arg("players")=2,
+    py::arg("seed")=1,
+    py::call_guard<py::gil_scoped_release>()
+  );
+
+  py::class_<PairingResult>(m, "PairingResult")
+    .def_readonly("row", &PairingResult::row)
+    .def_readonly("col", &PairingResult::col)
+    .def_readonly("scores", &PairingResult::scores)
+    .def_readonly("bombs", &PairingResult::bombs)
+    .def("mean", &PairingResult::mean)
+    .def("stderr", &PairingResult::standardError)
+  ;
+  py::class_<TournamentResult>(m, "TournamentResult")
+    .def_readonly("bots", &TournamentResult::bots)
+    .def_readonly("pairings", &TournamentResult::pairings)
+    .def_readonly("seconds", &TournamentResult::seconds)
+    .def("paired_difference", &TournamentResult::pairedDifference,
+      "(mean, stderr) of the score of pairing (a, b) minus that of (c, d), game by game.")
+    .def("table", &TournamentResult::table)
+    .def("to_json", &TournamentResult::toJson)
+  ;
+  m.def("run_tournament", &run_tournament,
+    "Plays every ordered pairing of bots (seat 0 vs the other seats), with the same decks for every pairing.",
+    py::arg("bots")=std::vector<std::string>(),
+    py::arg("games")=1000,
+    py::arg("players")=2,
+    py::arg("seed")=1,
+    py::arg("self_play")=true,
+    py::arg("pool")=py::none(),
+    py::arg("params")=py::none(),
+    py::call_guard<py::gil_scoped_release>()
+  );
+
+  py::class_<ComparisonResult>(m, "ComparisonResult")
+    .def_readonly("lineups", &ComparisonResult::lineups)
+    .def_readonly("scores", &ComparisonResult::scores)
+    .def_readonly("games", &ComparisonResult::games)
+    .def_readonly("stopped_early", &ComparisonResult::stoppedEarly)
+    .def_readonly("z", &ComparisonResult::z)
+    .def_readonly("seconds", &ComparisonResult::seconds)
+    .def("mean", &ComparisonResult::mean)
+    .def("difference", &ComparisonResult::difference,
+      "(mean, stderr) of the lineup's score minus the baseline's, game by game.")
+    .def("interval", &ComparisonResult::interval)
+    .def("table", &ComparisonResult::table)
+    .def("to_json", &ComparisonResult::toJson)
+  ;
+  m.def("compare_lineups", &compare_lineups,
+    "Plays every lineup on the same decks, in batches, until each differs from lineups[0] with the given confidence or max_games.",
+    py::arg("lineups"),
+    py::arg("max_games")=10000,
+    py::arg("batch_games")=100,
+    py::arg("min_games")=100,
+    py::arg("confidence")=0.95,
+    py::arg("early_stop")=true,
+    py::arg("seed")=1,
+    py::arg("pool")=py::none(),
+    py::arg("params")=std::vector<RunParams>(),
+    py::call_guard<py::gil_scoped_release>()
   );
 
+  py::class_<DatasetSpec>(m, "DatasetSpec")
+    .def(py::init<>())
+    .def_readwrite("bot_pairs", &DatasetSpec::botPairs)
+    .def_readwrite("qa_kinds", &DatasetSpec::qaKinds)
+    .def_readwrite("stratify", &DatasetSpec::stratify)
+    .def_readwrite("per_cell", &DatasetSpec::perCell)
+    .def_readwrite("cell_quotas", &DatasetSpec::cellQuotas)
+    .def_readwrite("cards_remaining_edges", &DatasetSpec::cardsRemainingEdges)
+    .def_readwrite("max_games_per_sample", &DatasetSpec::maxGamesPerSample)
+    .def_readwrite("seed", &DatasetSpec::seed)
+    .def_readwrite("out_dir", &DatasetSpec::outDir)
+    .def_readwrite("gzip", &DatasetSpec::gzip)
+    .def_readwrite("games_per_shard", &DatasetSpec::gamesPerShard)
+  ;
+  py::class_<DatasetResult>(m, "DatasetResult")
+    .def_readonly("games", &DatasetResult::games)
+    .def_readonly("accepted", &DatasetResult::accepted)
+    .def_readonly("counts", &DatasetResult::counts)
+    .def_readonly("targets", &DatasetResult::targets)
+    .def_readonly("given_up", &DatasetResult::givenUp)
+    .def_readonly("seconds", &DatasetResult::seconds)
+    .def("filled", &DatasetResult::filled)
+    .def("to_json", &DatasetResult::toJson)
+  ;
+  m.def("generate_dataset", &generateDataset,
+    "Plays question games until the quotas of a DatasetSpec are filled, keeping only the samples they need.",
+    py::arg("spec"),
+    py::call_guard<py::gil_scoped_release>()
+  );
+
+  // runtime parameters; the environment variables only provide the defaults
+  m.def("get_params", []() { return RunParams::defaults(); },
+    "Returns a copy of the default params.");
+  m.def("set_params", [](const RunParams &params) { RunParams::defaults() = params; },
+    "Replaces the default params used by games that are not given explicit params.");
+
+  py::class_<HanabiParams::Config>(m, "HanabiParams")
+    .def(py::init<>())
+    .def_readwrite("BOMB0", &HanabiParams::Config::BOMB0)
+    .def_readwrite("BOMBD", &HanabiParams::Config::BOMBD)
+    .def_readwrite("FIBER_THREADS", &HanabiParams::Config::FIBER_THREADS)
+    .def_readwrite("NUM_THREADS", &HanabiParams::Config::NUM_THREADS)
+    .def_readwrite("HAND_SIZE_OVERRIDE", &HanabiParams::Config::HAND_SIZE_OVERRIDE)
+  ;
+
+  py::class_<SearchBotParams::Config>(m, "SearchBotParams")
+    .def(py::init<>())
+    .def_readwrite("BPBOT", &SearchBotParams::Config::BPBOT)
+    .def_readwrite("SEARCH_PLAYER", &SearchBotParams::Config::SEARCH_PLAYER)
+    .def_readwrite("SEARCH_ALL", &SearchBotParams::Config::SEARCH_ALL)
+    .def_readwrite("SEARCH_THRESH", &SearchBotParams::Config::SEARCH_THRESH)
+    .def_readwrite("SEARCH_N", &SearchBotParams::Config::SEARCH_N)
+    .def_readwrite("DOUBLE_SEARCH", &SearchBotParams::Config::DOUBLE_SEARCH)
+    .def_readwrite("PARTNER_UNIFORM_UNC", &SearchBotParams::Config::PARTNER_UNIFORM_UNC)
+    .def_readwrite("PARTNER_BOLTZMANN_UNC", &SearchBotParams::Config::PARTNER_BOLTZMANN_UNC)
+    .def_readwrite("OPTIMIZE_WINS", &SearchBotParams::Config::OPTIMIZE_WINS)
+    .def_readwrite("UCB", &SearchBotParams::Config::UCB)
+    .def_readwrite("SEARCH_BASELINE", &SearchBotParams::Config::SEARCH_BASELINE)
+    .def_readwrite("DELAYED_OBS_THRESH", &SearchBotParams::Config::DELAYED_OBS_THRESH)
+    .def_readwrite("SEARCH_PROFILE_JSON", &SearchBotParams::Config::SEARCH_PROFILE_JSON)
+    .def_readwrite("SEARCH_LOG", &SearchBotParams::Config::SEARCH_LOG)
+  ;
+
+  py::class_<JointSearchBotParams::Config>(m, "JointSearchBotParams")
+    .def(py::init<>())
+    .def_readwrite("RANGE_MAX", &JointSearchBotParams::Config::RANGE_MAX)
+    .def_readwrite("JOINT_SEARCH_SEED", &JointSearchBotParams::Config::JOINT_SEARCH_SEED)
+    .def_readwrite("MEMOIZE_RANGE_SEARCH", &JointSearchBotParams::Config::MEMOIZE_RANGE_SEARCH)
+  ;
+
+  py::class_<TorchBotParams::Config>(m, "TorchBotParams")
+    .def(py::init<>())
+    .def_readwrite("TORCHBOT_MODEL", &TorchBotParams::Config::TORCHBOT_MODEL)
+    .def_readwrite("TORCHBOT_DEVICE", &TorchBotParams::Config::TORCHBOT_DEVICE)
+    .def_readwrite("TORCHBOT_BATCH_SIZE", &TorchBotParams::Config::TORCHBOT_BATCH_SIZE)
+    .def_readwrite("TORCHBOT_MAX_DELAY_US", &TorchBotParams::Config::TORCHBOT_MAX_DELAY_US)
+    .def_readwrite("TORCHBOT_INTRAOP_THREADS", &TorchBotParams::Config::TORCHBOT_INTRAOP_THREADS)
+    .def_readwrite("TORCHBOT_HIDDEN_DTYPE", &TorchBotParams::Config::TORCHBOT_HIDDEN_DTYPE)
+  ;
+
+  py::class_<RunParams>(m, "RunParams")
+    .def(py::init<>())
+    .def_readwrite("hanabi", &RunParams::hanabi)
+    .def_readwrite("search", &RunParams::search)
+    .def_readwrite("joint", &RunParams::joint)
+    .def_readwrite("torch", &RunParams::torch)
+  ;
+
+  // fiber thread pools
+  m.def("configure_thread_pool", &configure_thread_pool,
+    "Replace the default fiber pool. threads<=0 means FIBER_THREADS.",
+    py::arg("threads")=-1,
+    py::arg("scheduler")="shared",
+    py::arg("cores")=std::vector<int>(),
+    py::arg("suspend")=false
+  );
+  m.def("thread_pool_stats", &thread_pool_stats);
+
+  py::class_<ThreadPoolStats>(m, "ThreadPoolStats")
+    .def_readonly("threads", &ThreadPoolStats::threads)
+    .def_readonly("scheduler", &ThreadPoolStats::scheduler)
+    .def_readonly("enqueued", &ThreadPoolStats::enqueued)
+    .def_readonly("completed", &ThreadPoolStats::completed)
+    .def_readonly("steals", &ThreadPoolStats::steals)
+    .def_readonly("pending", &ThreadPoolStats::pending)
+    .def_readonly("running", &ThreadPoolStats::running)
+    .def_readonly("queue_depth", &ThreadPoolStats::queueDepth)
+    .def_readonly("max_queue_depth", &ThreadPoolStats::maxQueueDepth)
+  ;
+
+  // an independent pool, e.g. one per concurrent eval_bot call
+  py::class_<ThreadPool, std::shared_ptr<ThreadPool>>(m, "ThreadPool")
+    .def(py::init([](int threads, const std::string &scheduler, std::vector<int> cores, bool suspend) {
+        return std::make_shared<ThreadPool>(make_thread_pool_config(threads, scheduler, cores, suspend));
+      }),
+      py::arg("threads")=-1,
+      py::arg("scheduler")="shared",
+      py::arg("cores")=std::vector<int>(),
+      py::arg("suspend")=false)
+    .def("stats", &ThreadPool::stats)
+    .def("close", &ThreadPool::close, py::call_guard<py::gil_scoped_release>())
+  ;
+
+  // TorchBot batched inference
+  py::class_<InferenceStats>(m, "InferenceStats")
+    .def_readonly("device", &InferenceStats::device)
+    .def_readonly("batch_size", &InferenceStats::batchSize)
+    .def_readonly("max_delay_us", &InferenceStats::maxDelayUs)
+    .def_readonly("intra_op_threads", &InferenceStats::intraOpThreads)
+    .def_readonly("batches", &InferenceStats::batches)
+    .def_readonly("inferences", &InferenceStats::inferences)
+    .def_readonly("mean_batch_fill", &InferenceStats::meanBatchFill)
+    .def_readonly("inferences_per_sec", &InferenceStats::inferencesPerSec)
+    .def_readonly("wait_secs", &InferenceStats::waitSecs)
+    .def_readonly("forward_secs", &InferenceStats::forwardSecs)
+  ;
+  py::class_<HiddenStateStats>(m, "HiddenStateStats")
+    .def_readonly("dtype", &HiddenStateStats::dtype)
+    .def_readonly("state_bytes", &HiddenStateStats::stateBytes)
+    .def_readonly("live", &HiddenStateStats::live)
+    .def_readonly("peak_live", &HiddenStateStats::peakLive)
+    .def_readonly("capacity", &HiddenStateStats::capacity)
+    .def_readonly("bytes", &HiddenStateStats::bytes)
+    .def_readonly("peak_bytes", &HiddenStateStats::peakBytes)
+  ;
+#ifdef TORCHBOT
+  m.def("inference_stats", &inference_stats,
+    "Stats of the TorchBot model loaded by the pool (default pool if None), or None.",
+    py::arg("pool")=py::none());
+  m.def("hidden_state_stats", &hidden_state_stats,
+    "Memory used by TorchBot hidden states of the given dtype (default TORCHBOT_HIDDEN_DTYPE), or None.",
+    py::arg("dtype")="");
+#endif
+
+  // SearchBot profiling
+  py::class_<MemoryReport>(m, "MemoryReport")
+    .def_readonly("hand_dist_entries", &MemoryReport::handDistEntries)
+    .def_readonly("hand_dist_bytes", &MemoryReport::handDistBytes)
+    .def_readonly("partner_bots", &MemoryReport::partnerBots)
+    .def_readonly("partner_bot_bytes", &MemoryReport::partnerBotBytes)
+    .def_readonly("delayed_observations", &MemoryReport::delayedObservations)
+    .def_readonly("delayed_obs_bytes", &MemoryReport::delayedObsBytes)
+    .def_readonly("interned_hands", &MemoryReport::internedHands)
+    .def_readonly("interned_hand_bytes", &MemoryReport::internedHandBytes)
+    .def_readonly("hidden_state_bytes", &MemoryReport::hiddenStateBytes)
+    .def_readonly("rss_bytes", &MemoryReport::rssBytes)
+    .def_readonly("peak_rss_bytes", &MemoryReport::peakRssBytes)
+    .def("range_bytes", &MemoryReport::rangeBytes)
+    .def("to_json", &MemoryReport::toJson)
+  ;
+  py::class_<SearchProfile>(m, "SearchProfile")
+    .def_readonly("moves", &SearchProfile::moves)
+    .def_readonly("range_init_secs", &SearchProfile::rangeInitSecs)
+    .def_readonly("belief_secs", &SearchProfile::beliefSecs)
+    .def_readonly("draw_update_secs", &SearchProfile::drawUpdateSecs)
+    .def_readonly("hint_filter_secs", &SearchProfile::hintFilterSecs)
+    .def_readonly("action_filter_secs", &SearchProfile::actionFilterSecs)
+    .def_readonly("delayed_obs_secs", &SearchProfile::delayedObsSecs)
+    .def_readonly("search_secs", &SearchProfile::searchSecs)
+    .def_readonly("barrier_wait_secs", &SearchProfile::barrierWaitSecs)
+    .def_readonly("rollouts", &SearchProfile::rollouts)
+    .def_readonly("rollouts_pruned", &SearchProfile::rolloutsPruned)
+    .def_readonly("bot_clones", &SearchProfile::botClones)
+    .def_readonly("range_size", &SearchProfile::rangeSize)
+    .def_readonly("peak_range_size", &SearchProfile::peakRangeSize)
+    .def_readonly("memory", &SearchProfile::memory)
+    .def("to_json", &SearchProfile::toJson)
+  ;
+  py::class_<SearchGameProfile>(m, "SearchGameProfile")
+    .def_readonly("player", &SearchGameProfile::player)
+    .def_readonly("num_players", &SearchGameProfile::numPlayers)
+    .def_readonly("total", &SearchGameProfile::total)
+    .def_readonly("moves", &SearchGameProfile::moves)
+    .def("to_json", &SearchGameProfile::toJson)
+  ;
+  m.def("search_profiles", &getSearchProfiles,
+    "SearchBot profiles of the most recent games, oldest first; clear=True forgets them.",
+    py::arg("clear")=false);
+  m.def("peak_rss_bytes", &peakRssBytes, "Largest resident set size of the process so far.");
+
   // GUI interface code
   m.def("start_game", &start_game, py::return_value_policy::reference,
       py::arg("botname"),
@@ -247,6 +840,7 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
   ;
 
   py::class_<Card>(m, "Card")
+    .def(py::init<Color, int>(), py::arg("color"), py::arg("value"))
     .def_readwrite("color", &Card::color)
     .def_readwrite("value", &Card::value)
     .def("__repr__", &Card::toString)
@@ -263,6 +857,65 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
     .def("__repr__", &Move::toString)
   ;
 
+  py::class_<GameRecord>(m, "GameRecord")
+    .def(py::init<>())
+    .def_readwrite("numPlayers", &GameRecord::numPlayers)
+    .def_readwrite("deck", &GameRecord::deck)
+    .def_readwrite("moves", &GameRecord::moves)
+    .def_readwrite("score", &GameRecord::score)
+  ;
+
+  py::class_<HanabiEnv>(m, "HanabiEnv")
+    .def(py::init([](std::vector<std::string> seats, int seed, const RunParams *params) {
+        return new HanabiEnv(seats, seed, params ? *params : RunParams::current());
+      }),
+      "One entry per seat: '' for a seat played through step(), or the name of the bot that plays it.",
+      py::arg("seats")=std::vector<std::string>{"", ""},
+      py::arg("seed")=1,
+      py::arg("params")=py::none())
+    .def("reset", [](HanabiEnv &env, int seed) {
+        { py::gil_scoped_release release; env.reset(seed); }
+        return env_observation(env);
+      },
+      "Deals the next game; returns (observation, legal_mask).",
+      py::arg("seed")=-1)
+    .def("step", &env_step<int>,
+      "Makes the move with this index; returns (observation, legal_mask, reward, done).",
+      py::arg("move"))
+    .def("step", &env_step<const Move &>, py::arg("move"))
+    .def("observation", &env_observation)
+    .def("legal_moves", &HanabiEnv::legalMoves)
+    .def("server", &HanabiEnv::server, py::return_value_policy::reference_internal)
+    .def_property_readonly("done", &HanabiEnv::done)
+    .def_property_readonly("score", &HanabiEnv::score)
+    .def_property_readonly("active_player", &HanabiEnv::activePlayer)
+    .def_property_readonly("num_moves", &HanabiEnv::numMoves)
+    .def_property_readonly("observation_size", &HanabiEnv::observationSize)
+  ;
+
+  py::class_<HanabiVecEnv>(m, "HanabiVecEnv")
+    .def(py::init([](int numEnvs, std::vector<std::string> seats, int seed, bool parallel, const RunParams *params) {
+        return new HanabiVecEnv(numEnvs, seats, seed, parallel, params ? *params : RunParams::current());
+      }),
+      "num_envs HanabiEnvs, seeded seed, seed+1, ...; parallel steps them on the thread pool.",
+      py::arg("num_envs"),
+      py::arg("seats")=std::vector<std::string>{"", ""},
+      py::arg("seed")=1,
+      py::arg("parallel")=true,
+      py::arg("params")=py::none())
+    .def("reset", &vec_env_reset,
+      "Deals every game again; returns stacked (observations, legal_masks).")
+    .def("step", &vec_env_step,
+      "Makes moves[i] in game i, dealing finished games again; "
+      "returns stacked (observations, legal_masks, rewards, dones, scores).",
+      py::arg("moves"))
+    .def("env", &HanabiVecEnv::env, py::return_value_policy::reference_internal)
+    .def_property_readonly("num_envs", &HanabiVecEnv::size)
+    .def_property_readonly("num_moves", &HanabiVecEnv::numMoves)
+    .def_property_readonly("observation_size", &HanabiVecEnv::observationSize)
+    .def("__len__", &HanabiVecEnv::size)
+  ;
+
   py::class_<PyBot>(m, "PyBot")
     .def("wait", &PyBot::wait)
     .def("obs", [](PyBot& bot) { return bot.obs_; })
@@ -0,0 +1,141 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+/* The benchmark suite as a standalone executable (python setup.py
+ * build_native), e.g.
+ *
+ *   build_native/hanabi_bench --json bench.json --filter selfplay/
+ *
+ * prints a table of results to stderr and their JSON (see
+ * benchResultsToJson) to stdout or to the --json file. */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <functional>
+#include "Benchmark.h"
+#include "Hanabi.h"
+
+using namespace Hanabi;
+
+namespace {
+
+/* bots that only make sense in their own benchmarks or need a model */
+bool isBlueprintBot(const std::string &botname) {
+  return botname != "SearchBot" && botname != "JointSearchBot" && botname != "TorchBot";
+}
+
+void usage(const char *argv0) {
+  std::cerr << "usage: " << argv0 << " [options]\n"
+            << "  --json PATH        write the results to PATH instead of stdout\n"
+            << "  --filter SUBSTR    only run benchmarks whose name contains SUBSTR\n"
+            << "  --players N        players per game (default 2)\n"
+            << "  --seed N           seed of every game (default 1)\n"
+            << "  --games N          self-play games per bot (default 200)\n"
+            << "  --clones N         clones per game, over 10 games (default 10000)\n"
+            << "  --syncs N          SimulServer::sync calls (default 100000)\n"
+            << "  --turn N           turn at which sync and search are measured (default 10)\n"
+            << "  --reps N           repetitions of each belief filter (default 10)\n"
+            << "  --search_n N       rollouts of the measured search (default 1000;\n"
+            << "                     at least NUM_THREADS)\n"
+            << "  --hand_size N      hand size for the search benchmarks (default 3;\n"
+            << "                     a 5-card initial range takes several GB)\n"
+            << "  --requests N       Batcher requests per producer (default 1000)\n";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string jsonPath, filter;
+  int players = 2, seed = 1, games = 200, clones = 10000, syncs = 100000;
+  int turn = 10, reps = 10, searchN = 1000, handSize = 3, requests = 1000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return 0;
+    }
+    if (i + 1 == argc) {
+      usage(argv[0]);
+      return 1;
+    }
+    const char *value = argv[++i];
+    if (arg == "--json") jsonPath = value;
+    else if (arg == "--filter") filter = value;
+    else if (arg == "--players") players = atoi(value);
+    else if (arg == "--seed") seed = atoi(value);
+    else if (arg == "--games") games = atoi(value);
+    else if (arg == "--clones") clones = atoi(value);
+    else if (arg == "--syncs") syncs = atoi(value);
+    else if (arg == "--turn") turn = atoi(value);
+    else if (arg == "--reps") reps = atoi(value);
+    else if (arg == "--search_n") searchN = atoi(value);
+    else if (arg == "--hand_size") handSize = atoi(value);
+    else if (arg == "--requests") requests = atoi(value);
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<BenchResult> results;
+  auto run = [&](const std::string &name, std::function<std::vector<BenchResult>()> bench) {
+    if (name.find(filter) == std::string::npos) return;
+    for (const BenchResult &result : bench()) {
+      if (result.skipped.empty()) {
+        std::cerr << result.name << ": " << result.rate() << " " << result.unit << "/sec" << std::endl;
+      } else {
+        std::cerr << result.name << ": skipped (" << result.skipped << ")" << std::endl;
+      }
+      results.push_back(result);
+    }
+  };
+
+  std::vector<std::string> botnames;
+  for (const std::string &botname : getBotNames()) {
+    if (isBlueprintBot(botname)) botnames.push_back(botname);
+  }
+  for (const std::string &botname : botnames) {
+    run("selfplay/" + botname, [&]() {
+      return std::vector<BenchResult>{benchmarkGames(botname, games, players, seed)};
+    });
+  }
+  for (const std::string &botname : botnames) {
+    run("clone/" + botname, [&]() {
+      return std::vector<BenchResult>{benchmarkClone(botname, clones, 10, players, seed, false)};
+    });
+  }
+  run("simulserver_sync/SmartBot", [&]() {
+    return std::vector<BenchResult>{benchmarkSync("SmartBot", syncs, players, turn, seed)};
+  });
+
+  RunParams params = RunParams::current();
+  params.hanabi.HAND_SIZE_OVERRIDE = handSize;
+  params.search.SEARCH_N = searchN;
+  run("search/rollouts search/hint_filter search/action_filter", [&]() {
+    RunParamsScope scope(&params);
+    return benchmarkSearch(players, turn, reps, seed);
+  });
+
+  run("batcher", [&]() {
+    return std::vector<BenchResult>{benchmarkBatcher(requests, 2 * params.torch.TORCHBOT_BATCH_SIZE, params.torch.TORCHBOT_BATCH_SIZE)};
+  });
+
+  const std::string json = benchResultsToJson(results);
+  if (jsonPath.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream out(jsonPath);
+    out << json;
+    if (!out) {
+      std::cerr << "Could not write " << jsonPath << std::endl;
+      return 1;
+    }
+  }
+  getThreadPool().close();
+  return 0;
+}
@@ -0,0 +1,310 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+/* eval_bot, generate_dataset, tournament and compare as a standalone executable
+ * without Python or torch (python setup.py build_native), e.g.
+ *
+ *   build_native/hanabi_eval eval SmartBot SmartBot --games 1000 --transcript none
+ *   build_native/hanabi_eval eval SmartBot SearchBot --games 10 --sweep SEARCH_N=100,1000
+ *   build_native/hanabi_eval dataset SmartBot,SmartBot SmartBot,HolmesBot --out_dir data
+ *   build_native/hanabi_eval tournament AdaptBot SignalBot --games 1000 --json scores.json
+ *   build_native/hanabi_eval compare SmartBot,SearchBot SmartBot,SearchBot --set_lineup 1:SEARCH_N=1000
+ *
+ * Parameters default to their environment variables, as for the Python
+ * bindings; --set NAME=VALUE overrides one for the run. */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include "Comparison.h"
+#include "Dataset.h"
+#include "EvalBot.h"
+#include "Hanabi.h"
+#include "Tournament.h"
+
+using namespace Hanabi;
+
+namespace {
+
+std::vector<std::string> split(const std::string &s, char sep) {
+  std::vector<std::string> parts;
+  std::istringstream in(s);
+  std::string part;
+  while (std::getline(in, part, sep)) {
+    if (!part.empty()) parts.push_back(part);
+  }
+  return parts;
+}
+
+void assign(int *field, const std::string &value) { *field = std::stoi(value); }
+void assign(float *field, const std::string &value) { *field = std::stof(value); }
+void assign(std::string *field, const std::string &value) { *field = value; }
+
+/* Sets the RunParams field of that name, as its environment variable would. */
+void setParam(RunParams *params, const std::string &name, const std::string &value) {
+#define PARAM(group, NAME) if (name == #NAME) return assign(&params->group.NAME, value);
+  PARAM(hanabi, BOMB0) PARAM(hanabi, BOMBD) PARAM(hanabi, FIBER_THREADS)
+  PARAM(hanabi, NUM_THREADS) PARAM(hanabi, HAND_SIZE_OVERRIDE)
+  PARAM(search, BPBOT) PARAM(search, SEARCH_PLAYER) PARAM(search, SEARCH_ALL)
+  PARAM(search, SEARCH_THRESH) PARAM(search, SEARCH_N) PARAM(search, DOUBLE_SEARCH)
+  PARAM(search, PARTNER_UNIFORM_UNC) PARAM(search, PARTNER_BOLTZMANN_UNC)
+  PARAM(search, OPTIMIZE_WINS) PARAM(search, UCB) PARAM(search, SEARCH_BASELINE)
+  PARAM(search, DELAYED_OBS_THRESH) PARAM(search, SEARCH_PROFILE_JSON) PARAM(search, SEARCH_LOG)
+  PARAM(joint, RANGE_MAX) PARAM(joint, JOINT_SEARCH_SEED) PARAM(joint, MEMOIZE_RANGE_SEARCH)
+  PARAM(torch, TORCHBOT_MODEL) PARAM(torch, TORCHBOT_DEVICE) PARAM(torch, TORCHBOT_BATCH_SIZE)
+  PARAM(torch, TORCHBOT_MAX_DELAY_US) PARAM(torch, TORCHBOT_INTRAOP_THREADS)
+  PARAM(torch, TORCHBOT_HIDDEN_DTYPE)
+#undef PARAM
+  throw std::runtime_error("Unknown parameter " + name);
+}
+
+void usage(const char *argv0) {
+  std::cerr << "usage: " << argv0 << " eval BOT... [options]\n"
+            << "  --games N            (default 1000)\n"
+            << "  --log_every N        (default 100)\n"
+            << "  --seed N             (default -1: random)\n"
+            << "  --qa N               ask a question of kind N (see Server::sqa)\n"
+            << "  --latency_json PATH\n"
+            << "  --transcript MODE    text (stderr), gzip or none (default text)\n"
+            << "  --transcript_path P  prefix of the gzip shards\n"
+            << "  --games_per_shard N  (default 100000)\n"
+            << "  --trace PATH         binary trace of every game\n"
+            << "  --sweep NAME=V1,V2   evaluate once per value of a parameter\n"
+            << "\n"
+            << "usage: " << argv0 << " dataset BOT,BOT... --out_dir DIR [options]\n"
+            << "  --qa K,K             question kinds (default 2)\n"
+            << "  --stratify D,D       of bots, question, answer, cards_remaining (default bots,answer)\n"
+            << "  --per_cell N         (default 1000)\n"
+            << "  --quota CELL=N       target of one cell, e.g. bots=SmartBot+SmartBot,answer=Yes=500\n"
+            << "  --edges E,E          cards_remaining buckets (default 0,10,20,30)\n"
+            << "  --max_games_per_sample N  (default 50)\n"
+            << "  --seed N             (default 1)\n"
+            << "  --gzip               write gzip shards\n"
+            << "  --games_per_shard N  (default 100000)\n"
+            << "\n"
+            << "usage: " << argv0 << " tournament [BOT...] [options]\n"
+            << "  (no BOT: every registered bot but the search bots and TorchBot)\n"
+            << "  --games N            per pairing (default 1000)\n"
+            << "  --players N          (default 2)\n"
+            << "  --seed N             (default 1)\n"
+            << "  --no_self_play\n"
+            << "  --json PATH\n"
+            << "\n"
+            << "usage: " << argv0 << " compare BOT,BOT... BOT,BOT... [options]\n"
+            << "  (the first lineup is the baseline; every lineup plays the same decks)\n"
+            << "  --max_games N        (default 10000)\n"
+            << "  --batch_games N      games between stopping checks (default 100)\n"
+            << "  --min_games N        (default 100)\n"
+            << "  --confidence C       (default 0.95)\n"
+            << "  --no_early_stop      play max_games even once every interval excludes 0\n"
+            << "  --seed N             (default 1)\n"
+            << "  --set_lineup L:NAME=VALUE  override a parameter of lineup L only\n"
+            << "  --json PATH\n"
+            << "\n"
+            << "common options:\n"
+            << "  --set NAME=VALUE     override a parameter, e.g. --set SEARCH_N=1000\n";
+}
+
+/* Splits args into positionals and options, calling option(name, value)
+ * for each option; flags get an empty value. */
+std::vector<std::string> parseArgs(int argc, char **argv, const std::vector<std::string> &flags,
+                                   std::function<void(const std::string&, const std::string&)> option) {
+  std::vector<std::string> positional;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 2, "--") != 0) {
+      positional.push_back(arg);
+    } else if (std::find(flags.begin(), flags.end(), arg) != flags.end()) {
+      option(arg, "");
+    } else if (i + 1 < argc) {
+      option(arg, argv[++i]);
+    } else {
+      throw std::runtime_error("Missing value for " + arg);
+    }
+  }
+  return positional;
+}
+
+int runEval(int argc, char **argv, RunParams *params) {
+  EvalOptions options;
+  std::string sweepName;
+  std::vector<std::string> sweepValues;
+  options.botnames = parseArgs(argc, argv, {}, [&](const std::string &arg, const std::string &value) {
+    if (arg == "--games") options.games = std::stoi(value);
+    else if (arg == "--log_every") options.logEvery = std::stoi(value);
+    else if (arg == "--seed") options.seed = std::stoi(value);
+    else if (arg == "--qa") options.qa = std::stoi(value);
+    else if (arg == "--latency_json") options.latencyJson = value;
+    else if (arg == "--transcript") options.transcript = value;
+    else if (arg == "--transcript_path") options.transcriptPath = value;
+    else if (arg == "--games_per_shard") options.gamesPerShard = std::stoi(value);
+    else if (arg == "--trace") options.tracePath = value;
+    else if (arg == "--sweep") {
+      sweepName = value.substr(0, value.find('='));
+      sweepValues = split(value.substr(value.find('=') + 1), ',');
+    }
+    else if (arg == "--set") setParam(params, value.substr(0, value.find('=')), value.substr(value.find('=') + 1));
+    else throw std::runtime_error("Unknown option " + arg);
+  });
+  if (options.botnames.empty()) {
+    throw std::runtime_error("eval needs the bot of each seat");
+  }
+  if (sweepName.empty()) {
+    RunParamsScope scope(params);
+    evalBot(options);
+    return 0;
+  }
+  std::vector<std::pair<std::string, double>> means;
+  for (const std::string &value : sweepValues) {
+    RunParams swept = *params;
+    setParam(&swept, sweepName, value);
+    RunParamsScope scope(&swept);
+    std::cout << "=== " << sweepName << "=" << value << std::endl;
+    means.emplace_back(value, evalBot(options));
+  }
+  for (const auto &mean : means) {
+    std::cout << sweepName << "=" << mean.first << ": mean score " << mean.second << "\n";
+  }
+  return 0;
+}
+
+int runDataset(int argc, char **argv, RunParams *params) {
+  DatasetSpec spec;
+  auto pairs = parseArgs(argc, argv, {"--gzip"}, [&](const std::string &arg, const std::string &value) {
+    if (arg == "--qa") {
+      spec.qaKinds.clear();
+      for (const auto &qa : split(value, ',')) spec.qaKinds.push_back(std::stoi(qa));
+    }
+    else if (arg == "--stratify") spec.stratify = split(value, ',');
+    else if (arg == "--per_cell") spec.perCell = std::stol(value);
+    else if (arg == "--quota") spec.cellQuotas[value.substr(0, value.rfind('='))] = std::stol(value.substr(value.rfind('=') + 1));
+    else if (arg == "--edges") {
+      spec.cardsRemainingEdges.clear();
+      for (const auto &edge : split(value, ',')) spec.cardsRemainingEdges.push_back(std::stoi(edge));
+    }
+    else if (arg == "--max_games_per_sample") spec.maxGamesPerSample = std::stoi(value);
+    else if (arg == "--seed") spec.seed = std::stoi(value);
+    else if (arg == "--out_dir") spec.outDir = value;
+    else if (arg == "--gzip") spec.gzip = true;
+    else if (arg == "--games_per_shard") spec.gamesPerShard = std::stoi(value);
+    else if (arg == "--set") setParam(params, value.substr(0, value.find('=')), value.substr(value.find('=') + 1));
+    else throw std::runtime_error("Unknown option " + arg);
+  });
+  for (const auto &pair : pairs) {
+    spec.botPairs.push_back(split(pair, ','));
+  }
+  if (spec.outDir.empty()) {
+    throw std::runtime_error("dataset needs --out_dir");
+  }
+  RunParamsScope scope(params);
+  DatasetResult result = generateDataset(spec);
+  std::cout << "Kept " << result.accepted << " of " << result.games << " games in "
+            << result.seconds << " s.\n";
+  for (const auto &cell : result.givenUp) {
+    std::cout << "  Gave up on " << cell << ": " << result.counts.at(cell) << " of "
+              << result.targets.at(cell) << ".\n";
+  }
+  return 0;
+}
+
+int runTournamentCommand(int argc, char **argv, RunParams *params) {
+  TournamentSpec spec;
+  std::string jsonPath;
+  spec.bots = parseArgs(argc, argv, {"--no_self_play"}, [&](const std::string &arg, const std::string &value) {
+    if (arg == "--games") spec.games = std::stoi(value);
+    else if (arg == "--players") spec.players = std::stoi(value);
+    else if (arg == "--seed") spec.seed = std::stoi(value);
+    else if (arg == "--no_self_play") spec.selfPlay = false;
+    else if (arg == "--json") jsonPath = value;
+    else if (arg == "--set") setParam(params, value.substr(0, value.find('=')), value.substr(value.find('=') + 1));
+    else throw std::runtime_error("Unknown option " + arg);
+  });
+  RunParamsScope scope(params);
+  TournamentResult result = runTournament(spec);
+  std::cout << result.table() << "in " << result.seconds << " s.\n";
+  if (!jsonPath.empty()) {
+    std::ofstream out(jsonPath);
+    out << result.toJson() << std::endl;
+    if (!out) {
+      throw std::runtime_error("Could not write " + jsonPath);
+    }
+  }
+  return 0;
+}
+
+int runCompare(int argc, char **argv, RunParams *params) {
+  ComparisonSpec spec;
+  std::string jsonPath;
+  std::vector<std::string> lineupSets;
+  auto lineups = parseArgs(argc, argv, {"--no_early_stop"}, [&](const std::string &arg, const std::string &value) {
+    if (arg == "--max_games") spec.maxGames = std::stoi(value);
+    else if (arg == "--batch_games") spec.batchGames = std::stoi(value);
+    else if (arg == "--min_games") spec.minGames = std::stoi(value);
+    else if (arg == "--confidence") spec.confidence = std::stod(value);
+    else if (arg == "--no_early_stop") spec.earlyStop = false;
+    else if (arg == "--seed") spec.seed = std::stoi(value);
+    else if (arg == "--set_lineup") lineupSets.push_back(value);
+    else if (arg == "--json") jsonPath = value;
+    else if (arg == "--set") setParam(params, value.substr(0, value.find('=')), value.substr(value.find('=') + 1));
+    else throw std::runtime_error("Unknown option " + arg);
+  });
+  for (const auto &lineup : lineups) {
+    spec.lineups.push_back(split(lineup, ','));
+  }
+  /* --set applies to every lineup, --set_lineup after it to one */
+  spec.params.assign(spec.lineups.size(), *params);
+  for (const auto &value : lineupSets) {
+    const size_t colon = value.find(':');
+    const size_t eq = value.find('=');
+    const int lineup = std::stoi(value.substr(0, colon));
+    if (colon == std::string::npos || eq == std::string::npos || lineup < 0 || lineup >= spec.params.size()) {
+      throw std::runtime_error("Bad --set_lineup " + value);
+    }
+    setParam(&spec.params[lineup], value.substr(colon + 1, eq - colon - 1), value.substr(eq + 1));
+  }
+  RunParamsScope scope(params);
+  ComparisonResult result = compareLineups(spec);
+  std::cout << result.table() << "in " << result.seconds << " s.\n";
+  if (!jsonPath.empty()) {
+    std::ofstream out(jsonPath);
+    out << result.toJson() << std::endl;
+    if (!out) {
+      throw std::runtime_error("Could not write " + jsonPath);
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::string command = argc > 1 ? argv[1] : "";
+  if (command == "" || command == "-h" || command == "--help") {
+    usage(argv[0]);
+    return command == "" ? 1 : 0;
+  }
+  RunParams params = RunParams::current();
+  int status = 0;
+  try {
+    if (command == "eval") status = runEval(argc, argv, &params);
+    else if (command == "dataset") status = runDataset(argc, argv, &params);
+    else if (command == "tournament") status = runTournamentCommand(argc, argv, &params);
+    else if (command == "compare") status = runCompare(argc, argv, &params);
+    else {
+      usage(argv[0]);
+      status = 1;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << argv[0] << " " << command << ": " << e.what() << std::endl;
+    status = 1;
+  }
+  /* the pool's threads must stop before static destruction */
+  getThreadPool().close();
+  return status;
+}
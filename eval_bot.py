@@ -6,10 +6,13 @@
 # This source code is licensed under the license found in the
 # LICENSE file in the root directory of this source tree.
 
-import torch  # make sure to dynamically load everything beforee loading hanabi_lib
 import argparse
-# torch.ops.load_library("hanabi_lib.so")
-import hanabi_lib
+try:
+    import hanabi_lib
+except ImportError:
+    # built with TorchBot, hanabi_lib links libtorch, which torch loads
+    import torch
+    import hanabi_lib
 
 """
 This is a very thing wrapper that just runs a C++ executable,
@@ -29,12 +32,42 @@ if __name__ == "__main__":
     parser.add_argument('--seed', type=int, default=-1,
                         help="-1 means to pick a random seed")
     parser.add_argument('--qa', type=int, default=0)
+    parser.add_argument('--latency_json', default='',
+                        help="write move/observation/game latency histograms to this file as JSON")
+    parser.add_argument('--transcript', default='text', choices=['text', 'gzip', 'none'],
+                        help="text: log every move to stderr; gzip: to gzip shards "
+                             "(see --transcript_path); none: no log")
+    parser.add_argument('--transcript_path', default='',
+                        help="with --transcript gzip, write PREFIX-NNNNN.txt.gz shards and their "
+                             "PREFIX-NNNNN.idx indexes (read them with transcripts.py)")
+    parser.add_argument('--games_per_shard', type=int, default=100000)
+    parser.add_argument('--trace', default='',
+                        help="write a binary trace of every game to this file (see BinaryTraceRecord)")
+    parser.add_argument('--fiber_threads', type=int, default=-1,
+                        help="size of the search thread pool; -1 means FIBER_THREADS")
+    parser.add_argument('--fiber_scheduler', default='shared',
+                        choices=['shared', 'work_stealing'])
+    parser.add_argument('--fiber_cores', default='',
+                        help="comma-separated cores to pin the pool threads to")
+    parser.add_argument('--fiber_suspend', action='store_true',
+                        help="idle pool threads sleep instead of spinning")
 
     opt = parser.parse_args()
+    hanabi_lib.configure_thread_pool(
+        threads=opt.fiber_threads,
+        scheduler=opt.fiber_scheduler,
+        cores=[int(c) for c in opt.fiber_cores.split(',') if c],
+        suspend=opt.fiber_suspend
+    )
     hanabi_lib.eval_bot(
         opt.botnames,
         games=opt.games,
         log_every=opt.log_every,
         seed=opt.seed,
-        qa=opt.qa
+        qa=opt.qa,
+        latency_json=opt.latency_json,
+        transcript=opt.transcript,
+        trace_path=opt.trace,
+        transcript_path=opt.transcript_path,
+        games_per_shard=opt.games_per_shard
     )
\ No newline at end of file
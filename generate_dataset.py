@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+
+# Copyright (c) Facebook, Inc. and its affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+import argparse
+try:
+    import hanabi_lib
+except ImportError:
+    # built with TorchBot, hanabi_lib links libtorch, which torch loads
+    import torch
+    import hanabi_lib
+
+"""
+Generates a question dataset to quotas (see DatasetSpec in csrc/Dataset.h):
+games are steered to the cells still short of their target, and samples whose
+cell is full are dropped as they are made, instead of generating everything
+and stratifying afterwards. E.g.
+
+    python generate_dataset.py SmartBot,SmartBot SmartBot,HolmesBot --qa 2 \\
+        --stratify bots answer cards_remaining --per_cell 4000 --out_dir data
+
+writes data/SmartBot+SmartBot.txt, data/SmartBot+HolmesBot.txt and
+data/quotas.json.
+"""
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='quota-driven question dataset')
+    parser.add_argument('bot_pairs', nargs='+', help="comma-separated bots of each game, e.g. SmartBot,HolmesBot")
+    parser.add_argument('--qa', type=int, nargs='+', default=[2], help="question kinds, 1 to 5 as for eval_bot")
+    parser.add_argument('--stratify', nargs='*', default=['bots', 'answer'],
+                        choices=['bots', 'question', 'answer', 'cards_remaining'])
+    parser.add_argument('--per_cell', type=int, default=1000, help="samples wanted in each cell")
+    parser.add_argument('--quota', action='append', default=[],
+                        help="CELL=N overrides the target of one cell, e.g. 'bots=SmartBot+SmartBot,answer=Yes=500'")
+    parser.add_argument('--cards_remaining_edges', type=int, nargs='+', default=[0, 10, 20, 30])
+    parser.add_argument('--max_games_per_sample', type=int, default=50,
+                        help="give a cell up after this many games per sample wanted")
+    parser.add_argument('--seed', type=int, default=1,
+                        help="of the decks, the steering and the questions")
+    parser.add_argument('--out_dir', required=True)
+    parser.add_argument('--gzip', action='store_true', help="write gzip shards (see transcripts.py)")
+    parser.add_argument('--games_per_shard', type=int, default=100000)
+
+    opt = parser.parse_args()
+    spec = hanabi_lib.DatasetSpec()
+    spec.bot_pairs = [pair.split(',') for pair in opt.bot_pairs]
+    spec.qa_kinds = opt.qa
+    spec.stratify = opt.stratify
+    spec.per_cell = opt.per_cell
+    spec.cell_quotas = {q.rsplit('=', 1)[0]: int(q.rsplit('=', 1)[1]) for q in opt.quota}
+    spec.cards_remaining_edges = opt.cards_remaining_edges
+    spec.max_games_per_sample = opt.max_games_per_sample
+    spec.seed = opt.seed
+    spec.out_dir = opt.out_dir
+    spec.gzip = opt.gzip
+    spec.games_per_shard = opt.games_per_shard
+
+    result = hanabi_lib.generate_dataset(spec)
+    print(f"Kept {result.accepted} of {result.games} games ({100 * result.accepted / max(result.games, 1):.1f}%) "
+          f"in {result.seconds:.1f} s.")
+    for cell in result.given_up:
+        print(f"  Gave up on {cell}: {result.counts[cell]} of {result.targets[cell]}.")
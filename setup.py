@@ -6,12 +6,18 @@
 # This source code is licensed under the license found in the
 # LICENSE file in the root directory of this source tree.
 
-from setuptools import setup
-from torch.utils.cpp_extension import BuildExtension, CppExtension
+from setuptools import setup, Command
 import sys
 import os
 import shutil
 
+# build_native (the core library, hanabi_bench and hanabi_eval) does not need torch
+try:
+    from torch.utils.cpp_extension import BuildExtension, CppExtension
+    import torch.utils.cpp_extension
+except ImportError:
+    torch = None
+
 #Clean Build
 if os.path.exists('build/'):
     shutil.rmtree('build/')
@@ -19,39 +25,122 @@ if os.path.exists('hanabi_lib.egg-info/'):
     shutil.rmtree('hanabi_lib.egg-info/')
 
 OPTIONAL_SRC = []
+OPTIONAL_ARGS = []
 if int(os.environ.get("INSTALL_TORCHBOT", 0)):
     OPTIONAL_SRC = ["csrc/TorchBot.cc"]
+    OPTIONAL_ARGS = ["-DTORCHBOT=1"]
+if int(os.environ.get("SMARTBOT_CHECK_COUNTS", 0)):
+    # cross-check SmartBot's incremental tables against a full recount (slow)
+    OPTIONAL_ARGS = OPTIONAL_ARGS + ["-DSMARTBOT_CHECK_COUNTS=1"]
 
 boost_libs = ["boost_fiber", "boost_thread", "boost_context"]
 if sys.platform == "darwin":
     boost_libs = [lib + '-mt' for lib in boost_libs]
 
+# everything but the Python bindings
+SOURCES = [
+    "csrc/SimpleBot.cc",
+    "csrc/HolmesBot.cc",
+    "csrc/SmartBot.cc",
+    "csrc/SearchBot.cc",
+    #"csrc/JointSearchBot.cc",
+    "csrc/CheatBot.cc",
+    "csrc/InfoBot.cc",
+    "csrc/BlindBot.cc",
+    "csrc/ValueBot.cc",
+    "csrc/MetaBot.cc",
+    "csrc/SignalBot.cc",
+    "csrc/AdaptBot.cc",
+    "csrc/PileBot.cc",
+    "csrc/HanabiServer.cc",
+    "csrc/ServerObserver.cc",
+    "csrc/TranscriptWriter.cc",
+    "csrc/BotUtils.cc",
+    "csrc/Replay.cc",
+    "csrc/HanabiEnv.cc",
+    "csrc/Benchmark.cc",
+    "csrc/Dataset.cc",
+    "csrc/Tournament.cc",
+    "csrc/Comparison.cc",
+    "csrc/EvalBot.cc",
+] + OPTIONAL_SRC
+COMPILE_ARGS = ['-fPIC', '-std=c++17', '-Wno-deprecated', '-O3', '-Wno-sign-compare', '-D_GLIBCXX_USE_CXX11_ABI=0', '-DCARD_ID=1'] + OPTIONAL_ARGS
+LIBRARIES = ['z'] + boost_libs
+LIBRARY_DIRS = ['/opt/homebrew/lib']
+INCLUDE_DIRS = ['csrc', '/opt/homebrew/include']
+
+
+class BuildNative(Command):
+    """Builds the core library without the Python bindings,
+    build_native/libhanabi_core.a, and the executables linked against it:
+    build_native/hanabi_bench (benchmarks) and build_native/hanabi_eval
+    (eval_bot, generate_dataset and tournament). Torch is linked only with
+    INSTALL_TORCHBOT=1."""
+    description = "build libhanabi_core.a, hanabi_bench and hanabi_eval"
+    user_options = []
+
+    def initialize_options(self):
+        pass
+
+    def finalize_options(self):
+        pass
+
+    def run(self):
+        from distutils.ccompiler import new_compiler
+        from distutils.sysconfig import customize_compiler
+        compiler = new_compiler()
+        customize_compiler(compiler)
+        libraries = LIBRARIES
+        library_dirs = LIBRARY_DIRS
+        include_dirs = INCLUDE_DIRS
+        if OPTIONAL_SRC:
+            # TorchBot and the Batcher benchmark need libtorch
+            libraries = libraries + ['c10', 'torch', 'torch_cpu']
+            library_dirs = library_dirs + torch.utils.cpp_extension.library_paths()
+            include_dirs = include_dirs + torch.utils.cpp_extension.include_paths()
+        objects = compiler.compile(
+            SOURCES,
+            output_dir='build_native',
+            include_dirs=include_dirs,
+            extra_preargs=COMPILE_ARGS + ['-UNDEBUG'])
+        compiler.create_static_lib(objects, 'hanabi_core', output_dir='build_native')
+        core = compiler.library_filename('hanabi_core', output_dir='build_native')
+        # bots register themselves from static initializers, which the linker
+        # would otherwise drop as unreferenced
+        if sys.platform == "darwin":
+            whole_core = ['-Wl,-force_load,' + core]
+        else:
+            whole_core = ['-Wl,--whole-archive', core, '-Wl,--no-whole-archive']
+        for main in ["hanabi_bench", "hanabi_eval"]:
+            main_objects = compiler.compile(
+                ["csrc/%s.cc" % main],
+                output_dir='build_native',
+                include_dirs=include_dirs,
+                extra_preargs=COMPILE_ARGS + ['-UNDEBUG'])
+            compiler.link_executable(
+                main_objects + whole_core, main,
+                output_dir='build_native',
+                libraries=libraries,
+                library_dirs=library_dirs,
+                runtime_library_dirs=library_dirs,
+                target_lang='c++')
+
+
+CMDCLASS = {"build_native": BuildNative}
+EXT_MODULES = []
+if torch is not None:
+    CMDCLASS["build_ext"] = BuildExtension
+    EXT_MODULES = [
+        CppExtension('hanabi_lib', ["csrc/extension.cc"] + SOURCES,
+        extra_compile_args=COMPILE_ARGS,
+        libraries=LIBRARIES,
+        library_dirs=LIBRARY_DIRS,
+        include_dirs=INCLUDE_DIRS,
+        undef_macros=['NDEBUG'])
+    ]
+
 setup(
     name='hanabi_lib',
-    ext_modules=[
-        CppExtension('hanabi_lib', [
-            "csrc/extension.cc",
-            "csrc/SimpleBot.cc",
-            "csrc/HolmesBot.cc",
-            "csrc/SmartBot.cc",
-            "csrc/SearchBot.cc",
-            #"csrc/JointSearchBot.cc",
-            "csrc/CheatBot.cc",
-            "csrc/InfoBot.cc",
-            "csrc/BlindBot.cc",
-            "csrc/ValueBot.cc",
-            "csrc/MetaBot.cc",
-            "csrc/SignalBot.cc",
-            "csrc/AdaptBot.cc",
-            "csrc/PileBot.cc",
-            "csrc/HanabiServer.cc",
-            "csrc/BotUtils.cc",
-        ] + OPTIONAL_SRC,
-        extra_compile_args=['-fPIC', '-std=c++17', '-Wno-deprecated', '-O3', '-Wno-sign-compare', '-D_GLIBCXX_USE_CXX11_ABI=0', '-DCARD_ID=1'],
-        libraries = ['z'] + boost_libs,
-        library_dirs=['/opt/homebrew/lib'],
-        include_dirs=['csrc', '/opt/homebrew/include'],
-        undef_macros=['NDEBUG'])
-    ],
-    cmdclass={"build_ext": BuildExtension},
+    ext_modules=EXT_MODULES,
+    cmdclass=CMDCLASS,
     )
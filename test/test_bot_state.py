@@ -0,0 +1,34 @@
+#  Copyright (c) Facebook, Inc. and its affiliates.
+#  All rights reserved.
+#
+#  This source code is licensed under the license found in the
+#  LICENSE file in the root directory of this source tree.
+
+import torch  # make sure to dynamically load everything beforee loading hanabi_lib
+from hanabi_lib import *
+
+"""
+Bot::saveState() / restoreState() round trips: a game where every bot is
+replaced before every turn by a new bot restored from its saved state must
+play out move for move like the game of the original bots.
+"""
+
+# the player counts to check; PileBot only plays 2-player games
+BOTS = {"SmartBot": (2, 3), "HolmesBot": (2, 3), "PileBot": (2,), "CheatBot": (2, 3)}
+
+
+def run():
+    for botname, player_counts in BOTS.items():
+        for players in player_counts:
+            divergent = count_divergent_copies(botname, games=20, players=players, restore=True)
+            assert divergent == 0, f"{botname}: {divergent} of 20 {players}-player games diverged"
+    try:
+        count_divergent_copies("ValueBot", games=1, restore=True)
+        assert False, "ValueBot cannot save its state"
+    except RuntimeError:
+        pass
+    print("OK")
+
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,56 @@
+#  Copyright (c) Facebook, Inc. and its affiliates.
+#  All rights reserved.
+#
+#  This source code is licensed under the license found in the
+#  LICENSE file in the root directory of this source tree.
+
+import torch  # make sure to dynamically load everything beforee loading hanabi_lib
+import argparse
+import threading
+# torch.ops.load_library("hanabi_lib.so")
+from hanabi_lib import *
+
+"""
+Stress test for bots that share no state between games: the same seeded games
+are played serially and then from several Python threads at once (the GIL is
+released while they run), and every thread must get the serial mean score.
+Optionally finishes with a short SearchBot game using the bot as blueprint.
+"""
+
+def run():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('botnames', nargs='*', default=["CheatBot"])
+    parser.add_argument('--games', type=int, default=300)
+    parser.add_argument('--threads', type=int, default=8)
+    parser.add_argument('--search_games', type=int, default=1)
+    opt = parser.parse_args()
+
+    for botname in opt.botnames:
+        for players in range(2, 6):
+            seeds = [players * 1000 + t for t in range(opt.threads)]
+            serial = [benchmark_games(botname, games=opt.games, players=players, seed=seed)[1]
+                      for seed in seeds]
+
+            parallel = [None] * opt.threads
+            def worker(t):
+                parallel[t] = benchmark_games(botname, games=opt.games, players=players, seed=seeds[t])[1]
+            threads = [threading.Thread(target=worker, args=(t,)) for t in range(opt.threads)]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+
+            assert parallel == serial, f"{botname} {players}p: {parallel} != {serial}"
+            print(f"{botname} {players}p: {opt.threads} threads x {opt.games} games OK "
+                  f"(mean score {sum(serial) / len(serial):.3f})")
+
+        if opt.search_games > 0:
+            params = get_params()
+            params.search.BPBOT = botname
+            params.search.SEARCH_N = 100
+            eval_bot(["SearchBot"] * 2, games=opt.search_games, qa=0, params=params)
+            print(f"SearchBot with {botname} blueprint OK")
+
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,37 @@
+#  Copyright (c) Facebook, Inc. and its affiliates.
+#  All rights reserved.
+#
+#  This source code is licensed under the license found in the
+#  LICENSE file in the root directory of this source tree.
+
+import torch  # make sure to dynamically load everything beforee loading hanabi_lib
+from hanabi_lib import *
+
+"""
+Clone throughput of the heuristic bots. SearchBot clones its blueprint for
+every rollout and every hand in the range, so this bounds search speed. A
+faster clone() must still copy everything: games where every bot is
+replaced by its clone before every turn must play out like the originals.
+"""
+
+BOTS = ["SmartBot", "HolmesBot", "InfoBot", "SignalBot"]
+
+
+def run():
+    for botname in BOTS:
+        divergent = count_divergent_copies(botname, games=20, players=2)
+        assert divergent == 0, f"{botname}: {divergent} of 20 games diverged when played by clones"
+        rollout = benchmark_clone(botname, clones=100000, games=10)
+        keep = benchmark_clone(botname, clones=100000, games=10, keep=True)
+        assert rollout > 0 and keep > 0
+        print(f"{botname}: {rollout:.0f} clones/sec (clone+delete), {keep:.0f} clones/sec (all kept)")
+    try:
+        benchmark_clone("ValueBot", clones=10, games=1)
+        assert False, "ValueBot does not implement clone()"
+    except RuntimeError:
+        pass
+    print("OK")
+
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,32 @@
+#  Copyright (c) Facebook, Inc. and its affiliates.
+#  All rights reserved.
+#
+#  This source code is licensed under the license found in the
+#  LICENSE file in the root directory of this source tree.
+
+import torch  # make sure to dynamically load everything beforee loading hanabi_lib
+from hanabi_lib import *
+
+"""
+Self-play throughput of the heuristic bots. Blueprint bots play out every
+search rollout, so games/sec bounds search speed; the mean score over the
+seeded games must not move, so that a speedup cannot change what the bot
+plays. Run with the default parameters (no HAND_SIZE_OVERRIDE or BOMB0 in
+the environment).
+"""
+
+GAMES, PLAYERS, SEED = 1000, 2, 1
+# mean scores of GAMES seeded self-play games
+EXPECTED = {"SmartBot": 22.993, "PileBot": 13.717}
+
+
+def run():
+    for botname, expected in EXPECTED.items():
+        rate, score = benchmark_games(botname, games=GAMES, players=PLAYERS, seed=SEED)
+        print(f"{botname}: {rate:.0f} games/sec, mean score {score:.3f}")
+        assert abs(score - expected) < 1e-9, f"{botname} now scores {score:.3f}, not {expected:.3f}"
+    print("OK")
+
+
+if __name__ == "__main__":
+    run()
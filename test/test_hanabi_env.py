@@ -0,0 +1,83 @@
+#  Copyright (c) Facebook, Inc. and its affiliates.
+#  All rights reserved.
+#
+#  This source code is licensed under the license found in the
+#  LICENSE file in the root directory of this source tree.
+
+import torch  # make sure to dynamically load everything beforee loading hanabi_lib
+import numpy as np
+from hanabi_lib import *
+
+"""
+HanabiEnv and HanabiVecEnv: reset and step shapes and masks, rewards that add
+up to the final score, the terminal state, determinism per seed, and params
+(BOMB0) reaching the games of a parallel vector env.
+"""
+
+def play(env, seed):
+    """Plays the first legal move until the game ends; returns the moves and the score."""
+    obs, mask = env.reset(seed)
+    assert obs.shape == (env.observation_size,) and mask.shape == (env.num_moves,)
+    moves, total = [], 0
+    while not env.done:
+        legal = np.flatnonzero(mask)
+        assert len(legal) == len(env.legal_moves()) > 0
+        obs, mask, reward, done = env.step(int(legal[0]))
+        moves.append(int(legal[0]))
+        total += reward
+        assert done == env.done
+    assert total == env.score, (total, env.score)
+    assert env.legal_moves() == [] and not mask.any()
+    try:
+        env.step(0)
+        assert False, "step after the end of the game"
+    except RuntimeError:
+        pass
+    return moves, env.score
+
+
+def test_env():
+    env = HanabiEnv(["", "SmartBot"], seed=1)
+    first = play(env, 7)
+    again = play(env, 7)
+    assert first == again, "the same seed must replay the same game"
+    assert play(HanabiEnv(["", "SmartBot"]), 7) == first
+
+
+def vec_scores(params, n=8, steps=100):
+    """Final scores of the games of a parallel vector env whose agent always
+    plays its first card, so that nearly every game bombs out."""
+    vec = HanabiVecEnv(num_envs=n, seats=["", "SmartBot"], seed=100, parallel=True, params=params)
+    obs, masks = vec.reset()
+    assert obs.shape == (n, vec.observation_size) and masks.shape == (n, vec.num_moves)
+    play_first = vec.env(0).server().sizeOfHandOfPlayer(0)  # discards come first, then plays
+    finished = []
+    for _ in range(steps):
+        assert masks[:, play_first].all()
+        moves = np.full(n, play_first, dtype=np.int32)
+        obs, masks, rewards, dones, scores = vec.step(moves)
+        assert (scores[~dones] == -1).all() and (scores[dones] >= 0).all()
+        assert masks.any(axis=1).all(), "a finished game must be dealt again at once"
+        finished += list(scores[dones])
+    assert finished
+    return finished
+
+
+def test_vec_env():
+    # the games run on the pool, and must all see the env's params
+    official = RunParams()
+    official.hanabi.BOMB0 = 1
+    assert all(score == 0 for score in vec_scores(official))
+    lenient = RunParams()
+    lenient.hanabi.BOMB0 = 0
+    assert any(score > 0 for score in vec_scores(lenient))
+
+
+def run():
+    test_env()
+    test_vec_env()
+    print("OK")
+
+
+if __name__ == "__main__":
+    run()
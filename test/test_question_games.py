@@ -0,0 +1,61 @@
+#  Copyright (c) Facebook, Inc. and its affiliates.
+#  All rights reserved.
+#
+#  This source code is licensed under the license found in the
+#  LICENSE file in the root directory of this source tree.
+
+import json
+import torch  # make sure to dynamically load everything beforee loading hanabi_lib
+import numpy as np
+from hanabi_lib import *
+
+"""
+Games that end on a question (qa 1 to 5) end like any other: the binary trace
+frames every game as its DEAL records, its moves, then GAME_END (here right
+after the QUESTION), and the StatsObserver and LatencyStats count every game.
+"""
+
+GAMES = 20
+# BinaryTraceRecord, see csrc/ServerObserver.h
+RECORD = np.dtype([("type", "u1"), ("player", "u1"), ("target", "u1"), ("slot", "u1"),
+                   ("color", "u1"), ("value", "u1"), ("turn", "u1"), ("deck", "u1")])
+DEAL, QUESTION, GAME_END = 0, 8, 9
+
+
+def games_of(trace):
+    """The records of each game of a trace, split after each GAME_END."""
+    records = np.frombuffer(trace, dtype=RECORD)
+    ends = np.flatnonzero(records["type"] == GAME_END)
+    assert len(ends) and ends[-1] == len(records) - 1, "the trace must end with GAME_END"
+    return np.split(records, ends[:-1] + 1)
+
+
+def test_question_games(qa):
+    trace, stats, latency = observe_games("SmartBot", games=GAMES, qa=qa)
+    games = games_of(trace)
+    assert len(games) == GAMES, (qa, len(games))
+    scores, asked = [], 0
+    for game in games:
+        types = list(game["type"])
+        assert types[0] == DEAL
+        # a game may end before its question round
+        if QUESTION in types:
+            assert types.count(QUESTION) == 1 and types[-2] == QUESTION, (qa, types[-3:])
+            assert game[-2]["target"] & 0x7f == qa
+            asked += 1
+        scores.append(int(game[-1]["value"]))
+    assert asked > GAMES // 2, (qa, asked)
+    stats = json.loads(stats)
+    assert stats["games"] == GAMES and stats["total_score"] == sum(scores)
+    assert sum(stats["scores"].values()) == GAMES
+    assert json.loads(latency)["game"]["count"] == GAMES
+
+
+def run():
+    for qa in (2, 5):
+        test_question_games(qa)
+    print("OK")
+
+
+if __name__ == "__main__":
+    run()
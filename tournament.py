@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+
+# Copyright (c) Facebook, Inc. and its affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+import argparse
+try:
+    import hanabi_lib
+except ImportError:
+    # built with TorchBot, hanabi_lib links libtorch, which torch loads
+    import torch
+    import hanabi_lib
+
+"""
+Round robin of ordered bot pairings in one process (see runTournament in
+csrc/Tournament.h): seat 0 plays the row bot and the other seats the column
+bot (a SearchBot row plays the seat that searches), and game g of every
+pairing is dealt the same deck. Prints the score matrix with standard
+errors, e.g.
+
+    python tournament.py AdaptBot SignalBot SmartBot --games 1000 --json scores.json
+"""
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='round-robin tournament')
+    parser.add_argument('bots', nargs='*',
+                        help="bots to pair; every registered bot but the search bots and TorchBot if none")
+    parser.add_argument('--games', type=int, default=1000, help="games per pairing")
+    parser.add_argument('--players', type=int, default=2)
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--no_self_play', action='store_true', help="skip the pairings of a bot with itself")
+    parser.add_argument('--json', default='', help="write the pairings' means and standard errors to this file")
+    parser.add_argument('--fiber_threads', type=int, default=-1,
+                        help="size of the thread pool the pairings run on; -1 means FIBER_THREADS")
+
+    opt = parser.parse_args()
+    pool = hanabi_lib.ThreadPool(threads=opt.fiber_threads) if opt.fiber_threads > 0 else None
+    result = hanabi_lib.run_tournament(
+        opt.bots,
+        games=opt.games,
+        players=opt.players,
+        seed=opt.seed,
+        self_play=not opt.no_self_play,
+        pool=pool
+    )
+    if pool:
+        pool.close()
+    print(result.table())
+    print(f"{len(result.bots) ** 2 - (len(result.bots) if opt.no_self_play else 0)} pairings "
+          f"of {opt.games} games in {result.seconds:.1f} s.")
+    if opt.json:
+        with open(opt.json, 'w') as f:
+            f.write(result.to_json() + "\n")
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+
+# Copyright (c) Facebook, Inc. and its affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+import glob
+import sys
+import zlib
+
+"""
+Reads back the gzip transcript shards that eval_bot --transcript gzip writes
+(see GzipTranscriptWriter in csrc/TranscriptWriter.h): <prefix>-NNNNN.txt.gz,
+one gzip member per game, each with an index <prefix>-NNNNN.idx of
+"offset length score" lines. Shards are independent, so they can be read in
+parallel, e.g. one shard per worker:
+
+    for text in iter_games(shard):
+        ...
+
+A shard is also an ordinary .gz file: zcat gives the usual "Start game" log.
+"""
+
+GZIP_WBITS = 16 + zlib.MAX_WBITS
+
+
+def shard_paths(prefix):
+    """The shards written with this prefix, in order."""
+    return sorted(glob.glob(glob.escape(prefix) + "-[0-9][0-9][0-9][0-9][0-9].txt.gz"))
+
+
+def index_path(shard):
+    return shard[:-len(".txt.gz")] + ".idx"
+
+
+def read_index(shard):
+    """[(offset, length, score)] of the games of a shard."""
+    with open(index_path(shard)) as f:
+        return [tuple(int(x) for x in line.split()) for line in f if line.strip()]
+
+
+def read_game(shard, offset, length):
+    """The transcript of the game at offset in shard (see read_index)."""
+    with open(shard, "rb") as f:
+        f.seek(offset)
+        return zlib.decompress(f.read(length), GZIP_WBITS).decode()
+
+
+def iter_games(shard, with_scores=False):
+    """Yields the transcript of each game of a shard (and its score, with
+    with_scores), inflating one game at a time."""
+    with open(shard, "rb") as f:
+        for offset, length, score in read_index(shard):
+            f.seek(offset)
+            text = zlib.decompress(f.read(length), GZIP_WBITS).decode()
+            yield (text, score) if with_scores else text
+
+
+def iter_all_games(prefix, with_scores=False):
+    """Yields every game of every shard of prefix, in order."""
+    for shard in shard_paths(prefix):
+        yield from iter_games(shard, with_scores)
+
+
+if __name__ == "__main__":
+    # usage: transcripts.py PREFIX  -- prints the shards' games and a summary
+    prefix = sys.argv[1]
+    games, total = 0, 0
+    for text, score in iter_all_games(prefix, with_scores=True):
+        sys.stdout.write(text)
+        games += 1
+        total += max(score, 0)
+    print(f"{games} games in {len(shard_paths(prefix))} shards, mean score {total / max(games, 1):.3f}",
+          file=sys.stderr)